@@ -0,0 +1,29 @@
+#include <benchmark/benchmark.h>
+
+#include <unet/detail/frame.hpp>
+#include <unet/detail/frame_pool.hpp>
+
+namespace unet {
+namespace detail {
+
+static void benchFrameHeap(benchmark::State& state) {
+  for (auto _ : state) {
+    auto f = Frame::makeUninitialized(state.range(0));
+    benchmark::DoNotOptimize(f->data);
+  }
+}
+
+static void benchFramePool(benchmark::State& state) {
+  FramePool pool{1'024 * 1'024};
+
+  for (auto _ : state) {
+    auto f = Frame::makeUninitialized(state.range(0), &pool);
+    benchmark::DoNotOptimize(f->data);
+  }
+}
+
+BENCHMARK(benchFrameHeap)->Arg(64)->Arg(1'500);
+BENCHMARK(benchFramePool)->Arg(64)->Arg(1'500);
+
+}  // namespace detail
+}  // namespace unet
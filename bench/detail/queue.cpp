@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include <unet/detail/frame_pool.hpp>
+#include <unet/detail/list_queue.hpp>
+#include <unet/detail/queue.hpp>
+
+namespace unet {
+namespace detail {
+
+// Pushes and then pops a burst of state.range(0) frames w/each iteration.
+template <typename Q>
+static void benchQueue(benchmark::State& state, Q& q) {
+  FramePool pool{1'024 * 1'024};
+  std::vector<FramePtr> frames;
+  for (auto i = 0; i < state.range(0); i++) {
+    frames.push_back(Frame::makeUninitialized(64, &pool));
+  }
+
+  for (auto _ : state) {
+    for (auto& f : frames) {
+      q.push(f);
+    }
+    for (auto& f : frames) {
+      f = q.pop();
+    }
+    benchmark::DoNotOptimize(frames.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void benchQueueRing(benchmark::State& state) {
+  Queue<> q{static_cast<std::size_t>(state.range(0))};
+  benchQueue(state, q);
+}
+
+static void benchQueueList(benchmark::State& state) {
+  ListQueue q{static_cast<std::size_t>(state.range(0))};
+  benchQueue(state, q);
+}
+
+BENCHMARK(benchQueueRing)->Arg(1)->Arg(32)->Arg(1'024);
+BENCHMARK(benchQueueList)->Arg(1)->Arg(32)->Arg(1'024);
+
+}  // namespace detail
+}  // namespace unet
@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <unet/detail/ring.hpp>
+
+namespace unet {
+namespace detail {
+
+constexpr std::size_t kRingLen = 1'024;
+
+// Moves frames through the ring in batches of state.range(0) frames. The
+// benchmark thread consumes while state.range(1) threads produce. The frames
+// are allocated up front and cycle between the consumer and the producers so
+// no frame is allocated or released while timing.
+template <typename Ring>
+static void benchRingThroughput(benchmark::State& state) {
+  auto batchLen = static_cast<std::size_t>(state.range(0));
+  auto producerNr = static_cast<std::size_t>(state.range(1));
+  Ring ring{kRingLen};
+  std::vector<std::unique_ptr<SpscRing>> returns;
+  std::atomic<bool> stop{false};
+
+  std::vector<std::thread> producers;
+  for (std::size_t p = 0; p < producerNr; p++) {
+    returns.push_back(std::make_unique<SpscRing>(kRingLen));
+    auto& back = *returns.back();
+    for (std::size_t i = 0; i < kRingLen / producerNr; i++) {
+      auto f = Frame::makeUninitialized(64);
+      back.push(f);
+    }
+
+    producers.emplace_back([&ring, &back, &stop, batchLen]() {
+      std::vector<FramePtr> fs(batchLen);
+      std::size_t held = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        held += back.pop(fs.data() + held, batchLen - held);
+        auto n = ring.push(fs.data(), held);
+        std::move(fs.begin() + n, fs.begin() + held, fs.begin());
+        held -= n;
+      }
+    });
+  }
+
+  std::vector<FramePtr> fs(batchLen);
+  std::size_t next = 0;
+  std::int64_t moved = 0;
+  for (auto _ : state) {
+    auto n = ring.pop(fs.data(), batchLen);
+    for (std::size_t i = 0; i < n; i++) {
+      benchmark::DoNotOptimize(fs[i]->data);
+
+      // Hand frames back round robin. Each return ring fits every frame.
+      returns[next++ % producerNr]->push(fs[i]);
+    }
+    moved += n;
+  }
+
+  stop = true;
+  for (auto& t : producers) {
+    t.join();
+  }
+  state.SetItemsProcessed(moved);
+}
+
+// Bounces a single frame between two threads and reports the round trip time.
+static void benchRingLatency(benchmark::State& state) {
+  SpscRing ping{kRingLen};
+  SpscRing pong{kRingLen};
+  std::atomic<bool> stop{false};
+
+  std::thread echo{[&]() {
+    while (!stop.load(std::memory_order_relaxed)) {
+      if (auto f = ping.pop()) {
+        pong.push(f);
+      }
+    }
+  }};
+
+  auto f = Frame::makeUninitialized(64);
+  for (auto _ : state) {
+    ping.push(f);
+    while (!(f = pong.pop())) {
+    }
+  }
+
+  stop = true;
+  echo.join();
+}
+
+BENCHMARK_TEMPLATE(benchRingThroughput, SpscRing)
+    ->Args({1, 1})
+    ->Args({32, 1})
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(benchRingThroughput, MpscRing)
+    ->Args({1, 1})
+    ->Args({32, 1})
+    ->Args({32, 2})
+    ->Args({32, 4})
+    ->UseRealTime();
+BENCHMARK(benchRingLatency)->UseRealTime();
+
+}  // namespace detail
+}  // namespace unet
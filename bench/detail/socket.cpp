@@ -12,7 +12,7 @@ static void benchSocketSetDispatch(benchmark::State& state) {
   SocketSet ss;
 
   for (int i = 0; i < kNumSockets; i++) {
-    auto s = new Socket{ss, 1, Queue::Policy::One, [](auto) {}};
+    auto s = new Socket{ss, 1, 1, [](auto) {}};
     s->subscribedEventMaskAdd(1);
     s->pendingEventMaskAdd(1);
   }
@@ -27,10 +27,10 @@ static void benchSocketSetDrainRoundRobin(benchmark::State& state) {
     state.PauseTiming();
 
     SocketSet ss;
-    auto q = std::make_unique<Queue>(kNumSockets);
+    auto q = std::make_unique<Queue<>>(kNumSockets);
 
     for (int i = 0; i < kNumSockets; i++) {
-      auto s = new Socket{ss, 1, Queue::Policy::One, [](auto) {}};
+      auto s = new Socket{ss, 1, 1, [](auto) {}};
       auto f = Frame::makeStr("What a beautiful frame...");
       s->sendFrame(f);
     }
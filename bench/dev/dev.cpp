@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <unet/dev/af_packet.hpp>
+#include <unet/dev/af_xdp.hpp>
+#include <unet/dev/shm_link.hpp>
+#include <unet/dev/tap.hpp>
+#include <unet/dev/udp_link.hpp>
+#include <unet/dev/uring_tap.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+// See scripts/tap.sh, scripts/mqtap.sh and scripts/veth.sh for setting up these
+// interfaces.
+constexpr auto kTapName = "tap0";
+constexpr auto kMultiQueueTapName = "mqtap0";
+constexpr auto kVethName = "veth0";
+constexpr auto kVethPeerName = "veth1";
+
+const SocketAddr kUdpLinkAddr{kLoopback, 47'201};
+const SocketAddr kUdpLinkPeerAddr{kLoopback, 47'202};
+
+constexpr auto kFrameLen = 64;
+constexpr auto kBatchLen = 32;
+
+template <typename D, typename... Args>
+static std::unique_ptr<Dev> makeDev(benchmark::State& state, Args... args) {
+  try {
+    return std::make_unique<D>(args...);
+  } catch (const Exception& ex) {
+    state.SkipWithError(ex.what());
+    return nullptr;
+  }
+}
+
+// Return a batch of minimum size frames w/an experimental Ethernet type.
+static std::vector<std::uint8_t> makeFrames() {
+  std::vector<std::uint8_t> frames(kFrameLen * kBatchLen);
+  for (auto p = frames.data(); p < frames.data() + frames.size();
+       p += kFrameLen) {
+    std::fill(p, p + 6, 0xff);
+    std::fill(p + 6, p + 12, 0x06);
+    p[12] = 0x88;
+    p[13] = 0xb5;
+  }
+  return frames;
+}
+
+static std::vector<DevBuf> makeBufs(std::vector<std::uint8_t>& frames) {
+  std::vector<DevBuf> bufs;
+  for (auto i = 0; i < kBatchLen; i++) {
+    bufs.push_back(DevBuf{frames.data() + i * kFrameLen, kFrameLen});
+  }
+  return bufs;
+}
+
+static void benchSend(benchmark::State& state, Dev* dev) {
+  if (!dev) {
+    return;
+  }
+
+  auto frames = makeFrames();
+  auto bufs = makeBufs(frames);
+  std::size_t sent = 0;
+
+  for (auto _ : state) {
+    sent += dev->sendBatch(bufs.data(), bufs.size());
+  }
+
+  state.SetItemsProcessed(sent);
+}
+
+// Injects frames w/a peer device and reads them back w/the device under test.
+static void benchRead(benchmark::State& state, Dev* dev, Dev* peer) {
+  if (!dev || !peer) {
+    return;
+  }
+
+  auto frames = makeFrames();
+  auto peerBufs = makeBufs(frames);
+  std::vector<DevBuf> bufs(kBatchLen);
+  std::vector<std::uint8_t> readFrames(dev->maxTransmissionUnit() * kBatchLen);
+  std::size_t read = 0;
+
+  for (auto _ : state) {
+    peer->sendBatch(peerBufs.data(), peerBufs.size());
+
+    std::size_t count;
+    do {
+      for (auto i = 0; i < kBatchLen; i++) {
+        bufs[i] = DevBuf{readFrames.data() + i * dev->maxTransmissionUnit(),
+                         dev->maxTransmissionUnit()};
+      }
+      read += (count = dev->readBatch(bufs.data(), bufs.size()));
+    } while (count == bufs.size());
+  }
+
+  state.SetItemsProcessed(read);
+}
+
+static void benchTapSend(benchmark::State& state) {
+  auto dev = makeDev<Tap>(state, kTapName);
+  benchSend(state, dev.get());
+}
+
+static void benchUringTapSend(benchmark::State& state) {
+  auto dev = makeDev<UringTap>(state, kTapName);
+  benchSend(state, dev.get());
+}
+
+static void benchMultiQueueTapSend(benchmark::State& state) {
+  // Each thread drives its own queue of the interface.
+  std::unique_ptr<Dev> dev;
+  try {
+    dev = std::move(Tap::makeQueues(kMultiQueueTapName, 1).front());
+  } catch (const Exception& ex) {
+    state.SkipWithError(ex.what());
+  }
+  benchSend(state, dev.get());
+}
+
+static void benchAfPacketSend(benchmark::State& state) {
+  auto dev = makeDev<AfPacket>(state, kVethName);
+  benchSend(state, dev.get());
+}
+
+static void benchAfXdpSend(benchmark::State& state) {
+  auto dev = makeDev<AfXdp>(state, kVethName, 0u);
+  benchSend(state, dev.get());
+}
+
+static void benchUdpLinkSend(benchmark::State& state) {
+  auto dev = makeDev<UdpLink>(state, kUdpLinkAddr,
+                              std::vector<SocketAddr>{kUdpLinkPeerAddr});
+  benchSend(state, dev.get());
+}
+
+static void benchTapRead(benchmark::State& state) {
+  // Frames sent on the kernel side of the TAP are read from the TAP fd.
+  auto dev = makeDev<Tap>(state, kTapName);
+  auto peer = makeDev<AfPacket>(state, kTapName);
+  benchRead(state, dev.get(), peer.get());
+}
+
+static void benchUringTapRead(benchmark::State& state) {
+  auto dev = makeDev<UringTap>(state, kTapName);
+  auto peer = makeDev<AfPacket>(state, kTapName);
+  benchRead(state, dev.get(), peer.get());
+}
+
+static void benchAfPacketRead(benchmark::State& state) {
+  auto dev = makeDev<AfPacket>(state, kVethName);
+  auto peer = makeDev<AfPacket>(state, kVethPeerName);
+  benchRead(state, dev.get(), peer.get());
+}
+
+static void benchAfXdpRead(benchmark::State& state) {
+  auto dev = makeDev<AfXdp>(state, kVethName, 0u);
+  auto peer = makeDev<AfPacket>(state, kVethPeerName);
+  benchRead(state, dev.get(), peer.get());
+}
+
+static void benchShmLinkRead(benchmark::State& state) {
+  auto link = ShmLink::makePair(kFrameLen);
+  benchRead(state, link.first.get(), link.second.get());
+}
+
+static void benchUdpLinkRead(benchmark::State& state) {
+  auto dev = makeDev<UdpLink>(state, kUdpLinkAddr,
+                              std::vector<SocketAddr>{kUdpLinkPeerAddr});
+  auto peer = makeDev<UdpLink>(state, kUdpLinkPeerAddr,
+                               std::vector<SocketAddr>{kUdpLinkAddr});
+  benchRead(state, dev.get(), peer.get());
+}
+
+BENCHMARK(benchTapSend);
+BENCHMARK(benchUringTapSend);
+BENCHMARK(benchMultiQueueTapSend)->ThreadRange(1, 4)->UseRealTime();
+BENCHMARK(benchAfPacketSend);
+BENCHMARK(benchAfXdpSend);
+BENCHMARK(benchUdpLinkSend);
+BENCHMARK(benchTapRead);
+BENCHMARK(benchUringTapRead);
+BENCHMARK(benchAfPacketRead);
+BENCHMARK(benchAfXdpRead);
+BENCHMARK(benchShmLinkRead);
+BENCHMARK(benchUdpLinkRead);
+
+}  // namespace unet
@@ -0,0 +1,217 @@
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <unet/dev/mem_link.hpp>
+#include <unet/dev/pcap_capture.hpp>
+#include <unet/dev/pcap_replay.hpp>
+#include <unet/raw_socket.hpp>
+#include <unet/stack.hpp>
+#include <unet/wire/arp.hpp>
+#include <unet/wire/ethernet.hpp>
+#include <unet/wire/icmpv4.hpp>
+#include <unet/wire/ipv4.hpp>
+
+namespace unet {
+
+constexpr std::size_t kMaxTransmissionUnit = 1'500;
+constexpr EthernetAddr kHwAddrA{{0x02, 0, 0, 0, 0, 0x01}};
+constexpr EthernetAddr kHwAddrB{{0x02, 0, 0, 0, 0, 0x02}};
+constexpr Ipv4Addr kIpv4AddrA{{10, 0, 0, 1}};
+constexpr Ipv4Addr kIpv4AddrB{{10, 0, 0, 2}};
+
+constexpr auto kBurstLen = 32;
+constexpr auto kPayloadLen = 56;
+constexpr auto kMaxSpins = 1'000;
+constexpr auto kReplayLen = 1'024;
+constexpr auto kReplayPath = "/tmp/unet-bench-replay.pcap";
+
+// Two stacks connected by an in-memory link.
+struct LinkedStacks {
+  LinkedStacks() {
+    auto link = MemLink::makePair(kMaxTransmissionUnit);
+    a = std::make_unique<Stack>(std::move(link.first), kHwAddrA,
+                                Ipv4AddrCidr{kIpv4AddrA, 24}, kIpv4AddrB);
+    b = std::make_unique<Stack>(std::move(link.second), kHwAddrB,
+                                Ipv4AddrCidr{kIpv4AddrB, 24}, kIpv4AddrA);
+  }
+
+  // Runs both stacks until f returns true. Return false if f does not return
+  // true in a reasonable number of loops.
+  template <typename F>
+  bool runUntil(F&& f) {
+    for (auto spins = 0; spins < kMaxSpins; spins++) {
+      a->runLoopOnce();
+      b->runLoopOnce();
+      if (f()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::unique_ptr<Stack> a;
+  std::unique_ptr<Stack> b;
+};
+
+// Return an ICMPv4 echo request from A to B.
+static std::vector<std::uint8_t> makeEcho() {
+  std::vector<std::uint8_t> buf(sizeof(Ipv4Header) + sizeof(Icmpv4Header) +
+                                kPayloadLen);
+
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(buf.data());
+  ipv4->ihl = 5;
+  ipv4->version = 4;
+  ipv4->len = hostToNet<std::uint16_t>(buf.size());
+  ipv4->ttl = 64;
+  ipv4->proto = ipv4_proto::kIcmp;
+  ipv4->srcAddr = kIpv4AddrA;
+  ipv4->dstAddr = kIpv4AddrB;
+  ipv4->checksum = checksumIpv4(ipv4);
+
+  auto icmp = reinterpret_cast<Icmpv4Header*>(buf.data() + sizeof(Ipv4Header));
+  icmp->type = 8;
+  icmp->code = 0;
+  icmp->checksum = checksumIcmpv4(icmp, kPayloadLen);
+  return buf;
+}
+
+// Pings B from a raw IPv4 socket on A in bursts. This covers ARP lookups, IPv4
+// routing and the ICMPv4 echo responder.
+static void benchStackPing(benchmark::State& state) {
+  LinkedStacks stacks;
+  RawSocket socket{*stacks.a, RawSocket::kIpv4, [](auto&, auto) {}};
+  auto echo = makeEcho();
+  std::vector<std::uint8_t> buf(kMaxTransmissionUnit);
+
+  auto pingBurst = [&]() {
+    for (auto i = 0; i < kBurstLen; i++) {
+      socket.send(echo.data(), echo.size());
+    }
+
+    auto replies = 0;
+    return stacks.runUntil([&]() {
+      while (socket.read(buf.data(), buf.size()) > 0) {
+        replies++;
+      }
+      return replies == kBurstLen;
+    });
+  };
+
+  // Resolve the Ethernet address of B before we start timing.
+  if (!pingBurst()) {
+    state.SkipWithError("Lost echo replies.");
+    return;
+  }
+
+  for (auto _ : state) {
+    if (!pingBurst()) {
+      state.SkipWithError("Lost echo replies.");
+      return;
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * kBurstLen);
+}
+
+// Moves bursts of frames between raw Ethernet sockets on A and B.
+static void benchStackRawEthernet(benchmark::State& state) {
+  LinkedStacks stacks;
+  RawSocket socketA{*stacks.a, RawSocket::kEthernet, [](auto&, auto) {}};
+  RawSocket socketB{*stacks.b, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::vector<std::uint8_t> frame(state.range(0));
+  auto eth = reinterpret_cast<EthernetHeader*>(frame.data());
+  eth->dstAddr = kHwAddrB;
+  eth->srcAddr = kHwAddrA;
+  eth->ethType = hostToNet<std::uint16_t>(0x88b5);
+  std::vector<std::uint8_t> buf(kMaxTransmissionUnit);
+  std::int64_t frames = 0;
+
+  for (auto _ : state) {
+    // Large frames may not all fit the send queue of the socket.
+    auto sent = 0;
+    for (auto i = 0; i < kBurstLen; i++) {
+      sent += socketA.send(frame.data(), frame.size()) > 0;
+    }
+
+    auto read = 0;
+    auto ok = stacks.runUntil([&]() {
+      while (socketB.read(buf.data(), buf.size()) > 0) {
+        read++;
+      }
+      return read == sent;
+    });
+
+    if (!ok) {
+      state.SkipWithError("Lost frames.");
+      return;
+    }
+    frames += read;
+  }
+
+  state.SetItemsProcessed(frames);
+  state.SetBytesProcessed(frames * frame.size());
+}
+
+// Writes a capture of an ARP reply from A followed by ICMPv4 echo requests from
+// A to B.
+static void writeReplay() {
+  PcapCapture capture{MemLink::makePair(kMaxTransmissionUnit, kReplayLen).first,
+                      kReplayPath};
+
+  std::vector<std::uint8_t> frame(sizeof(EthernetHeader) + sizeof(ArpHeader));
+  auto eth = reinterpret_cast<EthernetHeader*>(frame.data());
+  eth->dstAddr = kHwAddrB;
+  eth->srcAddr = kHwAddrA;
+  eth->ethType = eth_type::kArp;
+
+  auto arp =
+      reinterpret_cast<ArpHeader*>(frame.data() + sizeof(EthernetHeader));
+  arp->hwType = arp_hw_addr::kEth;
+  arp->protoType = arp_proto_addr::kIpv4;
+  arp->hwLen = 6;
+  arp->protoLen = 4;
+  arp->op = arp_op::kReply;
+  arp->srcHwAddr = kHwAddrA;
+  arp->srcProtoAddr = kIpv4AddrA;
+  arp->dstHwAddr = kHwAddrB;
+  arp->dstProtoAddr = kIpv4AddrB;
+  capture.send(frame.data(), frame.size());
+
+  auto echo = makeEcho();
+  frame.resize(sizeof(EthernetHeader));
+  eth = reinterpret_cast<EthernetHeader*>(frame.data());
+  eth->ethType = eth_type::kIpv4;
+  frame.insert(frame.end(), echo.begin(), echo.end());
+  for (auto i = 1; i < kReplayLen; i++) {
+    capture.send(frame.data(), frame.size());
+  }
+}
+
+// Replays captured echo requests to B. Nothing but the stack itself is
+// measured since replies are discarded by the device.
+static void benchStackReplay(benchmark::State& state) {
+  writeReplay();
+  auto dev = std::make_unique<PcapReplay>(kReplayPath);
+  auto replay = dev.get();
+  Stack stack{std::move(dev), kHwAddrB, Ipv4AddrCidr{kIpv4AddrB, 24},
+              kIpv4AddrA};
+
+  for (auto _ : state) {
+    replay->rewind();
+    while (!replay->done()) {
+      stack.runLoopOnce();
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * replay->frameCount());
+}
+
+BENCHMARK(benchStackPing);
+BENCHMARK(benchStackRawEthernet)->Arg(64)->Arg(kMaxTransmissionUnit);
+BENCHMARK(benchStackReplay);
+
+}  // namespace unet
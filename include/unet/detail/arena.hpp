@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <unet/detail/nonmovable.hpp>
+
+namespace unet {
+namespace detail {
+
+// The kind of pages backing an arena.
+enum class ArenaPages {
+  // 2MB pages reserved up front from the hugetlbfs pool.
+  Huge,
+
+  // Regular pages the kernel may back w/transparent huge pages.
+  Transparent,
+
+  // Regular pages.
+  Regular,
+};
+
+// A fixed region of memory mapped up front which frame buffers are carved out
+// of so packet processing under load does not fault in fresh pages or miss the
+// TLB on each new buffer. The region is backed w/2MB huge pages if the system
+// has them reserved, falling back to transparent huge pages and then regular
+// pages. Memory is handed out by bumping an offset and never given back.
+class Arena : public NonMovable {
+ public:
+  // Creates an arena of len bytes, rounded up to a whole number of pages.
+  // Locks the arena in memory if lock is true so its pages are faulted in up
+  // front and never swapped out.
+  Arena(std::size_t len, bool lock);
+
+  ~Arena();
+
+  // Return len bytes aligned to align (a power of two) or nullptr if the arena
+  // is exhausted.
+  void* allocate(std::size_t len, std::size_t align);
+
+  // Return true if p points into the arena.
+  bool contains(const void* p) const {
+    auto q = static_cast<const std::uint8_t*>(p);
+    return q >= base_ && q < base_ + len_;
+  }
+
+  // Moves the pages of the arena to the NUMA node of the calling thread and
+  // prefers that node for pages faulted in from now on. Return false if the
+  // system does not support NUMA policies.
+  bool bindToCurrentNode();
+
+  // Return the kind of pages backing the arena.
+  ArenaPages pages() const;
+
+  // Return the length of the arena in bytes.
+  std::size_t len() const;
+
+  // Return the number of bytes handed out so far.
+  std::size_t used() const;
+
+ private:
+  std::uint8_t* base_ = nullptr;
+  std::size_t len_ = 0;
+  std::size_t used_ = 0;
+  ArenaPages pages_ = ArenaPages::Regular;
+};
+
+}  // namespace detail
+}  // namespace unet
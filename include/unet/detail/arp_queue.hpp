@@ -9,6 +9,7 @@
 
 #include <unet/detail/arp_cache.hpp>
 #include <unet/detail/frame.hpp>
+#include <unet/detail/mem_budget.hpp>
 #include <unet/detail/nonmovable.hpp>
 #include <unet/detail/queue.hpp>
 #include <unet/timer.hpp>
@@ -22,10 +23,13 @@ namespace detail {
 // A queue for delaying IPv4 frames w/an unresolved IPv4 address.
 class ArpQueue : private NonMovable {
  public:
+  // Delayed frames are charged to the memory account, if any, which must
+  // outlive the queue.
   ArpQueue(std::size_t delayQueueLen, std::size_t cacheCapacity,
            std::chrono::seconds delayTimeout, std::chrono::seconds cacheTTL,
-           std::shared_ptr<Queue> sendQueue,
-           std::shared_ptr<TimerManager> timerManager);
+           std::shared_ptr<Queue<>> sendQueue,
+           std::shared_ptr<TimerManager> timerManager,
+           MemAccount* memAccount = nullptr);
 
   // Adds an IPv4 -> Ethernet address mapping to the underlying cache and sends
   // any delayed IPv4 frames.
@@ -41,15 +45,15 @@ class ArpQueue : private NonMovable {
   // Return true if the frame was delayed and there were no other frames with
   // the same hop address in the queue. In practice this means an ARP request
   // needs to be sent.
-  bool delay(std::unique_ptr<Frame> frame);
+  bool delay(FramePtr frame);
 
  private:
   void scheduleTimeout(Ipv4Addr hopAddr);
 
-  Queue delayQueue_;
+  Queue<> delayQueue_;
   std::chrono::seconds delayTimeout_;
   ArpCache cache_;
-  std::shared_ptr<Queue> sendQueue_;
+  std::shared_ptr<Queue<>> sendQueue_;
   std::shared_ptr<TimerManager> timerManager_;
   std::unordered_map<Ipv4Addr, std::unique_ptr<Timer>> timers_;
 };
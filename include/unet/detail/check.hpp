@@ -3,6 +3,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <unet/dev/dev.hpp>
+
 namespace unet {
 namespace detail {
 
@@ -10,5 +12,9 @@ namespace detail {
 // https://tools.ietf.org/html/rfc1071
 std::uint16_t checksum(const std::uint8_t* buf, std::size_t bufLen);
 
+// Calculates the Internet Checksum of the bytes of all segments in order as if
+// they were contiguous.
+std::uint16_t checksum(const DevSeg* segs, std::size_t segsLen);
+
 }  // namespace detail
 }  // namespace unet
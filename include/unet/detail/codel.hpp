@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+#include <unet/detail/nonmovable.hpp>
+
+namespace unet {
+namespace detail {
+
+// Counts of how CoDel managed a queue.
+struct CodelStats {
+  // The number of frames dropped from the head of the queue.
+  std::uint64_t drops = 0;
+
+  // The number of times the queue started dropping frames.
+  std::uint64_t dropStarts = 0;
+
+  // The time the last frame checked spent in the queue.
+  std::chrono::nanoseconds sojournTime{0};
+
+  // The longest time any frame checked spent in the queue.
+  std::chrono::nanoseconds maxSojournTime{0};
+};
+
+// Active queue management per CoDel (RFC 8289) which decides when to drop
+// frames from the head of a queue based on how long they waited in it. Frames
+// are dropped once the time they wait stays above target for at least an
+// interval, at a rate growing w/the square root of the number of drops until
+// the queue no longer stands. Bursts which drain within an interval are never
+// dropped.
+class Codel : public NonMovable {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  Codel(std::chrono::nanoseconds target, std::chrono::nanoseconds interval,
+        std::function<Clock::time_point()> now = Clock::now);
+
+  // Return the current time frames are timestamped w/.
+  Clock::time_point now() const {
+    return now_();
+  }
+
+  // Return true if the head of the queue, enqueued at enqueuedAt, should be
+  // dropped. last is true if the head is the only frame queued. Checking the
+  // same head again before time moves on yields the same answer.
+  bool shouldDrop(Clock::time_point enqueuedAt, bool last);
+
+  // Tells CoDel the queue ran empty.
+  void onEmpty();
+
+  // Return counts of how the queue was managed.
+  const CodelStats& stats() const;
+
+ private:
+  // Return true if frames have waited above target for at least an interval.
+  bool okToDrop(Clock::time_point now, std::chrono::nanoseconds sojourn,
+                bool last);
+
+  // Return the time of the next drop, an interval shrunk by the square root
+  // of the number of drops so far after t.
+  Clock::time_point controlLaw(Clock::time_point t) const;
+
+  std::chrono::nanoseconds target_;
+  std::chrono::nanoseconds interval_;
+  std::function<Clock::time_point()> now_;
+  Clock::time_point firstAboveTime_{};
+  Clock::time_point dropNext_{};
+  std::uint32_t count_ = 0;
+  std::uint32_t lastCount_ = 0;
+  bool dropping_ = false;
+  CodelStats stats_;
+};
+
+}  // namespace detail
+}  // namespace unet
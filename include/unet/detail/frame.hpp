@@ -8,44 +8,173 @@
 #include <boost/assert.hpp>
 
 #include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
 #include <unet/wire/ipv4.hpp>
 
 namespace unet {
 namespace detail {
 
+class Arena;
+class Frame;
+class FramePool;
+
+// Returns a frame to the pool which made it, if any, instead of freeing it.
+struct FrameDeleter {
+  void operator()(Frame* f) const;
+};
+
+// An owning pointer to a frame.
+using FramePtr = std::unique_ptr<Frame, FrameDeleter>;
+
+// A frame and its metadata. The metadata and the buffer holding the frame live
+// in a single cache aligned allocation, w/the layers stored as 16 bit offsets
+// from data so the metadata walked on the hot path fits a cache line.
+//
+// A frame may continue w/a chain of payload segments, each a frame of its own
+// (eg. one referencing caller memory), so large payloads are sent w/o being
+// copied next to their headers. Layers and room only cover the first segment.
 class Frame : public NonMovable {
  public:
+  // The max length of the network or transport layer of a frame.
+  static constexpr std::size_t kMaxLayerLen = 0xffff;
+
   std::uint8_t* data = nullptr;
-  std::uint8_t* net = nullptr;
-  std::uint8_t* transport = nullptr;
-  std::size_t dataLen = 0;
-  std::size_t netLen = 0;
-  std::size_t transportLen = 0;
+  std::uint32_t dataLen = 0;
+
+  // The next IPv4 address to send this frame to on the way to its final
+  // destination.
+  Ipv4Addr hopAddr{};
+
+  // Checksum and segmentation metadata exchanged w/devices which support
+  // offloads.
+  DevOffload offload{};
 
   // We need this to distinguish between IPv4 frames which we need to perform an
   // Ethernet address lookup and those for which we do not (eg. IPv4 frames
   // crafted from raw Ethernet sockets).
   bool doIpv4Routing = false;
 
-  // The next IPv4 address to send this frame to on the way to its final
-  // destination.
-  Ipv4Addr hopAddr{};
-
   // Return a frame w/the specified data length. The data is NOT initialized.
-  static std::unique_ptr<Frame> makeUninitialized(std::size_t dataLen);
+  // The frame is recycled by the pool, if any, instead of allocated. At least
+  // headroom bytes are reserved ahead of data for headers pushed later on.
+  static FramePtr makeUninitialized(std::size_t dataLen,
+                                    FramePool* pool = nullptr,
+                                    std::size_t headroom = 0);
 
-  // Return a frame w/the copied contents of f.
-  static std::unique_ptr<Frame> makeCopy(const Frame& f);
+  // Return a frame w/the copied contents of f across all its segments.
+  static FramePtr makeCopy(const Frame& f, FramePool* pool = nullptr);
 
   // Return a frame w/the copied contents of buf.
-  static std::unique_ptr<Frame> makeBuf(const std::uint8_t* buf,
-                                        std::size_t bufLen);
+  static FramePtr makeBuf(const std::uint8_t* buf, std::size_t bufLen,
+                          FramePool* pool = nullptr);
 
   // Return a frame w/the specified data.
-  static std::unique_ptr<Frame> makeStr(const std::string& s);
+  static FramePtr makeStr(const std::string& s);
+
+  // Return a frame referencing the bufLen bytes at buf, which lie within the
+  // data of owner, w/o copying them, eg. as a payload segment. The bytes are
+  // shared w/owner like makeShared(...) so they stay around w/the frame.
+  static FramePtr makeRef(Frame& owner, const std::uint8_t* buf,
+                          std::size_t bufLen);
+
+  // Return a frame w/the metadata of f referencing the bytes of owner w/o
+  // copying them. owner must own its bytes and hold the same data as f, which
+  // is usually owner itself. Neither may have payload segments. Shared bytes
+  // are immutable until unshare(...).
+  static FramePtr makeShared(const Frame& f, Frame& owner);
+
+  // Replaces f w/a private copy if its bytes are shared w/other frames so they
+  // can be written to.
+  static void unshare(FramePtr& f, FramePool* pool = nullptr);
+
+  // Return true if data lives in a buffer of this frame or of the frame it
+  // shares bytes w/as opposed to memory the frame does not own (eg. a device).
+  bool ownsData();
+
+  // Return true if other frames reference the bytes of this frame.
+  bool shared() const {
+    return cloned_ || refs_ > 1;
+  }
+
+  // Appends frag and its payload segments, if any, to the end of the chain of
+  // payload segments of this frame.
+  void append(FramePtr frag);
+
+  // Return the next payload segment of the frame or nullptr if there is none.
+  Frame* frag() const {
+    return more_ ? next_.get() : nullptr;
+  }
+
+  // Return the length of the frame across all its segments.
+  std::size_t chainLen() const;
+
+  // Return the number of bytes of memory the frame and its segments keep
+  // alive. Bytes shared w/other frames count in full for each of them.
+  std::size_t memLen() const;
+
+  // Replaces f w/a contiguous copy if it has payload segments.
+  static void flatten(FramePtr& f, FramePool* pool = nullptr);
 
   bool operator==(const std::string& data) const;
 
+  // Return the network layer or nullptr if it is not set.
+  std::uint8_t* net() const {
+    return layer(netOffset_);
+  }
+
+  std::size_t netLen() const {
+    return netLen_;
+  }
+
+  // Return the transport layer or nullptr if it is not set.
+  std::uint8_t* transport() const {
+    return layer(transportOffset_);
+  }
+
+  std::size_t transportLen() const {
+    return transportLen_;
+  }
+
+  // Sets the network layer to the len bytes at p within data.
+  void setNet(const std::uint8_t* p, std::size_t len) {
+    setLayer(netOffset_, netLen_, p, len);
+  }
+
+  // Sets the transport layer to the len bytes at p within data.
+  void setTransport(const std::uint8_t* p, std::size_t len) {
+    setLayer(transportOffset_, transportLen_, p, len);
+  }
+
+  // Unsets the network and transport layers.
+  void clearLayers() {
+    netOffset_ = transportOffset_ = kNoLayer;
+    netLen_ = transportLen_ = 0;
+  }
+
+  // Return the number of bytes free ahead of data. Room is only tracked for
+  // frames whose data lives in their own buffer.
+  std::size_t headroom();
+
+  // Return the number of bytes free past the end of data.
+  std::size_t tailroom();
+
+  // Grows data by len bytes at the front, eg. to prepend a header in place.
+  // The layers keep pointing at the same bytes.
+  //
+  // Return the new start of data.
+  std::uint8_t* push(std::size_t len);
+
+  // Shrinks data by len bytes at the front, eg. to strip a header. Layers which
+  // started in the stripped bytes are unset.
+  //
+  // Return the new start of data.
+  std::uint8_t* pull(std::size_t len);
+
+  // Grows data by len bytes at the end, eg. to append a trailer in place.
+  //
+  // Return the start of the appended bytes.
+  std::uint8_t* put(std::size_t len);
+
   template <typename T>
   T* dataAs() {
     return bufAs<T>(data, dataLen);
@@ -53,30 +182,91 @@ class Frame : public NonMovable {
 
   template <typename T>
   T* netAs() {
-    return bufAs<T>(net, netLen);
+    return bufAs<T>(net(), netLen_);
   }
 
   template <typename T>
   T* transportAs() {
-    return bufAs<T>(transport, transportLen);
+    return bufAs<T>(transport(), transportLen_);
   }
 
  private:
-  Frame(std::size_t dataLen);
+  static constexpr std::uint16_t kNoLayer = 0xffff;
+
+  Frame(std::size_t headroom, std::size_t dataLen, std::size_t bufLen);
+  ~Frame() = default;
+
+  // Return a frame allocated together w/a buffer of bufLen bytes, out of arena
+  // if it has room. Data starts headroom bytes into the buffer.
+  static Frame* allocate(std::size_t headroom, std::size_t dataLen,
+                         std::size_t bufLen, Arena* arena = nullptr);
+
+  // Frees a frame returned by allocate(...) w/o an arena.
+  static void free(Frame* f);
+
+  // Returns f to its pool, if any, or frees it.
+  static void release(Frame* f);
+
+  // Return the buffer allocated right after the frame.
+  std::uint8_t* buf();
+
+  // Clears all metadata for reuse as a frame w/the specified headroom and data
+  // length.
+  void reset(std::size_t headroom, std::size_t dataLen);
+
+  std::uint8_t* layer(std::uint16_t offset) const {
+    return (offset != kNoLayer) ? data + offset : nullptr;
+  }
+
+  void setLayer(std::uint16_t& offset, std::uint16_t& layerLen,
+                const std::uint8_t* p, std::size_t len) {
+    BOOST_ASSERT(p >= data && p - data < kNoLayer);
+    BOOST_ASSERT(len <= kMaxLayerLen);
+    offset = p - data;
+    layerLen = len;
+  }
+
+  // Moves a layer offset along w/the start of data.
+  static void pushLayer(std::uint16_t& offset, std::size_t len);
+  static void pullLayer(std::uint16_t& offset, std::uint16_t& layerLen,
+                        std::size_t len);
 
   template <typename T>
   T* bufAs(std::uint8_t* p, std::size_t len) {
-    BOOST_ASSERT(p >= buf_.get());
+    BOOST_ASSERT(p >= data);
     BOOST_ASSERT(len >= sizeof(T));
     return reinterpret_cast<T*>(p);
   }
 
-  // TODO(amaximov): Benchmark and consider variable sized struct allocation.
-  std::unique_ptr<Frame> next_;
-  std::unique_ptr<std::uint8_t[]> buf_;
-  std::size_t capacity_;
+  // Whether data points into the buffer of owner_. The bytes of the owner stay
+  // alive until it and all its clones are gone.
+  bool cloned_ = false;
+
+  // The number of frames referencing the bytes of a frame which is not a
+  // clone, including the frame itself.
+  std::uint16_t refs_ = 1;
+
+  std::uint16_t netOffset_ = kNoLayer;
+  std::uint16_t netLen_ = 0;
+  std::uint16_t transportOffset_ = kNoLayer;
+  std::uint16_t transportLen_ = 0;
+  std::uint32_t bufLen_;
+
+  // Whether next_ is the next payload segment of this frame as opposed to the
+  // next frame in a queue. The last segment links the chain into the queue.
+  bool more_ = false;
+
+  FramePtr next_;
+
+  // Clones are made w/the pool of their owner so they need not keep their own.
+  union {
+    FramePool* pool_ = nullptr;
+    Frame* owner_;
+  };
 
-  friend class Queue;
+  friend class ListQueue;
+  friend class FramePool;
+  friend struct FrameDeleter;
 };
 
 }  // namespace detail
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <unet/detail/arena.hpp>
+#include <unet/detail/frame.hpp>
+#include <unet/detail/nonmovable.hpp>
+
+namespace unet {
+namespace detail {
+
+// A cache of free frames so steady state packet processing does not allocate.
+// Frames made w/the pool go back to it once their FramePtr is destroyed. Free
+// frames are kept in power of two size classes of their buffer so a frame
+// freed after carrying one length is reused for any length in its class. The
+// pool must outlive all frames made w/it.
+//
+// A pool w/an arena carves new frames out of the arena until it is exhausted
+// and only then falls back to the heap. Frames from the arena are always kept
+// around since the arena never takes memory back.
+class FramePool : public NonMovable {
+ public:
+  // Creates a pool keeping up to maxFreeLen bytes of free frame buffers from
+  // the heap.
+  explicit FramePool(std::size_t maxFreeLen,
+                     std::unique_ptr<Arena> arena = nullptr);
+
+  ~FramePool();
+
+  // Return the number of frames allocated so far because no free frame of the
+  // size class was at hand. This stops growing once the pool is warm.
+  std::size_t allocations() const;
+
+  // Return the number of bytes of free frame buffers kept by the pool.
+  std::size_t freeLen() const;
+
+  // Return the arena of the pool, if any.
+  Arena* arena() const;
+
+ private:
+  static constexpr std::size_t kMinClassLen = 64;
+  static constexpr std::size_t kClassNr = 12;
+
+  // Return the index of the smallest size class fitting bufLen or kClassNr if
+  // it exceeds all classes.
+  static std::size_t classOf(std::size_t bufLen);
+
+  FramePtr acquire(std::size_t headroom, std::size_t dataLen);
+
+  void release(Frame* f);
+
+  // Frees f unless it lives in the arena.
+  void free(Frame* f);
+
+  std::size_t maxFreeLen_;
+  std::unique_ptr<Arena> arena_;
+  std::size_t freeLen_ = 0;
+  std::size_t allocations_ = 0;
+  std::vector<Frame*> free_[kClassNr];
+
+  friend class Frame;
+  friend struct FrameDeleter;
+};
+
+}  // namespace detail
+}  // namespace unet
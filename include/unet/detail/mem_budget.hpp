@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <boost/assert.hpp>
+
+#include <unet/detail/nonmovable.hpp>
+
+namespace unet {
+namespace detail {
+
+// A budget of bytes of memory held by queued frames shared by all queues of a
+// stack. The budget runs low once fewer than lowLen bytes are left so senders
+// can back off before frames get dropped.
+class MemBudget : public NonMovable {
+ public:
+  MemBudget(std::size_t len, std::size_t lowLen) : len_{len}, lowLen_{lowLen} {
+    BOOST_ASSERT(lowLen_ <= len_);
+  }
+
+  // Return true if len bytes were charged and false if they exceed what is left
+  // of the budget.
+  bool charge(std::size_t len) {
+    if (len > len_ - used_) {
+      return false;
+    }
+    used_ += len;
+    ranLow_ = ranLow_ || low();
+    return true;
+  }
+
+  void refund(std::size_t len) {
+    BOOST_ASSERT(len <= used_);
+    used_ -= len;
+  }
+
+  // Return true if fewer than lowLen bytes of the budget are left.
+  bool low() const {
+    return len_ - used_ < lowLen_;
+  }
+
+  // Return true if the budget ran low at any point since the last call, even
+  // if it has recovered by now.
+  bool takeRanLow() {
+    auto ranLow = ranLow_;
+    ranLow_ = false;
+    return ranLow;
+  }
+
+  // Return the number of bytes charged to the budget.
+  std::size_t used() const {
+    return used_;
+  }
+
+ private:
+  const std::size_t len_;
+  const std::size_t lowLen_;
+  std::size_t used_ = 0;
+  bool ranLow_ = false;
+};
+
+// Bytes of a budget charged on behalf of a single owner (eg. a socket) so usage
+// can be accounted for per owner. An account w/o a budget only keeps count.
+class MemAccount : public NonMovable {
+ public:
+  explicit MemAccount(std::shared_ptr<MemBudget> budget = nullptr)
+      : budget_{std::move(budget)} {}
+
+  ~MemAccount() {
+    BOOST_ASSERT(used_ == 0);
+  }
+
+  // Return true if len bytes were charged and false if they exceed what is left
+  // of the budget.
+  bool charge(std::size_t len) {
+    if (budget_ && !budget_->charge(len)) {
+      return false;
+    }
+    used_ += len;
+    return true;
+  }
+
+  void refund(std::size_t len) {
+    BOOST_ASSERT(len <= used_);
+    if (budget_) {
+      budget_->refund(len);
+    }
+    used_ -= len;
+  }
+
+  // Return true if the budget, if any, is running low.
+  bool low() const {
+    return budget_ && budget_->low();
+  }
+
+  // Return the number of bytes charged to the account.
+  std::size_t used() const {
+    return used_;
+  }
+
+ private:
+  std::shared_ptr<MemBudget> budget_;
+  std::size_t used_ = 0;
+};
+
+}  // namespace detail
+}  // namespace unet
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+#include <unet/wire/wire.hpp>
+
+namespace unet {
+namespace detail {
+
+// See https://www.tcpdump.org/manpages/pcap-savefile.5.html and
+// https://www.ietf.org/archive/id/draft-ietf-opsawg-pcapng-01.html for the
+// pcap and pcapng file formats.
+
+// Magic numbers of pcap files w/microsecond and nanosecond timestamps as
+// written by a host of the same byte order.
+static const std::uint32_t kPcapMagicUsec = 0xa1b2c3d4;
+static const std::uint32_t kPcapMagicNsec = 0xa1b23c4d;
+
+static const std::uint32_t kPcapLinkTypeEthernet = 1;
+
+struct UNET_PACK PcapHeader {
+  std::uint32_t magic;
+  std::uint16_t versionMajor;
+  std::uint16_t versionMinor;
+  std::int32_t thisZone;
+  std::uint32_t sigFigs;
+  std::uint32_t snapLen;
+  std::uint32_t linkType;
+};
+
+UNET_ASSERT_SIZE(PcapHeader, 24);
+
+struct UNET_PACK PcapRecordHeader {
+  std::uint32_t tsSec;
+  std::uint32_t tsFrac;
+  std::uint32_t capLen;
+  std::uint32_t origLen;
+};
+
+UNET_ASSERT_SIZE(PcapRecordHeader, 16);
+
+// pcapng block types.
+namespace pcapng_block {
+static const std::uint32_t kSectionHeader = 0x0a0d0d0a;
+static const std::uint32_t kInterfaceDesc = 0x00000001;
+static const std::uint32_t kSimplePacket = 0x00000003;
+static const std::uint32_t kEnhancedPacket = 0x00000006;
+}  // namespace pcapng_block
+
+static const std::uint32_t kPcapngByteOrderMagic = 0x1a2b3c4d;
+static const std::uint16_t kPcapngOptEnd = 0;
+static const std::uint16_t kPcapngOptTsResol = 9;
+
+}  // namespace detail
+}  // namespace unet
@@ -1,56 +1,225 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 
+#include <boost/assert.hpp>
 #include <boost/optional.hpp>
 
+#include <unet/detail/codel.hpp>
 #include <unet/detail/frame.hpp>
+#include <unet/detail/mem_budget.hpp>
 #include <unet/detail/nonmovable.hpp>
 
 namespace unet {
 namespace detail {
 
-// A FIFO queue of frames. All operations are allocation free.
+// Policies which determine how much capacity of a queue a frame uses.
+namespace queue_policy {
+
+struct One {
+  static std::size_t capacityOf(const Frame&) {
+    return 1;
+  }
+};
+
+struct DataLen {
+  static std::size_t capacityOf(const Frame& f) {
+    return f.chainLen();
+  }
+};
+
+struct NetLen {
+  static std::size_t capacityOf(const Frame& f) {
+    return f.netLen();
+  }
+};
+
+struct TransportLen {
+  static std::size_t capacityOf(const Frame& f) {
+    return f.transportLen();
+  }
+};
+
+// Frames use the capacity they are pushed w/, eg. when it depends on state only
+// the owner of the queue knows.
+struct Explicit {};
+
+}  // namespace queue_policy
+
+// A FIFO queue of frames backed by a ring of frame handles so peeking and
+// popping never touch the frames themselves. The ring starts out small and
+// doubles as frames are queued up to the slot limit, so queues sized for many
+// tiny frames pay only for the frames they actually hold. Operations are
+// allocation free once the ring has grown to fit the working set. Queued
+// frames are charged to the memory account of the queue, if any, for the
+// memory they keep alive. A queue managed by CoDel timestamps frames as they
+// are pushed and drops frames from its head which waited too long.
+template <typename Policy = queue_policy::One>
 class Queue : public NonMovable {
  public:
-  // A policy which determines how much capacity a frame uses.
-  enum class Policy {
-    One,
-    DataLen,
-    NetLen,
-    TransportLen,
-  };
-
-  // Creates a queue that can store up to capacity frames. The policy determines
-  // how much capacity a frame uses.
-  Queue(std::size_t capacity, Policy policy = Policy::One);
+  // Creates a queue that can store up to capacity frames as measured by the
+  // policy in up to slotNr slots. slotNr defaults to capacity which fits
+  // frames w/a capacity of at least 1. The account and CoDel, if any, must
+  // outlive the queue.
+  explicit Queue(std::size_t capacity, std::size_t slotNr = 0,
+                 MemAccount* account = nullptr, Codel* codel = nullptr)
+      : capacity_{(capacity > 0) ? capacity : 1},
+        account_{account},
+        codel_{codel} {
+    slotNr_ = (slotNr > 0) ? slotNr : capacity_;
+    mask_ = 1;
+    while (mask_ < slotNr_ && mask_ < kInitialSlotNr) {
+      mask_ <<= 1;
+    }
+    slots_ = std::make_unique<Slot[]>(mask_);
+    if (codel_) {
+      enqueuedAt_ = std::make_unique<Codel::Clock::time_point[]>(mask_);
+    }
+    mask_--;
+  }
 
-  ~Queue();
+  ~Queue() {
+    while (pop()) {
+    }
+  }
 
   // Return a reference to the head of the queue if the queue is not empty.
-  boost::optional<Frame&> peek();
+  // A queue managed by CoDel first drops frames from its head as CoDel sees
+  // fit. pop() does not consult CoDel so peek before popping.
+  boost::optional<Frame&> peek() {
+    while (codel_ && head_ != tail_ &&
+           codel_->shouldDrop(enqueuedAt_[head_ & mask_],
+                              tail_ - head_ == 1)) {
+      pop();
+    }
+
+    if (head_ == tail_) {
+      if (codel_) {
+        codel_->onEmpty();
+      }
+      return boost::none;
+    }
+    return boost::optional<Frame&>{*slots_[head_ & mask_].f};
+  }
 
   // Return the removed head of the queue.
-  std::unique_ptr<Frame> pop();
+  FramePtr pop() {
+    if (head_ == tail_) {
+      return {};
+    }
+
+    auto& slot = slots_[head_++ & mask_];
+    capacity_ += slot.capacity;
+    if (account_) {
+      account_->refund(slot.memLen);
+    }
+    return std::move(slot.f);
+  }
 
   // Pushes a frame f to the end of the queue. You can check if f was moved
   // to find out if the push succeeded. The push can fail if the queue is at
-  // its capacity limit.
-  void push(std::unique_ptr<Frame>& f);
+  // its capacity limit, out of slots or out of memory budget.
+  void push(FramePtr& f) {
+    push(f, Policy::capacityOf(*f));
+  }
+
+  // Same as above but f uses the specified capacity.
+  void push(FramePtr& f, std::size_t capacity) {
+    BOOST_ASSERT(f);
+    if (!hasCapacity(capacity)) {
+      tailDrops_++;
+      return;
+    }
+
+    auto memLen = account_ ? f->memLen() : 0;
+    if (account_ && !account_->charge(memLen)) {
+      tailDrops_++;
+      return;
+    }
+
+    if (tail_ - head_ > mask_) {
+      grow();
+    }
+
+    auto i = tail_++ & mask_;
+    auto& slot = slots_[i];
+    slot.f = std::move(f);
+    slot.capacity = capacity;
+    slot.memLen = memLen;
+    if (codel_) {
+      enqueuedAt_[i] = codel_->now();
+    }
+    capacity_ -= capacity;
+  }
 
   // Return true if the queue has space for more frames (up to the specified
   // capacity) and false otherwise.
-  bool hasCapacity(std::size_t capacity = 1) const;
+  bool hasCapacity(std::size_t capacity = 1) const {
+    return capacity_ >= capacity && tail_ - head_ < slotNr_;
+  }
 
   // Return true if the queue has space for f and false otherwise.
-  bool hasCapacity(const Frame& f) const;
+  bool hasCapacity(const Frame& f) const {
+    return hasCapacity(Policy::capacityOf(f));
+  }
+
+  // Return the number of frames the queue did not take, including those
+  // counted w/countTailDrop().
+  std::uint64_t tailDrops() const {
+    return tailDrops_;
+  }
+
+  // Count a frame dropped w/o pushing it after hasCapacity(...) returned false.
+  void countTailDrop() {
+    tailDrops_++;
+  }
 
  private:
+  // The number of slots a queue starts out w/, which fits small bursts.
+  static constexpr std::size_t kInitialSlotNr = 16;
+
+  struct Slot {
+    FramePtr f;
+    std::size_t capacity;
+    std::size_t memLen;
+  };
+
+  // Doubles the ring keeping each frame at its position modulo the new size.
+  void grow() {
+    auto mask = mask_ * 2 + 1;
+    auto slots = std::make_unique<Slot[]>(mask + 1);
+    std::unique_ptr<Codel::Clock::time_point[]> enqueuedAt;
+    if (codel_) {
+      enqueuedAt = std::make_unique<Codel::Clock::time_point[]>(mask + 1);
+    }
+
+    for (auto i = head_; i != tail_; i++) {
+      slots[i & mask] = std::move(slots_[i & mask_]);
+      if (codel_) {
+        enqueuedAt[i & mask] = enqueuedAt_[i & mask_];
+      }
+    }
+
+    slots_ = std::move(slots);
+    enqueuedAt_ = std::move(enqueuedAt);
+    mask_ = mask;
+  }
+
   std::size_t capacity_;
-  Policy policy_;
-  std::unique_ptr<Frame> head_;
-  Frame* tail_ = nullptr;
+  MemAccount* account_;
+  Codel* codel_;
+  std::unique_ptr<Slot[]> slots_;
+
+  // Timestamps of the frames in slots_ which only queues managed by CoDel pay
+  // for.
+  std::unique_ptr<Codel::Clock::time_point[]> enqueuedAt_;
+  std::size_t slotNr_;
+  std::size_t mask_;
+  std::size_t head_ = 0;
+  std::size_t tail_ = 0;
+  std::uint64_t tailDrops_ = 0;
 };
 
 }  // namespace detail
@@ -19,32 +19,75 @@ class RawSocket : public Socket {
   static constexpr std::uint32_t kEthernet = 0;
   static constexpr std::uint32_t kIpv4 = 1;
 
+  // Frames sent are capped at maxTransmissionUnit, except for TCP/IPv4 frames
+  // which are capped at maxTsoFrameLen, the max length of frames the device
+  // segments or maxTransmissionUnit if it does not.
   RawSocket(std::uint32_t socketType, std::size_t sendQueueLen,
             std::size_t readQueueLen, std::size_t maxTransmissionUnit,
-            std::shared_ptr<Serializer> serializer, List<RawSocket>& sockets,
-            SocketSet& socketSet, Callback callback);
+            std::size_t maxTsoFrameLen, std::shared_ptr<Serializer> serializer,
+            List<RawSocket>& sockets,
+            SocketSet& socketSet, Callback callback,
+            std::shared_ptr<MemBudget> memBudget = nullptr);
 
   ~RawSocket() override = default;
 
   void onFramePopped() override;
 
-  void process(const Frame& f);
+  // Signals Send if the socket can queue a frame and the memory budget is not
+  // running low. Sockets stop signaling Send while memory runs low so senders
+  // back off before frames get dropped.
+  void updateSendEvent();
 
+  // Queues f for reading w/o copying its bytes unless it does not own them, in
+  // which case they are copied into copy once for all sockets.
+  void process(Frame& f, FramePtr& copy);
+
+  // Throws if a reservation is outstanding.
   std::size_t send(const std::uint8_t* buf, std::size_t bufLen);
 
+  // Return a buffer to write the next frame to send into in place at the layer
+  // of the socket, or nullptr if the socket can not queue it. The headers below
+  // the layer are filled in. bufLen is truncated to the max length of frames
+  // the device segments. Throws if a reservation is outstanding.
+  std::uint8_t* reserve(std::size_t& bufLen);
+
+  // Queues the first len bytes of the buffer returned by reserve(...) for
+  // sending, which ends the reservation either way. Frames exceeding the
+  // maximum transmission unit are only queued if the device can segment them.
+  // Return the number of bytes queued, 0 if none.
+  std::size_t commit(std::size_t len);
+
   std::size_t read(std::uint8_t* buf, std::size_t bufLen);
 
+  // Return the bytes of the next queued frame at the layer of the socket w/o
+  // copying or dequeuing them, or nullptr if there is none. bufLen is set to
+  // their length.
+  const std::uint8_t* borrow(std::size_t& bufLen);
+
+  // Dequeues the frame returned by borrow(...), if any.
+  void release();
+
   // Closes the socket. The socket will be destroyed once all egress frames have
   // been drained. Thus the socket may or may not be destroyed inline so you
   // should not do anything with it after this call.
   void close();
 
  private:
+  // Return the length of the layer of f exchanged w/the user, which is also
+  // the capacity f uses of the queues of the socket.
+  std::size_t layerLen(const Frame& f) const;
+
+  // Return the max length of the frame w/len bytes at buf at the layer of the
+  // socket, which only exceeds the MTU for frames the device segments.
+  std::size_t sendLenMax(const std::uint8_t* buf, std::size_t len) const;
+
   std::uint32_t socketType_;
   Hook<RawSocket> socketsHook_;
-  Queue readQueue_;
+  Queue<queue_policy::Explicit> readQueue_;
   std::size_t sendLenMax_;
+  std::size_t tsoLenMax_;
   std::shared_ptr<Serializer> serializer_;
+  FramePtr reserved_;
   bool closed_ = false;
 };
 
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include <boost/assert.hpp>
+
+#include <unet/detail/frame.hpp>
+#include <unet/detail/nonmovable.hpp>
+
+namespace unet {
+namespace detail {
+
+// Rings of frames for handing frames from one thread to another. Both rings
+// are bounded, lock free and move frames in batches to amortize the cost of
+// synchronizing w/the other side.
+//
+// Frames are not thread safe themselves. A frame handed off must not share its
+// bytes w/other frames and a frame from a pool must find its way back to the
+// thread owning the pool, e.g. through a ring going the other way, before it
+// is released.
+
+namespace ring {
+
+constexpr std::size_t kCacheLineLen = 64;
+
+// Return len rounded up to a power of two.
+inline std::size_t roundUp(std::size_t len) {
+  std::size_t n = 1;
+  while (n < len) {
+    n <<= 1;
+  }
+  return n;
+}
+
+// The index of one side of a ring followed by a cache line of padding so the
+// two sides never write to the same cache line, wherever the ring lives.
+struct Index {
+  std::atomic<std::size_t> pos{0};
+
+  // The last position of the other side seen by the owner of this index.
+  std::size_t cached = 0;
+
+  char pad[kCacheLineLen];
+};
+
+}  // namespace ring
+
+// A ring handing frames from a single producer thread to a single consumer
+// thread.
+class SpscRing : public NonMovable {
+ public:
+  // Creates a ring for up to len frames, rounded up to a power of two.
+  explicit SpscRing(std::size_t len)
+      : len_{ring::roundUp(std::max<std::size_t>(len, 1))},
+        mask_{len_ - 1},
+        slots_{std::make_unique<Frame*[]>(len_)} {}
+
+  ~SpscRing() {
+    while (pop()) {
+    }
+  }
+
+  // Moves up to n frames from fs to the ring and return the number of frames
+  // moved. Only the producer thread may push.
+  std::size_t push(FramePtr* fs, std::size_t n) {
+    auto tail = producer_.pos.load(std::memory_order_relaxed);
+    if (len_ - (tail - producer_.cached) < n) {
+      producer_.cached = consumer_.pos.load(std::memory_order_acquire);
+    }
+
+    n = std::min(n, len_ - (tail - producer_.cached));
+    for (std::size_t i = 0; i < n; i++) {
+      BOOST_ASSERT(fs[i] && !fs[i]->shared());
+      slots_[(tail + i) & mask_] = fs[i].release();
+    }
+
+    producer_.pos.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  // Pushes a frame f to the ring. You can check if f was moved to find out if
+  // the push succeeded.
+  void push(FramePtr& f) {
+    push(&f, 1);
+  }
+
+  // Moves up to n frames from the ring to fs and return the number of frames
+  // moved. Only the consumer thread may pop.
+  std::size_t pop(FramePtr* fs, std::size_t n) {
+    auto head = consumer_.pos.load(std::memory_order_relaxed);
+    if (consumer_.cached - head < n) {
+      consumer_.cached = producer_.pos.load(std::memory_order_acquire);
+    }
+
+    n = std::min(n, consumer_.cached - head);
+    for (std::size_t i = 0; i < n; i++) {
+      fs[i].reset(slots_[(head + i) & mask_]);
+    }
+
+    consumer_.pos.store(head + n, std::memory_order_release);
+    return n;
+  }
+
+  // Return the removed head of the ring.
+  FramePtr pop() {
+    FramePtr f;
+    pop(&f, 1);
+    return f;
+  }
+
+ private:
+  const std::size_t len_;
+  const std::size_t mask_;
+  const std::unique_ptr<Frame*[]> slots_;
+  char pad_[ring::kCacheLineLen];
+  ring::Index producer_;
+  ring::Index consumer_;
+};
+
+// A ring handing frames from any number of producer threads to a single
+// consumer thread. Producers claim slots w/a CAS and publish each slot on its
+// own so a batch from one producer is never interleaved w/another.
+class MpscRing : public NonMovable {
+ public:
+  // Creates a ring for up to len frames, rounded up to a power of two.
+  explicit MpscRing(std::size_t len)
+      : len_{ring::roundUp(std::max<std::size_t>(len, 1))},
+        mask_{len_ - 1},
+        slots_{std::make_unique<Slot[]>(len_)} {}
+
+  ~MpscRing() {
+    while (pop()) {
+    }
+  }
+
+  // Moves up to n frames from fs to the ring and return the number of frames
+  // moved. Any thread may push.
+  std::size_t push(FramePtr* fs, std::size_t n) {
+    std::size_t tail;
+    for (;;) {
+      // The head is loaded first so it never passes the tail. The tail may
+      // still be more than a ring ahead of a head gone stale in between.
+      auto head = consumer_.pos.load(std::memory_order_acquire);
+      tail = producer_.pos.load(std::memory_order_relaxed);
+      if (tail - head > len_) {
+        continue;
+      }
+
+      n = std::min(n, len_ - (tail - head));
+      if (n == 0) {
+        return 0;
+      } else if (producer_.pos.compare_exchange_weak(
+                     tail, tail + n, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+
+    for (std::size_t i = 0; i < n; i++) {
+      BOOST_ASSERT(fs[i] && !fs[i]->shared());
+      auto& slot = slots_[(tail + i) & mask_];
+      slot.f = fs[i].release();
+      slot.seq.store(tail + i + 1, std::memory_order_release);
+    }
+
+    return n;
+  }
+
+  // Pushes a frame f to the ring. You can check if f was moved to find out if
+  // the push succeeded.
+  void push(FramePtr& f) {
+    push(&f, 1);
+  }
+
+  // Moves up to n frames from the ring to fs and return the number of frames
+  // moved. Stops early at a slot claimed by a producer which has not
+  // published it yet. Only the consumer thread may pop.
+  std::size_t pop(FramePtr* fs, std::size_t n) {
+    auto head = consumer_.pos.load(std::memory_order_relaxed);
+    std::size_t i = 0;
+    for (; i < n; i++) {
+      auto& slot = slots_[(head + i) & mask_];
+      if (slot.seq.load(std::memory_order_acquire) != head + i + 1) {
+        break;
+      }
+      fs[i].reset(slot.f);
+    }
+
+    consumer_.pos.store(head + i, std::memory_order_release);
+    return i;
+  }
+
+  // Return the removed head of the ring.
+  FramePtr pop() {
+    FramePtr f;
+    pop(&f, 1);
+    return f;
+  }
+
+ private:
+  // A slot holding the frame pushed at position seq - 1 once published.
+  struct Slot {
+    std::atomic<std::size_t> seq{0};
+    Frame* f = nullptr;
+  };
+
+  const std::size_t len_;
+  const std::size_t mask_;
+  const std::unique_ptr<Slot[]> slots_;
+  char pad_[ring::kCacheLineLen];
+  ring::Index producer_;
+  ring::Index consumer_;
+};
+
+}  // namespace detail
+}  // namespace unet
@@ -2,8 +2,10 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 #include <unet/detail/frame.hpp>
+#include <unet/detail/frame_pool.hpp>
 #include <unet/wire/ethernet.hpp>
 #include <unet/wire/ipv4.hpp>
 #include <unet/wire/wire.hpp>
@@ -12,52 +14,80 @@ namespace unet {
 namespace detail {
 
 // A serializer for crafting frames based on payloads from different layers.
+// Each layer is written once at its final offset and the headers below it are
+// prepended in place. Frames are recycled by the pool, if any, instead of
+// allocated and keep headroom bytes free ahead of the Ethernet header for
+// encapsulations.
 class Serializer {
  public:
-  Serializer(EthernetAddr ethAddr, Ipv4Addr ipv4Addr);
+  Serializer(EthernetAddr ethAddr, Ipv4Addr ipv4Addr,
+             std::shared_ptr<FramePool> pool = nullptr,
+             std::size_t headroom = 0);
+
+  // Return the pool frames are made w/or nullptr if there is none.
+  FramePool* pool() const;
+
+  // Return a frame w/dataLen bytes starting at the Ethernet header. The data is
+  // NOT initialized.
+  FramePtr makeRaw(std::size_t dataLen) const;
 
   template <typename F>
   auto make(std::size_t netLen, F&& callback) {
-    auto f = detail::Frame::makeUninitialized(sizeof(EthernetHeader) + netLen);
-    f->dataAs<EthernetHeader>()->srcAddr = ethAddr_;
-    f->net = f->data + sizeof(EthernetHeader);
-    f->netLen = netLen;
+    auto f = Frame::makeUninitialized(netLen, pool_.get(),
+                                      headroom_ + sizeof(EthernetHeader));
+    f->setNet(f->data, netLen);
+    pushEthernet(*f);
     callback(*f);
     return f;
   }
 
+  // Return an IPv4 frame w/transportLen bytes of transport layer filled in by
+  // the callback. The payload, if any, follows as payload segments instead of
+  // being copied into the frame and the callback sees only the first segment.
   template <typename F>
-  auto makeIpv4(std::size_t transportLen, F&& callback) {
+  auto makeIpv4(std::size_t transportLen, F&& callback,
+                FramePtr payload = nullptr) {
+    auto payloadLen = payload ? payload->chainLen() : 0;
     auto netLen = sizeof(Ipv4Header) + transportLen;
-    return make(netLen,
-                [this, &callback, transportLen, netLen](detail::Frame& f) {
-                  auto eth = f.dataAs<EthernetHeader>();
-                  eth->ethType = eth_type::kIpv4;
+    auto f = Frame::makeUninitialized(
+        transportLen, pool_.get(),
+        headroom_ + sizeof(EthernetHeader) + sizeof(Ipv4Header));
+    f->setTransport(f->data, transportLen);
+
+    auto ipv4 = reinterpret_cast<Ipv4Header*>(f->push(sizeof(Ipv4Header)));
+    ipv4->ihl = 5;
+    ipv4->version = 4;
+    ipv4->ecn = 0;
+    ipv4->dscp = 0;
+    ipv4->len = hostToNet<std::uint16_t>(netLen + payloadLen);
+    ipv4->id = 0;
+    ipv4->flagsOffset = 0;
+    ipv4->ttl = 64;
+    ipv4->srcAddr = ipv4Addr_;
+    f->setNet(f->data, netLen);
+    f->doIpv4Routing = true;
 
-                  auto ipv4 = f.netAs<Ipv4Header>();
-                  ipv4->ihl = 5;
-                  ipv4->version = 4;
-                  ipv4->ecn = 0;
-                  ipv4->dscp = 0;
-                  ipv4->len = hostToNet<std::uint16_t>(netLen);
-                  ipv4->id = 0;
-                  ipv4->flagsOffset = 0;
-                  ipv4->ttl = 64;
-                  ipv4->srcAddr = ipv4Addr_;
-                  f.transport = f.net + sizeof(Ipv4Header);
-                  f.transportLen = transportLen;
-                  f.doIpv4Routing = true;
+    pushEthernet(*f);
+    f->dataAs<EthernetHeader>()->ethType = eth_type::kIpv4;
 
-                  callback(f);
+    callback(*f);
 
-                  ipv4->checksum = 0;
-                  ipv4->checksum = checksumIpv4(ipv4);
-                });
+    ipv4->checksum = 0;
+    ipv4->checksum = checksumIpv4(ipv4);
+    if (payload) {
+      f->append(std::move(payload));
+    }
+    return f;
   }
 
  private:
+  // Prepends an Ethernet header w/our source address to f.
+  void pushEthernet(Frame& f) const;
+
   EthernetAddr ethAddr_;
   Ipv4Addr ipv4Addr_;
+  std::shared_ptr<FramePool> pool_;
+  std::size_t headroom_;
 };
 
 }  // namespace detail
@@ -7,6 +7,7 @@
 
 #include <unet/detail/frame.hpp>
 #include <unet/detail/list.hpp>
+#include <unet/detail/mem_budget.hpp>
 #include <unet/detail/queue.hpp>
 
 namespace unet {
@@ -25,9 +26,12 @@ class Socket {
   // event masks have a non-zero bitwise and. The socket MUST be allocated
   // on the heap w/operator new for destroy(...) to work. All methods of the
   // public API are safe to call inline from this or any other socket's
-  // callback.
+  // callback. The send queue holds up to sendQueueLen worth of frames as
+  // measured by the socket in up to sendQueueSlotNr frames. Frames queued by
+  // the socket are charged to the memory budget, if any.
   Socket(SocketSet& socketSet, std::size_t sendQueueLen,
-         Queue::Policy sendQueuePolicy, Callback callback);
+         std::size_t sendQueueSlotNr, Callback callback,
+         std::shared_ptr<MemBudget> memBudget = nullptr);
 
   Socket() = delete;
   Socket(const Socket&) = delete;
@@ -43,9 +47,13 @@ class Socket {
 
   bool hasQueuedFrames();
 
-  void sendFrame(std::unique_ptr<Frame>& f);
+  // Queues f for sending w/the specified capacity of the send queue.
+  void sendFrame(FramePtr& f, std::size_t capacity = 1);
 
-  std::unique_ptr<Frame> popFrame();
+  FramePtr popFrame();
+
+  // Return the account charged w/the memory of frames queued by the socket.
+  MemAccount& memAccount();
 
   void subscribedEventMaskAdd(std::uint32_t mask);
 
@@ -65,7 +73,8 @@ class Socket {
                         std::uint32_t pendingEventMask);
 
   SocketSet& socketSet_;
-  Queue sendQueue_;
+  MemAccount memAccount_;
+  Queue<queue_policy::Explicit> sendQueue_;
   std::shared_ptr<Callback> callback_;
   Hook<Socket> ownerHook_;
   Hook<Socket> callbackHook_;
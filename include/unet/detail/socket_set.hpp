@@ -22,7 +22,10 @@ class SocketSet : public NonMovable {
 
   // Pops as many frames as possible from sockets managed by this socket set to
   // the queue in round robin fashion.
-  void drainRoundRobin(Queue& queue);
+  void drainRoundRobin(Queue<>& queue);
+
+  // Return true if any socket has a callback to dispatch or frames to drain.
+  bool hasPendingWork() const;
 
  private:
   List<Socket> sockets_;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+// A device bound to an existing Linux interface (eg. one end of a veth pair)
+// via an AF_PACKET socket w/TPACKET_V3 memory mapped RX and TX rings.
+//
+// readBatch(...) does not copy frames but points each buffer straight into the
+// RX ring. These frames stay valid until the next call to read(...) or
+// readBatch(...).
+class AfPacket : public Dev, public detail::NonMovable {
+ public:
+  // Binds to the Linux interface w/the provided name.
+  AfPacket(const std::string& name);
+  ~AfPacket();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  int pollFd() const override;
+
+ private:
+  // Return the next received frame in the RX ring if there is one.
+  bool nextRxFrame(DevBuf& buf);
+
+  // Hands RX blocks we are done w/back to the kernel.
+  void releaseRxBlocks();
+
+  // Copies a frame into the next free TX ring slot if there is one.
+  bool pushTxFrame(const std::uint8_t* buf, std::size_t bufLen);
+
+  // Asks the kernel to transmit frames pushed to the TX ring.
+  void flushTx();
+
+  int fd_ = -1;
+  std::size_t maxTransmissionUnit_ = 0;
+  std::uint8_t* ring_ = nullptr;
+  std::size_t ringLen_ = 0;
+  std::uint8_t* rxRing_ = nullptr;
+  std::uint8_t* txRing_ = nullptr;
+  std::size_t rxBlock_ = 0;
+  std::size_t rxReleasedBlock_ = 0;
+  std::uint8_t* rxNextFrame_ = nullptr;
+  std::uint32_t rxRemaining_ = 0;
+  std::size_t txFrame_ = 0;
+};
+
+}  // namespace unet
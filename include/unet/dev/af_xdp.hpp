@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+struct xdp_ring_offset;
+
+namespace unet {
+
+// A device bound to a queue of an existing Linux interface via an AF_XDP
+// socket. An XDP program redirecting all frames on the queue to the socket is
+// attached in generic (SKB) mode so this works on any interface, including
+// veth, w/o driver support.
+//
+// Frames live in a UMEM region shared w/the kernel. readBatch(...) points each
+// buffer straight at its UMEM chunk so received frames are processed in place.
+// These frames stay valid until the next call to read(...) or readBatch(...).
+class AfXdp : public Dev, public detail::NonMovable {
+ public:
+  // Binds to the queue of the Linux interface w/the provided name. Any XDP
+  // program already attached to the interface causes this to fail.
+  AfXdp(const std::string& name, std::uint32_t queueId = 0);
+  ~AfXdp();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  int pollFd() const override;
+
+ private:
+  // A single producer/single consumer ring shared w/the kernel.
+  struct Ring {
+    std::uint32_t* producer = nullptr;
+    std::uint32_t* consumer = nullptr;
+    void* descs = nullptr;
+    std::uint32_t mask = 0;
+    void* map = nullptr;
+    std::size_t mapLen = 0;
+  };
+
+  void mapRing(Ring& ring, std::uint64_t pgoff, std::size_t descLen,
+               const xdp_ring_offset& offsets);
+
+  // Releases everything acquired so far by the constructor.
+  void destroy();
+
+  // Hands UMEM chunks of frames read in the last batch back to the kernel.
+  void refill();
+
+  // Reclaims UMEM chunks of frames the kernel has finished sending.
+  void reclaim();
+
+  int fd_ = -1;
+  int mapFd_ = -1;
+  int progFd_ = -1;
+  int linkFd_ = -1;
+  std::size_t maxTransmissionUnit_ = 0;
+  std::uint8_t* umem_ = nullptr;
+  Ring rx_;
+  Ring tx_;
+  Ring fill_;
+  Ring completion_;
+  std::vector<std::uint64_t> rxHeld_;
+  std::vector<std::uint64_t> txFree_;
+};
+
+}  // namespace unet
@@ -2,9 +2,84 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 
 namespace unet {
 
+class TimerManager;
+
+// Segmentation types of frames larger than the MTU. These match the virtio-net
+// header GSO types.
+namespace gso_type {
+static const std::uint8_t kNone = 0;
+static const std::uint8_t kTcpv4 = 1;
+static const std::uint8_t kUdp = 3;
+static const std::uint8_t kTcpv6 = 4;
+static const std::uint8_t kUdpL4 = 5;
+}  // namespace gso_type
+
+// Offloads a device may support on the send path.
+namespace dev_offload {
+// Segments TCP/IPv4 frames larger than the MTU and completes the partial
+// checksum of each segment. See DevOffload.
+static const std::uint32_t kTxTso4 = 1 << 0;
+
+// Gathers frames whose payload is scattered across segments. See DevBuf.
+static const std::uint32_t kTxSg = 1 << 1;
+}  // namespace dev_offload
+
+// The max number of payload segments of a frame sent to a device w/kTxSg.
+constexpr std::size_t kDevMaxSegs = 16;
+
+// Offload metadata of a frame exchanged w/a device.
+struct DevOffload {
+  // The transport checksum at csumStart + csumOffset only covers the pseudo
+  // header and still needs to be completed over csumStart..end of the frame.
+  bool csumPartial = false;
+
+  // All checksums of the frame have already been validated.
+  bool csumValid = false;
+
+  std::uint8_t gsoType = gso_type::kNone;
+
+  // The payload length of each segment when gsoType is not kNone.
+  std::uint16_t gsoSize = 0;
+
+  // The length of headers replicated for each segment.
+  std::uint16_t hdrLen = 0;
+
+  std::uint16_t csumStart = 0;
+  std::uint16_t csumOffset = 0;
+};
+
+// A segment of a frame in memory the device does not own.
+struct DevSeg {
+  const std::uint8_t* buf = nullptr;
+  std::size_t bufLen = 0;
+};
+
+// A buffer holding a single frame for batched device I/O. Frames sent to
+// devices w/kTxSg may continue past buf w/up to kDevMaxSegs payload segments.
+struct DevBuf {
+  std::uint8_t* buf = nullptr;
+  std::size_t bufLen = 0;
+  DevOffload offload{};
+  const DevSeg* segs = nullptr;
+  std::size_t segsLen = 0;
+};
+
+// Completes a partial checksum of the frame in buf as described by offload, if
+// any, and marks the checksum as complete.
+void completeChecksum(std::uint8_t* buf, std::size_t bufLen,
+                      DevOffload& offload);
+
+// Return the length of the frame in b across buf and its payload segments.
+std::size_t frameLen(const DevBuf& b);
+
+// Copies the frame in b across buf and its payload segments to dst, which must
+// fit frameLen(b) bytes.
+void gatherFrame(const DevBuf& b, std::uint8_t* dst);
+
 // A device for sending and receiving raw frames.
 class Dev {
  public:
@@ -23,9 +98,55 @@ class Dev {
   // A return of 0 indicates the device is exhausted.
   virtual std::size_t read(std::uint8_t* buf, std::size_t bufLen) = 0;
 
+  // Sends up to bufsLen frames across the link in order. Only devices w/kTxSg
+  // are handed frames w/payload segments. The default implementation calls
+  // send(...) for each frame.
+  //
+  // Return the number of frames sent or throws an Exception in case of an
+  // error. A return of less than bufsLen indicates the device is exhausted.
+  virtual std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen);
+
+  // Reads up to bufsLen frames from the link. The bufLen of each buffer is
+  // updated to the length of the frame read into it. A device may avoid the
+  // copy by instead pointing buf at a frame in memory it owns, which must stay
+  // valid until the next call to read(...) or readBatch(...). Devices
+  // w/offloads also fill in the offload metadata of each frame. The default
+  // implementation calls read(...) for each frame.
+  //
+  // Return the number of frames read or throws an Exception in case of an
+  // error. A return of less than bufsLen indicates the device is exhausted.
+  virtual std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen);
+
   // Return the Max Transmission Unit of this device. This should never under
   // any circumstances return 0.
   virtual std::size_t maxTransmissionUnit() const = 0;
+
+  // Return the max length of a frame exchanged w/this device. This exceeds the
+  // MTU for devices which segment and coalesce frames. The default
+  // implementation returns maxTransmissionUnit().
+  virtual std::size_t maxFrameLen() const;
+
+  // Return the dev_offload flags supported by this device. Frames sent to a
+  // device w/o offloads must have complete checksums and fit the MTU. The
+  // default implementation returns 0.
+  virtual std::uint32_t offloads() const;
+
+  // Hands the device the timer manager of the stack which owns it. Devices
+  // which need to do work at some point in time schedule timers w/it. The
+  // default implementation does nothing.
+  virtual void setTimerManager(std::shared_ptr<TimerManager> manager);
+
+  // Return a file descriptor which polls readable once frames may be read or
+  // -1 if there is none, in which case the stack never blocks on the device.
+  // The default implementation returns -1.
+  virtual int pollFd() const;
+
+  // Readies the device for the stack to block on pollFd() until frames arrive.
+  // Frames handed out by the last read are no longer in use by then.
+  //
+  // Return false if frames are already waiting to be read, in which case the
+  // stack does not block. The default implementation returns true.
+  virtual bool prepareWait();
 };
 
 }  // namespace unet
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+// One end of an in-memory link between two devices in the same process. Each
+// direction of the link is a preallocated single producer/single consumer ring
+// of frames so the two ends can be driven from different threads. No syscalls
+// are involved which makes this handy for benchmarking whole stacks.
+//
+// readBatch(...) points each buffer straight at its slot in the ring. These
+// frames stay valid until the next call to read(...) or readBatch(...). Frames
+// sent w/payload segments are gathered into their slot.
+class MemLink : public Dev, public detail::NonMovable {
+ public:
+  // Return both ends of a link w/the specified MTU. Each direction buffers up
+  // to ringLen frames.
+  static std::pair<std::unique_ptr<MemLink>, std::unique_ptr<MemLink>> makePair(
+      std::size_t maxTransmissionUnit, std::size_t ringLen = 1'024);
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  std::uint32_t offloads() const override;
+
+ private:
+  struct Ring;
+
+  MemLink(std::size_t maxTransmissionUnit, std::shared_ptr<Ring> tx,
+          std::shared_ptr<Ring> rx);
+
+  // Hands slots of frames read in the last batch back to the peer.
+  void release();
+
+  std::size_t maxTransmissionUnit_;
+  std::shared_ptr<Ring> tx_;
+  std::shared_ptr<Ring> rx_;
+  std::size_t rxHeld_ = 0;
+};
+
+}  // namespace unet
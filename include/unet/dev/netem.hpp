@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+#include <unet/timer.hpp>
+
+namespace unet {
+
+// The impairments of one direction of the link.
+struct NetemParams {
+  // The one-way delay of each frame.
+  std::chrono::microseconds delay{0};
+
+  // The max random deviation from delay. Frames may be reordered when the
+  // jitter exceeds the gap between them.
+  std::chrono::microseconds jitter{0};
+
+  // The probability in [0, 1] of dropping a frame.
+  double loss = 0;
+
+  // The probability in [0, 1] of sending a frame twice.
+  double duplicate = 0;
+
+  // The probability in [0, 1] of sending a frame right away, ahead of any
+  // frames already delayed.
+  double reorder = 0;
+
+  // The max bytes per second the link carries or 0 for no limit.
+  std::uint64_t rate = 0;
+
+  // The max number of frames held in flight before tail dropping.
+  std::size_t queueLen = 1'024;
+};
+
+// Counts of impairments applied to one direction of the link.
+struct NetemStats {
+  std::uint64_t lost = 0;
+  std::uint64_t duplicated = 0;
+  std::uint64_t reordered = 0;
+  std::uint64_t overflowed = 0;
+};
+
+// A device wrapping another device and emulating a wide area network on top of
+// it w/o root privileges or kernel netem. Each direction of the link delays,
+// loses, duplicates, reorders and rate limits frames independently.
+//
+// Delayed frames are scheduled w/the timer manager of the stack which owns the
+// device so they are released by the stack loop. readBatch(...) points each
+// buffer at a copy of the frame owned by the device. These frames stay valid
+// until the next call to read(...) or readBatch(...). Frames sent w/payload
+// segments are gathered before they are put in flight.
+class Netem : public Dev, public detail::NonMovable {
+ public:
+  // Wraps dev, impairing frames sent w/tx and frames read w/rx. The seed makes
+  // the random impairments repeatable.
+  Netem(std::unique_ptr<Dev> dev, const NetemParams& tx,
+        const NetemParams& rx = NetemParams{}, std::uint32_t seed = 0);
+  ~Netem();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  std::size_t maxFrameLen() const override;
+  std::uint32_t offloads() const override;
+  void setTimerManager(std::shared_ptr<TimerManager> manager) override;
+  int pollFd() const override;
+  bool prepareWait() override;
+
+  // Return counts of impairments applied to frames sent.
+  const NetemStats& txStats() const;
+
+  // Return counts of impairments applied to frames read.
+  const NetemStats& rxStats() const;
+
+ private:
+  class Pipe;
+
+  // Sends frames due on the TX pipe to the wrapped device.
+  void flushTx();
+
+  std::unique_ptr<Dev> dev_;
+  std::shared_ptr<TimerManager> manager_;
+  std::mt19937 rand_;
+  std::unique_ptr<Pipe> tx_;
+  std::unique_ptr<Pipe> rx_;
+};
+
+}  // namespace unet
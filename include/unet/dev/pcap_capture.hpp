@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+// A device wrapping another device and writing every frame sent through it to
+// a pcap file w/nanosecond timestamps. Frames read from the wrapped device are
+// passed through as is.
+//
+// Writes are buffered. Call flush() before reading the file while the capture
+// is still alive.
+class PcapCapture : public Dev, public detail::NonMovable {
+ public:
+  // Creates or truncates the pcap file at path.
+  PcapCapture(std::unique_ptr<Dev> dev, const std::string& path);
+  ~PcapCapture();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  std::size_t maxFrameLen() const override;
+  std::uint32_t offloads() const override;
+  void setTimerManager(std::shared_ptr<TimerManager> manager) override;
+  int pollFd() const override;
+  bool prepareWait() override;
+
+  // Writes buffered frames to the file.
+  void flush();
+
+ private:
+  // Appends a record for each of the frames to the file.
+  void write(const DevBuf* bufs, std::size_t bufsLen);
+
+  std::unique_ptr<Dev> dev_;
+  std::FILE* file_ = nullptr;
+};
+
+}  // namespace unet
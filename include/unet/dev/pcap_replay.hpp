@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+// A device replaying the Ethernet frames of a pcap or pcapng file. This makes
+// for repeatable benchmarks of the stack w/captured traffic.
+//
+// The file is memory mapped and indexed up front. readBatch(...) points each
+// buffer straight at the frame in the mapping so replaying copies nothing.
+// Frames are replayed either as fast as they are read or paced by their
+// original timestamps. Frames sent to the device are discarded.
+class PcapReplay : public Dev, public detail::NonMovable {
+ public:
+  // Opens the pcap or pcapng file at path. Frames of non-Ethernet interfaces
+  // are skipped. Throws an Exception if the file is malformed.
+  PcapReplay(const std::string& path, bool realTime = false);
+  ~PcapReplay();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+
+  // Return the length of the largest frame in the file.
+  std::size_t maxTransmissionUnit() const override;
+
+  // Return the number of frames in the file.
+  std::size_t frameCount() const;
+
+  // Return true once every frame has been read.
+  bool done() const;
+
+  // Replays the file from the first frame again.
+  void rewind();
+
+ private:
+  struct Record {
+    std::uint8_t* data;
+    std::size_t len;
+    std::chrono::nanoseconds ts;
+  };
+
+  void indexPcap();
+  void indexPcapng();
+
+  bool realTime_;
+  std::uint8_t* map_ = nullptr;
+  std::size_t mapLen_ = 0;
+  std::size_t maxTransmissionUnit_ = 0;
+  std::vector<Record> records_;
+  std::size_t next_ = 0;
+  bool started_ = false;
+  std::chrono::steady_clock::time_point startedAt_{};
+};
+
+}  // namespace unet
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+// One end of a link between two processes on the same host. Each direction of
+// the link is a single producer/single consumer ring of frames in a memfd
+// region mapped by both processes so frames are exchanged w/o the kernel.
+//
+// A sender only signals the eventfd of the peer when the peer is blocked in
+// wait(...) or on pollFd(). A peer busy polling the link is never woken w/a
+// syscall.
+//
+// readBatch(...) points each buffer straight at its slot in the ring. These
+// frames stay valid until the next call to read(...) or readBatch(...). The
+// geometry of the rings is validated once when an end is attached and nothing
+// the peer writes to the region later can point an end outside of it. The size
+// of the region is sealed so the peer can not shrink it either.
+class ShmLink : public Dev, public detail::NonMovable {
+ public:
+  // The file descriptors describing one end of a link.
+  struct Fds {
+    int mem = -1;
+    int rxEvent = -1;
+    int txEvent = -1;
+    std::uint32_t end = 0;
+  };
+
+  // Return both ends of a link w/the specified MTU. Each direction buffers up
+  // to ringLen frames. Hand an end to another process either by forking or by
+  // sending its fds() over a Unix socket w/SCM_RIGHTS and calling attach(...).
+  static std::pair<std::unique_ptr<ShmLink>, std::unique_ptr<ShmLink>> makePair(
+      std::size_t maxTransmissionUnit, std::size_t ringLen = 1'024);
+
+  // Return the end of a link described by fds received from another process.
+  // The end takes ownership of the fds. Throws if the size of the region is
+  // not sealed.
+  static std::unique_ptr<ShmLink> attach(const Fds& fds);
+
+  ~ShmLink();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  int pollFd() const override;
+  bool prepareWait() override;
+
+  // Blocks for up to timeoutMs milliseconds, or indefinitely if negative,
+  // until a frame is ready to be read.
+  //
+  // Return true if a frame is ready.
+  bool wait(int timeoutMs);
+
+  // Return the fds of this end. These stay owned by this end.
+  const Fds& fds() const;
+
+ private:
+  struct Header;
+  struct Ring;
+
+  explicit ShmLink(const Fds& fds);
+
+  // Releases everything acquired so far by the constructor.
+  void destroy();
+
+  // Hands slots of frames read in the last batch back to the peer.
+  void release();
+
+  // Wakes the peer if it is blocked in wait(...).
+  void notify();
+
+  // Return true if a frame not yet handed out is ready to be read.
+  bool ready() const;
+
+  Fds fds_;
+  std::size_t maxTransmissionUnit_ = 0;
+  std::size_t ringLen_ = 0;
+  void* map_ = nullptr;
+  std::size_t mapLen_ = 0;
+  Ring* tx_ = nullptr;
+  Ring* rx_ = nullptr;
+  std::size_t rxHeld_ = 0;
+};
+
+}  // namespace unet
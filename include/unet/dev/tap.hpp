@@ -1,6 +1,9 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include <unet/detail/nonmovable.hpp>
 #include <unet/dev/dev.hpp>
@@ -9,17 +12,41 @@ namespace unet {
 
 class Tap : public Dev, public detail::NonMovable {
  public:
-  // Creates a Linux TAP interface w/the provided name.
-  Tap(const std::string& name);
+  // Creates a Linux TAP interface w/the provided name. W/offloads, which are
+  // opt-in, each frame carries a virtio-net header so the kernel can hand us
+  // frames w/validated or partial checksums, and TCP/IPv4 frames larger than
+  // the MTU are segmented and coalesced by the kernel.
+  //
+  // read(...) completes partial checksums but drops the rest of the offload
+  // metadata. Use readBatch(...) w/buffers of maxFrameLen() to get it all.
+  Tap(const std::string& name, bool offloads = false);
   ~Tap();
 
+  // Opens queueNr queues of the multi-queue Linux TAP interface w/the provided
+  // name. The kernel spreads flows across queues and each queue can be driven
+  // independently, eg. by a stack per thread. All queues of an interface must
+  // agree on offloads.
+  static std::vector<std::unique_ptr<Tap>> makeQueues(const std::string& name,
+                                                      std::size_t queueNr,
+                                                      bool offloads = false);
+
   std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
   std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
   std::size_t maxTransmissionUnit() const override;
+  std::size_t maxFrameLen() const override;
+  std::uint32_t offloads() const override;
+  int pollFd() const override;
 
- private:
+ protected:
   int fd_ = 0;
+
+ private:
+  Tap(const std::string& name, bool offloads, bool multiQueue);
+
   std::size_t maxTransmissionUnit_ = 0;
+  bool vnetHdr_ = false;
 };
 
 }  // namespace unet
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <unet/detail/nonmovable.hpp>
+#include <unet/dev/dev.hpp>
+#include <unet/socket_addr.hpp>
+#include <unet/wire/ethernet.hpp>
+
+struct iovec;
+struct mmsghdr;
+struct sockaddr_in;
+
+namespace unet {
+
+// A virtual Ethernet segment tunneling each frame in a UDP datagram over an
+// ordinary kernel socket. Stacks in different processes or hosts join the same
+// segment by listing each other as peers. No root privileges or TAP interfaces
+// are needed.
+//
+// The link behaves like a learning switch. Frames to a unicast address are
+// sent to the peer the address was last seen from and all other frames are
+// flooded to every peer. At most maxLearnedLen addresses are remembered and
+// the least recently used one is forgotten to make room for another.
+// Datagrams from anybody other than a peer are dropped. Frames are batched
+// w/recvmmsg(...) and sendmmsg(...) straight from and to the buffers of the
+// caller.
+class UdpLink : public Dev, public detail::NonMovable {
+ public:
+  // Binds to the local address and exchanges frames w/the peers. The port of
+  // each address is in host byte order.
+  UdpLink(SocketAddr local, const std::vector<SocketAddr>& peers,
+          std::size_t maxTransmissionUnit = 1'500,
+          std::size_t maxLearnedLen = 4'096);
+  ~UdpLink();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t maxTransmissionUnit() const override;
+  int pollFd() const override;
+
+ private:
+  // Grows the message headers to hold at least len messages.
+  void reserve(std::size_t len);
+
+  // Return the index of the peer w/the provided address or peersLen_ if there
+  // is none.
+  std::size_t findPeer(const sockaddr_in& addr) const;
+
+  // Remembers the peer an address was seen from.
+  void learn(EthernetAddr addr, std::size_t peer);
+
+  struct Learned {
+    std::size_t peer;
+    std::uint64_t usedAt;
+  };
+
+  int fd_ = -1;
+  std::size_t maxTransmissionUnit_;
+  std::unique_ptr<sockaddr_in[]> peers_;
+  std::size_t peersLen_ = 0;
+  std::unordered_map<EthernetAddr, Learned> learned_;
+  std::size_t maxLearnedLen_;
+  std::uint64_t uses_ = 0;
+  std::unique_ptr<mmsghdr[]> msgs_;
+  std::unique_ptr<iovec[]> iovecs_;
+  std::unique_ptr<sockaddr_in[]> srcAddrs_;
+  std::vector<std::size_t> msgFrames_;
+  std::size_t msgsLen_ = 0;
+};
+
+}  // namespace unet
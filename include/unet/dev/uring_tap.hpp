@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/circular_buffer.hpp>
+
+#include <unet/dev/tap.hpp>
+
+namespace unet {
+
+// A Linux TAP interface driven by io_uring. A pool of registered buffers keeps
+// several reads outstanding at all times so frames are received while the
+// stack is busy processing. Completions are harvested in bulk straight from
+// the shared completion ring and each batch of reads or writes is submitted w/a
+// single io_uring_enter(...).
+//
+// readBatch(...) points each buffer straight at its registered buffer. These
+// frames stay valid until the next call to read(...) or readBatch(...).
+// read(...) drops frames which do not fit the provided buffer.
+// Offloads are not negotiated since registered buffers are sized for the MTU.
+class UringTap : public Tap {
+ public:
+  // Creates a Linux TAP interface w/the provided name.
+  UringTap(const std::string& name);
+  ~UringTap();
+
+  std::size_t send(const std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t read(std::uint8_t* buf, std::size_t bufLen) override;
+  std::size_t sendBatch(const DevBuf* bufs, std::size_t bufsLen) override;
+  std::size_t readBatch(DevBuf* bufs, std::size_t bufsLen) override;
+  int pollFd() const override;
+  bool prepareWait() override;
+
+ private:
+  // A completed read of len bytes into the registered buffer at index.
+  struct Completion {
+    std::uint32_t index;
+    std::uint32_t len;
+  };
+
+  // Queues a fixed buffer read or write of the registered buffer at index.
+  void prepare(std::uint8_t opcode, std::uint32_t index, std::size_t len);
+
+  // Takes back the last queued read or write, which must not have been
+  // submitted yet, and return the index of its registered buffer.
+  std::uint32_t unprepare();
+
+  // Submits all queued reads and writes w/a single syscall. Anything the
+  // kernel does not take stays queued for the next submit.
+  void submit();
+
+  // Drains the completion ring.
+  void harvest();
+
+  // Releases everything acquired so far by the constructor.
+  void destroy();
+
+  int ringFd_ = -1;
+  void* sqRing_ = nullptr;
+  std::size_t sqRingLen_ = 0;
+  void* cqRing_ = nullptr;
+  std::size_t cqRingLen_ = 0;
+  void* sqes_ = nullptr;
+  std::size_t sqesLen_ = 0;
+  std::uint32_t* sqTail_ = nullptr;
+  std::uint32_t* sqArray_ = nullptr;
+  std::uint32_t sqMask_ = 0;
+  std::uint32_t* cqHead_ = nullptr;
+  std::uint32_t* cqTail_ = nullptr;
+  std::uint32_t cqMask_ = 0;
+  void* cqes_ = nullptr;
+  std::uint32_t queued_ = 0;
+  std::size_t bufLen_ = 0;
+  std::unique_ptr<std::uint8_t[]> bufs_;
+  boost::circular_buffer<Completion> rxReady_;
+  std::vector<std::uint32_t> rxHeld_;
+  std::vector<std::uint32_t> txFree_;
+};
+
+}  // namespace unet
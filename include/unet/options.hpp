@@ -2,15 +2,42 @@
 
 #include <chrono>
 #include <cstddef>
+#include <functional>
 
 namespace unet {
 
+// The active queue management of the stack send queue.
+enum class SendQueueAqm {
+  // Drop frames arriving at a full queue.
+  TailDrop,
+
+  // Also drop frames from the head of the queue per CoDel once frames keep
+  // waiting longer than codelTarget for codelInterval so the queue does not
+  // stand and latency stays low under load.
+  Codel,
+};
+
 struct Options {
   // The maximum number of egress frames the stack can queue before (1) tail
   // dropping or (2) delaying dispatch of socket frames. This does not count
   // frames queued due for IPv4 -> Ethernet address resolution via ARP.
   std::size_t stackSendQueueLen = 16'384;
 
+  // The active queue management of the stack send queue.
+  SendQueueAqm sendQueueAqm = SendQueueAqm::TailDrop;
+
+  // The time CoDel lets frames wait in the stack send queue before it starts
+  // dropping them. This must be positive and not exceed codelInterval.
+  std::chrono::microseconds codelTarget = std::chrono::microseconds{5'000};
+
+  // How long frames must wait longer than codelTarget before CoDel starts
+  // dropping them, which should be on the order of a round trip time.
+  std::chrono::microseconds codelInterval = std::chrono::microseconds{100'000};
+
+  // The clock CoDel timestamps frames w/ or empty for the steady clock, eg. to
+  // control time in tests.
+  std::function<std::chrono::steady_clock::time_point()> codelClock;
+
   // The maximum number of frames waiting for an ARP reply that can be queued.
   std::size_t arpQueueLen = 1'024;
 
@@ -30,6 +57,45 @@ struct Options {
 
   // The maximum number of bytes a raw socket can queue on the read path.
   std::size_t rawSocketReadQueueLen = 32'768;
+
+  // The maximum number of bytes of memory kept alive by frames queued anywhere
+  // in the stack (ie. the send queue, the ARP queue and socket queues) or 0 for
+  // no limit. Frames which do not fit are dropped.
+  std::size_t memBudgetLen = 0;
+
+  // Sockets stop signaling Send once fewer than this many bytes of the memory
+  // budget are left so senders back off before frames get dropped, or 0 for a
+  // quarter of memBudgetLen. This must not exceed memBudgetLen.
+  std::size_t memBudgetLowLen = 0;
+
+  // The maximum number of frames moved between the stack and the device in a
+  // single batched device call.
+  std::size_t devBatchLen = 32;
+
+  // The maximum number of bytes of free frames the stack keeps around for
+  // reuse instead of allocating new frames.
+  std::size_t framePoolLen = 4 * 1'024 * 1'024;
+
+  // The number of bytes mapped up front for frame buffers, backed by 2MB huge
+  // pages where the system has them reserved and moved to the NUMA node of the
+  // thread running Stack::runLoop(). Frames which do not fit come from the
+  // heap. Use 0 to make all frames on the heap.
+  std::size_t frameArenaLen = 0;
+
+  // Whether to lock the frame arena in memory so it is faulted in up front and
+  // never swapped out. This may need CAP_IPC_LOCK or a raised RLIMIT_MEMLOCK.
+  bool frameArenaLock = false;
+
+  // The number of bytes reserved ahead of the Ethernet header of frames sent by
+  // the stack so encapsulations (eg. VLAN tags or tunnel headers) can be
+  // prepended w/o copying the frame.
+  std::size_t frameHeadroom = 32;
+
+  // How long the stack loop keeps busy polling once it runs out of work before
+  // blocking until the device has frames or a timer expires. Longer keeps
+  // latency low between bursts of traffic at the cost of CPU. Use 0 to block
+  // right away and std::chrono::microseconds::max() to never block.
+  std::chrono::microseconds loopBusyPollTime = std::chrono::microseconds{50};
 };
 
 }  // namespace unet
@@ -10,12 +10,35 @@
 
 namespace unet {
 
+// A read-only view of the bytes of a frame borrowed from a socket.
+struct FrameView {
+  const std::uint8_t* buf = nullptr;
+  std::size_t bufLen = 0;
+
+  // Return true if the view holds a frame.
+  explicit operator bool() const {
+    return buf != nullptr;
+  }
+};
+
+// A writable view of the bytes of a frame reserved for sending.
+struct FrameBuf {
+  std::uint8_t* buf = nullptr;
+  std::size_t bufLen = 0;
+
+  // Return true if the view holds a frame.
+  explicit operator bool() const {
+    return buf != nullptr;
+  }
+};
+
 // A socket for communicating via Ethernet or IPv4 frames. The following events
 // are supported:
 //
 // - Send: Indicates send(...) can send a frame. send(...) can still fail if the
 //         frame you are sending is too big and the socket does not have
-//         sufficient capacity.
+//         sufficient capacity. Send is withheld while the memory budget of
+//         the stack runs low.
 // - Read: Indicates read(...) can return data for a received frame.
 class RawSocket : public SocketBase<detail::RawSocket> {
  public:
@@ -40,15 +63,52 @@ class RawSocket : public SocketBase<detail::RawSocket> {
   // Return the number of bytes sent. Sending 0 bytes for a non-zero length buf
   // indicates the socket is exhausted. Sending > 0 but < bufLen bytes indicates
   // the frame was truncated to respect the maximum transmission unit of the
-  // underlying device. The buf should be at least as long as the header of the
-  // specified layer.
+  // underlying device. TCP/IPv4 frames may exceed it up to the max frame length
+  // of a device which segments them. The buf should be at least as long as the
+  // header of the specified layer. Throws if a frame is reserved but not yet
+  // committed.
   std::size_t send(const std::uint8_t* buf, std::size_t bufLen);
 
+  // Reserves a frame of up to bufLen bytes to write in place and send w/o
+  // copying it. The headers below the layer of the socket are already filled
+  // in. The frame is truncated to the max frame length of the underlying
+  // device, which only exceeds the maximum transmission unit for TCP/IPv4
+  // frames the device segments. The view is valid until commit(...), which
+  // MUST be called before sending or reserving another frame. Commit 0 bytes
+  // to drop the frame. Throws if a frame is already reserved.
+  //
+  // Return a view of the frame at the layer of the socket or an empty view if
+  // the socket is exhausted.
+  FrameBuf reserve(std::size_t bufLen);
+
+  // Sends the first len bytes of the frame returned by reserve(...) and ends
+  // the reservation.
+  //
+  // Return the number of bytes sent. Sending 0 bytes indicates the socket is
+  // exhausted, len is shorter than the header of the specified layer or the
+  // frame exceeds the maximum transmission unit and can not be segmented.
+  std::size_t commit(std::size_t len);
+
   // Reads a frame into buf. The frame will be truncated if buf is not long
   // enough.
   //
   // Return the number of bytes read into buf.
   std::size_t read(std::uint8_t* buf, std::size_t bufLen);
+
+  // Borrows the next received frame w/o copying it. The frame stays queued and
+  // the view valid until release() is called or the socket is destroyed. The
+  // bytes may be shared w/other sockets so they MUST NOT be written to.
+  //
+  // Return a view of the frame at the layer of the socket or an empty view if
+  // there is none. Borrowing again w/o releasing returns the same frame.
+  FrameView borrow();
+
+  // Releases the frame returned by borrow(), making way for the next one.
+  void release();
+
+  // Return the number of bytes of memory kept alive by frames queued by the
+  // socket, which count towards the memory budget of the stack.
+  std::size_t memUsed();
 };
 
 }  // namespace unet
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include <unet/detail/arp_queue.hpp>
+#include <unet/detail/codel.hpp>
 #include <unet/detail/frame.hpp>
+#include <unet/detail/frame_pool.hpp>
 #include <unet/detail/list.hpp>
+#include <unet/detail/mem_budget.hpp>
 #include <unet/detail/nonmovable.hpp>
 #include <unet/detail/queue.hpp>
 #include <unet/detail/raw_socket.hpp>
@@ -20,6 +25,37 @@
 
 namespace unet {
 
+// Counts of how the stack loop spent time w/o work to do.
+struct LoopStats {
+  // Time spent busy polling for work.
+  std::chrono::nanoseconds spinTime{0};
+
+  // Time spent blocked until the device has frames or a timer expires.
+  std::chrono::nanoseconds sleepTime{0};
+
+  // The number of times the loop blocked.
+  std::uint64_t sleeps = 0;
+};
+
+// Counts of how the stack send queue was managed.
+struct SendQueueStats {
+  // The number of frames dropped because the queue was full or the memory
+  // budget exhausted.
+  std::uint64_t tailDrops = 0;
+
+  // The number of frames dropped by CoDel for waiting too long.
+  std::uint64_t codelDrops = 0;
+
+  // The number of times CoDel started dropping frames.
+  std::uint64_t codelDropStarts = 0;
+
+  // The time the last frame to reach the head of the queue spent in it.
+  std::chrono::nanoseconds sojournTime{0};
+
+  // The longest time any frame reaching the head of the queue spent in it.
+  std::chrono::nanoseconds maxSojournTime{0};
+};
+
 // The core of the network stack. Responsible for draining sockets, routing
 // packets, etc.
 class Stack : public detail::NonMovable {
@@ -31,15 +67,33 @@ class Stack : public detail::NonMovable {
         Options opts = Options{});
 
   // Run the network stack until stopLoop(...) is called or an error occurs.
+  // Once there is no work pending the loop busy polls for loopBusyPollTime and
+  // then blocks until the device has frames to read or the next timer expires,
+  // unless the device has no pollFd().
   void runLoop();
 
   // Stops the network stack loop. Does nothing if the network stack is not
   // running.
   void stopLoop();
 
+  // Runs a single iteration of the network stack loop. This is handy for
+  // driving several stacks from the same thread.
+  void runLoopOnce();
+
   // Return a timer which will run f upon expiration.
   std::unique_ptr<Timer> createTimer(std::function<void()> f);
 
+  // Return counts of how runLoop() spent time w/o work to do.
+  const LoopStats& loopStats() const;
+
+  // Return counts of how the send queue was managed. The CoDel counts stay 0
+  // unless the send queue is managed by CoDel.
+  SendQueueStats sendQueueStats() const;
+
+  // Return the number of bytes of memory kept alive by frames queued in the
+  // stack and its sockets, as charged to the memory budget.
+  std::size_t memUsed() const;
+
   // Return the Ethernet address assigned to the stack.
   EthernetAddr getHwAddr() const;
 
@@ -47,29 +101,47 @@ class Stack : public detail::NonMovable {
   Ipv4Addr getIpv4Addr() const;
 
  private:
-  void runLoopOnce();
-  void sendLoop();
-  void readLoop();
+  std::size_t sendLoop();
+  std::size_t readLoop();
+  bool waitForWork(int epollFd);
   void process(detail::Frame& f);
   void processArp(detail::Frame& f);
   void sendArp(Ipv4Addr dstIpv4Addr, EthernetAddr dstHwAddr,
                std::uint16_t arpOp);
-  void processIpv4(detail::Frame& f);
+  void processIpv4(detail::Frame& f, detail::FramePtr& copy);
   bool tryNextIpv4Hop(detail::Frame& f);
+  bool canGather(const detail::Frame& f) const;
+  bool offloadSegmentation(detail::Frame& f);
   void processIcmpv4(detail::Frame& f);
+  void updateSendEvents();
 
   std::unique_ptr<Dev> dev_;
   EthernetAddr ethAddr_;
   Ipv4AddrCidr ipv4AddrCidr_;
   Ipv4Addr defaultGateway_;
   Options opts_;
+  std::shared_ptr<detail::FramePool> framePool_;
+  std::shared_ptr<detail::MemBudget> memBudget_;
+  detail::MemAccount memAccount_;
   detail::SocketSet socketSet_;
-  std::shared_ptr<detail::Queue> sendQueue_;
+  std::shared_ptr<TimerManager> timerManager_;
+  std::unique_ptr<detail::Codel> codel_;
+  std::shared_ptr<detail::Queue<>> sendQueue_;
   detail::List<detail::RawSocket> ethernetSockets_;
   detail::List<detail::RawSocket> ipv4Sockets_;
-  std::shared_ptr<TimerManager> timerManager_;
   detail::ArpQueue arpQueue_;
   std::shared_ptr<detail::Serializer> serializer_;
+  std::size_t readFrameLen_;
+  std::size_t shortFrameLen_ = 0;
+  std::vector<detail::FramePtr> readFrames_;
+  detail::FramePtr readFrame_;
+  std::vector<detail::FramePtr> sendFrames_;
+  std::vector<DevBuf> devBufs_;
+  std::vector<DevSeg> devSegs_;
+  std::uint32_t devOffloads_ = 0;
+  bool idle_ = false;
+  bool memLow_ = false;
+  LoopStats loopStats_;
   bool runningLoop_ = false;
   bool stoppingLoop_ = false;
 
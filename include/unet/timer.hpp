@@ -5,6 +5,7 @@
 #include <memory>
 
 #include <boost/intrusive/set.hpp>
+#include <boost/optional.hpp>
 
 #include <unet/detail/nonmovable.hpp>
 
@@ -79,6 +80,10 @@ class TimerManager : public detail::NonMovable {
   // Return the last now timestamp passed to the update tick.
   std::chrono::steady_clock::time_point now() const;
 
+  // Return the time point after which the earliest scheduled timer expires or
+  // none if no timers are scheduled.
+  boost::optional<std::chrono::steady_clock::time_point> nextExpiry() const;
+
  private:
   // TODO(amaximov): Consider using a Hashed Hierarchial Timing Wheel design:
   // http://www.cs.columbia.edu/~nahum/w6998/papers/sosp87-timing-wheels.pdf
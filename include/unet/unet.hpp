@@ -1,7 +1,16 @@
 #pragma once
 
+#include <unet/dev/af_packet.hpp>
+#include <unet/dev/af_xdp.hpp>
 #include <unet/dev/dev.hpp>
+#include <unet/dev/mem_link.hpp>
+#include <unet/dev/netem.hpp>
+#include <unet/dev/pcap_capture.hpp>
+#include <unet/dev/pcap_replay.hpp>
+#include <unet/dev/shm_link.hpp>
 #include <unet/dev/tap.hpp>
+#include <unet/dev/udp_link.hpp>
+#include <unet/dev/uring_tap.hpp>
 #include <unet/event.hpp>
 #include <unet/exception.hpp>
 #include <unet/random.hpp>
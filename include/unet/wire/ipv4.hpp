@@ -71,10 +71,17 @@ UNET_ASSERT_SIZE(Ipv4Header, 20);
 // Return an IPv4 header checksum.
 std::uint16_t checksumIpv4(const Ipv4Header* header);
 
+// Return the uncomplemented sum of the pseudo header for a transport payload of
+// transportLen bytes. This is what a device completing a partial transport
+// checksum expects to find in the checksum field.
+std::uint16_t pseudoChecksumIpv4(const Ipv4Header* header,
+                                 std::size_t transportLen);
+
 // IPv4 protocols:
 // https://www.iana.org/assignments/protocol-numbers/protocol-numbers.xhtml
 namespace ipv4_proto {
 static const std::uint8_t kIcmp = 1;
+static const std::uint8_t kTcp = 6;
 }  // namespace ipv4_proto
 
 }  // namespace unet
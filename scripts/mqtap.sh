@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# Setup a multi-queue Linux TAP interface for benchmarking Tap queues driven in
+# parallel. The kernel spreads flows across the queues opened on mqtap0:
+#
+#    [ Stack(s) @ mqtap0 queues ]  <->  [ mqtap0 @ 10.255.253.101/24 ]
+
+if [ -d /sys/class/net/mqtap0 ]; then
+    exit 0
+fi
+
+sudo ip tuntap add name mqtap0 mode tap multi_queue user $USER
+sudo ip addr add 10.255.253.101/24 dev mqtap0
+sudo ip link set mqtap0 up
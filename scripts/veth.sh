@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# Setup a Linux veth pair for benchmarking devices which bind to an existing
+# interface (eg. AfPacket and AfXdp). Frames sent on veth0 are received on
+# veth1 and vice versa:
+#
+#    [ Stack @ veth0 ]  <->  [ veth1 @ 10.255.254.101/24 ]
+
+if [ -d /sys/class/net/veth0 ]; then
+    exit 0
+fi
+
+sudo ip link add veth0 type veth peer name veth1
+sudo ip addr add 10.255.254.101/24 dev veth1
+sudo ip link set veth0 up
+sudo ip link set veth1 up
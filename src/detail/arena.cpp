@@ -0,0 +1,124 @@
+#include <unet/detail/arena.hpp>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include <cerrno>
+
+#include <boost/assert.hpp>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+namespace detail {
+
+constexpr std::size_t kHugePageLen = 2 * 1'024 * 1'024;
+
+#ifdef __linux__
+// From linux/mempolicy.h which is not always installed.
+constexpr int kMpolPreferred = 1;
+constexpr unsigned kMpolMfMove = 1 << 1;
+#endif
+
+static std::size_t roundUp(std::size_t len, std::size_t pageLen) {
+  return (len + pageLen - 1) / pageLen * pageLen;
+}
+
+Arena::Arena(std::size_t len, bool lock) {
+  if (len == 0) {
+    throw Exception{"Arena must not be empty."};
+  }
+
+  void* p = MAP_FAILED;
+
+#ifdef __linux__
+  // Huge pages are only available if reserved by the administrator.
+  len_ = roundUp(len, kHugePageLen);
+  p = mmap(nullptr, len_, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (p != MAP_FAILED) {
+    pages_ = ArenaPages::Huge;
+  }
+#endif
+
+  if (p == MAP_FAILED) {
+    len_ = roundUp(len, sysconf(_SC_PAGESIZE));
+    p = mmap(nullptr, len_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+             -1, 0);
+    if (p == MAP_FAILED) {
+      throw Exception::fromErrNo();
+    }
+
+#ifdef __linux__
+    if (madvise(p, len_, MADV_HUGEPAGE) == 0) {
+      pages_ = ArenaPages::Transparent;
+    }
+#endif
+  }
+
+  base_ = static_cast<std::uint8_t*>(p);
+  if (lock && mlock(base_, len_) == -1) {
+    auto err = errno;
+    munmap(base_, len_);
+    errno = err;
+    throw Exception::fromErrNo();
+  }
+}
+
+Arena::~Arena() {
+  munmap(base_, len_);
+}
+
+void* Arena::allocate(std::size_t len, std::size_t align) {
+  BOOST_ASSERT((align & (align - 1)) == 0);
+  auto offset = (used_ + align - 1) & ~(align - 1);
+  if (offset > len_ || len > len_ - offset) {
+    return nullptr;
+  }
+
+  used_ = offset + len;
+  return base_ + offset;
+}
+
+bool Arena::bindToCurrentNode() {
+#ifdef __linux__
+  unsigned cpu;
+  unsigned node;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == -1) {
+    return false;
+  }
+
+  // The kernel drops the last bit of the mask.
+  constexpr auto kWordBits = sizeof(unsigned long) * 8;
+  unsigned long nodeMask[16]{};
+  if (node >= sizeof(nodeMask) * 8 - 1) {
+    return false;
+  }
+  nodeMask[node / kWordBits] |= 1UL << (node % kWordBits);
+
+  // Pages already faulted in are moved over too.
+  return syscall(SYS_mbind, base_, len_, kMpolPreferred, nodeMask,
+                 sizeof(nodeMask) * 8, kMpolMfMove) == 0;
+#else
+  return false;
+#endif
+}
+
+ArenaPages Arena::pages() const {
+  return pages_;
+}
+
+std::size_t Arena::len() const {
+  return len_;
+}
+
+std::size_t Arena::used() const {
+  return used_;
+}
+
+}  // namespace detail
+}  // namespace unet
@@ -6,7 +6,7 @@ namespace unet {
 namespace detail {
 
 template <typename F>
-static void scanQueue(Queue& q, F&& f) {
+static void scanQueue(Queue<>& q, F&& f) {
   // The expected head of the queue after looping through all frames.
   Frame* nextHead = nullptr;
   while (auto frame = q.pop()) {
@@ -27,9 +27,10 @@ static void scanQueue(Queue& q, F&& f) {
 ArpQueue::ArpQueue(std::size_t delayQueueLen, std::size_t cacheCapacity,
                    std::chrono::seconds delayTimeout,
                    std::chrono::seconds cacheTTL,
-                   std::shared_ptr<Queue> sendQueue,
-                   std::shared_ptr<TimerManager> timerManager)
-    : delayQueue_{delayQueueLen},
+                   std::shared_ptr<Queue<>> sendQueue,
+                   std::shared_ptr<TimerManager> timerManager,
+                   MemAccount* memAccount)
+    : delayQueue_{delayQueueLen, 0, memAccount},
       delayTimeout_{delayTimeout},
       cache_{cacheCapacity, cacheTTL,
              [timerManager]() { return timerManager->now(); }},
@@ -46,7 +47,7 @@ void ArpQueue::add(Ipv4Addr hopAddr, EthernetAddr ethAddr) {
   }
 
   // Scan all delayed frames and forward those with the resolved hopAddr.
-  scanQueue(delayQueue_, [this, hopAddr, ethAddr](std::unique_ptr<Frame>& f) {
+  scanQueue(delayQueue_, [this, hopAddr, ethAddr](FramePtr& f) {
     if (f->hopAddr == hopAddr) {
       f->dataAs<EthernetHeader>()->dstAddr = ethAddr;
       sendQueue_->push(f);
@@ -61,24 +62,28 @@ boost::optional<EthernetAddr> ArpQueue::lookup(Ipv4Addr hopAddr) {
   return cache_.lookup(hopAddr);
 }
 
-bool ArpQueue::delay(std::unique_ptr<Frame> frame) {
-  if (!frame || frame->dataLen < sizeof(EthernetHeader) ||
-      !delayQueue_.hasCapacity()) {
+bool ArpQueue::delay(FramePtr frame) {
+  if (!frame || frame->dataLen < sizeof(EthernetHeader)) {
     return false;
   }
 
-  auto needTimer = (timers_.count(frame->hopAddr) == 0);
-  if (needTimer) {
-    scheduleTimeout(frame->hopAddr);
+  auto hopAddr = frame->hopAddr;
+  delayQueue_.push(frame);
+  if (frame) {
+    // The queue is at capacity or out of memory budget.
+    return false;
   }
 
-  delayQueue_.push(frame);
+  auto needTimer = (timers_.count(hopAddr) == 0);
+  if (needTimer) {
+    scheduleTimeout(hopAddr);
+  }
   return needTimer;
 }
 
 void ArpQueue::scheduleTimeout(Ipv4Addr hopAddr) {
   auto timer = std::make_unique<Timer>(*timerManager_, [this, hopAddr]() {
-    scanQueue(delayQueue_, [hopAddr](std::unique_ptr<Frame>& f) {
+    scanQueue(delayQueue_, [hopAddr](FramePtr& f) {
       if (f->hopAddr == hopAddr) {
         f.reset();
       }
@@ -9,13 +9,18 @@
 namespace unet {
 namespace detail {
 
-std::uint16_t checksum(const std::uint8_t* buf, std::size_t bufLen) {
-  BOOST_ASSERT(buf != nullptr);
-
-  std::uint32_t acc = 0;
+// Adds the 16 bit words of buf to acc. A trailing odd byte is the high byte of
+// a word completed by the next buffer, if any.
+static void accumulate(std::uint32_t& acc, const std::uint8_t* buf,
+                       std::size_t bufLen, bool& odd) {
   auto end = buf + bufLen;
   auto p = buf;
 
+  if (odd && p < end) {
+    acc += *p++;
+    odd = false;
+  }
+
   for (; p + 1 < end; p += 2) {
     std::uint16_t x;
     std::memcpy(&x, p, 2);
@@ -24,12 +29,31 @@ std::uint16_t checksum(const std::uint8_t* buf, std::size_t bufLen) {
 
   if (p < end) {
     acc += (static_cast<std::uint16_t>(*p) << 8);
+    odd = true;
   }
 
+  // Fold early so long chains of segments cannot overflow.
   while (acc > 0xffff) {
     acc -= 0xffff;
   }
+}
+
+std::uint16_t checksum(const std::uint8_t* buf, std::size_t bufLen) {
+  BOOST_ASSERT(buf != nullptr);
+
+  std::uint32_t acc = 0;
+  auto odd = false;
+  accumulate(acc, buf, bufLen, odd);
+  return hostToNet(static_cast<std::uint16_t>(~acc));
+}
 
+std::uint16_t checksum(const DevSeg* segs, std::size_t segsLen) {
+  std::uint32_t acc = 0;
+  auto odd = false;
+  for (std::size_t i = 0; i < segsLen; i++) {
+    BOOST_ASSERT(segs[i].buf != nullptr || segs[i].bufLen == 0);
+    accumulate(acc, segs[i].buf, segs[i].bufLen, odd);
+  }
   return hostToNet(static_cast<std::uint16_t>(~acc));
 }
 
@@ -0,0 +1,84 @@
+#include <unet/detail/codel.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+namespace detail {
+
+Codel::Codel(std::chrono::nanoseconds target, std::chrono::nanoseconds interval,
+             std::function<Clock::time_point()> now)
+    : target_{target}, interval_{interval}, now_{std::move(now)} {
+  if (target_.count() <= 0 || interval_ < target_) {
+    throw Exception{"CoDel target must be positive and within the interval."};
+  }
+}
+
+bool Codel::shouldDrop(Clock::time_point enqueuedAt, bool last) {
+  auto now = now_();
+  auto sojourn = std::max(std::chrono::nanoseconds{now - enqueuedAt},
+                          std::chrono::nanoseconds{0});
+  stats_.sojournTime = sojourn;
+  stats_.maxSojournTime = std::max(stats_.maxSojournTime, sojourn);
+
+  auto ok = okToDrop(now, sojourn, last);
+  if (dropping_) {
+    if (!ok) {
+      // The queue no longer stands.
+      dropping_ = false;
+      return false;
+    } else if (now < dropNext_) {
+      return false;
+    }
+
+    count_++;
+    dropNext_ = controlLaw(dropNext_);
+    stats_.drops++;
+    return true;
+  } else if (!ok) {
+    return false;
+  }
+
+  // Pick up close to the drop rate we left off at if the queue stood again
+  // shortly after we stopped dropping.
+  dropping_ = true;
+  auto delta = count_ - lastCount_;
+  count_ = (delta > 1 && now - dropNext_ < 16 * interval_) ? delta : 1;
+  lastCount_ = count_;
+  dropNext_ = controlLaw(now);
+  stats_.drops++;
+  stats_.dropStarts++;
+  return true;
+}
+
+void Codel::onEmpty() {
+  firstAboveTime_ = Clock::time_point{};
+  dropping_ = false;
+}
+
+const CodelStats& Codel::stats() const {
+  return stats_;
+}
+
+bool Codel::okToDrop(Clock::time_point now, std::chrono::nanoseconds sojourn,
+                     bool last) {
+  // A single frame waiting is no standing queue.
+  if (sojourn < target_ || last) {
+    firstAboveTime_ = Clock::time_point{};
+    return false;
+  } else if (firstAboveTime_ == Clock::time_point{}) {
+    firstAboveTime_ = now + interval_;
+    return false;
+  }
+  return now >= firstAboveTime_;
+}
+
+Codel::Clock::time_point Codel::controlLaw(Clock::time_point t) const {
+  return t + std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 interval_ / std::sqrt(static_cast<double>(count_)));
+}
+
+}  // namespace detail
+}  // namespace unet
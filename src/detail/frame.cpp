@@ -1,45 +1,268 @@
 #include <unet/detail/frame.hpp>
 
+#include <cstdlib>
 #include <cstring>
+#include <new>
 
 #include <boost/assert.hpp>
 
+#include <unet/detail/arena.hpp>
+#include <unet/detail/frame_pool.hpp>
+
 namespace unet {
 namespace detail {
 
-Frame::Frame(std::size_t dataLen)
-    : dataLen{dataLen}, buf_{std::make_unique<std::uint8_t[]>(dataLen)} {
-  data = buf_.get();
+// Frames are padded to a whole number of cache lines so their buffer starts on
+// a cache line of its own.
+constexpr std::size_t kCacheLineLen = 64;
+constexpr std::size_t kFrameLen =
+    (sizeof(Frame) + kCacheLineLen - 1) & ~(kCacheLineLen - 1);
+
+// The metadata walked on the hot path fits a cache line.
+static_assert(sizeof(Frame) <= kCacheLineLen, "Frame is too large.");
+
+void FrameDeleter::operator()(Frame* f) const {
+  Frame* owner = nullptr;
+  if (f->cloned_) {
+    owner = f->owner_;
+    f->cloned_ = false;
+    f->pool_ = owner->pool_;
+  } else if (--f->refs_ > 0) {
+    // The last clone releases the frame along w/itself.
+    return;
+  }
+
+  Frame::release(f);
+  if (owner && --owner->refs_ == 0) {
+    Frame::release(owner);
+  }
 }
 
-std::unique_ptr<Frame> Frame::makeUninitialized(std::size_t dataLen) {
-  return std::unique_ptr<Frame>{new Frame{dataLen}};
+Frame::Frame(std::size_t headroom, std::size_t dataLen, std::size_t bufLen)
+    : data{buf() + headroom},
+      dataLen{static_cast<std::uint32_t>(dataLen)},
+      bufLen_{static_cast<std::uint32_t>(bufLen)} {}
+
+Frame* Frame::allocate(std::size_t headroom, std::size_t dataLen,
+                       std::size_t bufLen, Arena* arena) {
+  BOOST_ASSERT(headroom + dataLen <= bufLen);
+  auto p = arena ? arena->allocate(kFrameLen + bufLen, kCacheLineLen) : nullptr;
+  if (!p && posix_memalign(&p, kCacheLineLen, kFrameLen + bufLen) != 0) {
+    throw std::bad_alloc{};
+  }
+  return new (p) Frame{headroom, dataLen, bufLen};
 }
 
-std::unique_ptr<Frame> Frame::makeCopy(const Frame& f) {
-  auto copy = makeUninitialized(f.dataLen);
-  std::memcpy(copy->data, f.data, f.dataLen);
-  if (f.net) {
-    BOOST_ASSERT(f.net >= f.data);
-    copy->net = copy->data + (f.net - f.data);
-    copy->netLen = f.netLen;
+void Frame::free(Frame* f) {
+  f->~Frame();
+  std::free(f);
+}
+
+void Frame::release(Frame* f) {
+  if (f->more_) {
+    f->more_ = false;
+    f->next_.reset();
   }
-  if (f.transport) {
-    BOOST_ASSERT(f.transport >= f.data);
-    copy->transport = copy->data + (f.transport - f.data);
-    copy->transportLen = f.transportLen;
+
+  if (f->pool_) {
+    f->pool_->release(f);
+  } else {
+    free(f);
   }
+}
+
+std::uint8_t* Frame::buf() {
+  return reinterpret_cast<std::uint8_t*>(this) + kFrameLen;
+}
+
+void Frame::reset(std::size_t headroom, std::size_t dataLen) {
+  data = buf() + headroom;
+  this->dataLen = dataLen;
+  doIpv4Routing = false;
+  hopAddr = Ipv4Addr{};
+  offload = DevOffload{};
+  refs_ = 1;
+  clearLayers();
+}
+
+FramePtr Frame::makeUninitialized(std::size_t dataLen, FramePool* pool,
+                                  std::size_t headroom) {
+  if (pool) {
+    return pool->acquire(headroom, dataLen);
+  }
+  return FramePtr{allocate(headroom, dataLen, headroom + dataLen)};
+}
+
+std::size_t Frame::headroom() {
+  BOOST_ASSERT(data >= buf() && data <= buf() + bufLen_);
+  return data - buf();
+}
+
+std::size_t Frame::tailroom() {
+  BOOST_ASSERT(data >= buf() && data + dataLen <= buf() + bufLen_);
+  return buf() + bufLen_ - (data + dataLen);
+}
+
+std::uint8_t* Frame::push(std::size_t len) {
+  BOOST_ASSERT(!shared());
+  BOOST_ASSERT(len <= headroom());
+  data -= len;
+  dataLen += len;
+  pushLayer(netOffset_, len);
+  pushLayer(transportOffset_, len);
+  return data;
+}
+
+std::uint8_t* Frame::pull(std::size_t len) {
+  BOOST_ASSERT(len <= dataLen);
+  data += len;
+  dataLen -= len;
+  pullLayer(netOffset_, netLen_, len);
+  pullLayer(transportOffset_, transportLen_, len);
+  return data;
+}
+
+std::uint8_t* Frame::put(std::size_t len) {
+  BOOST_ASSERT(!shared());
+  BOOST_ASSERT(len <= tailroom());
+  auto p = data + dataLen;
+  dataLen += len;
+  return p;
+}
+
+void Frame::pushLayer(std::uint16_t& offset, std::size_t len) {
+  if (offset != kNoLayer) {
+    BOOST_ASSERT(offset + len < kNoLayer);
+    offset += len;
+  }
+}
+
+void Frame::pullLayer(std::uint16_t& offset, std::uint16_t& layerLen,
+                      std::size_t len) {
+  if (offset == kNoLayer) {
+    return;
+  } else if (offset < len) {
+    offset = kNoLayer;
+    layerLen = 0;
+  } else {
+    offset -= len;
+  }
+}
+
+FramePtr Frame::makeCopy(const Frame& f, FramePool* pool) {
+  auto copy = makeUninitialized(f.chainLen(), pool);
+  auto p = copy->data;
+  for (auto s = &f; s; s = s->frag()) {
+    std::memcpy(p, s->data, s->dataLen);
+    p += s->dataLen;
+  }
+  copy->netOffset_ = f.netOffset_;
+  copy->netLen_ = f.netLen_;
+  copy->transportOffset_ = f.transportOffset_;
+  copy->transportLen_ = f.transportLen_;
+  copy->offload = f.offload;
   return copy;
 }
 
-std::unique_ptr<Frame> Frame::makeBuf(const std::uint8_t* buf,
-                                      std::size_t bufLen) {
-  auto f = makeUninitialized(bufLen);
+FramePtr Frame::makeShared(const Frame& f, Frame& owner) {
+  BOOST_ASSERT(owner.ownsData());
+  BOOST_ASSERT(owner.dataLen == f.dataLen);
+  BOOST_ASSERT(!f.frag() && !owner.frag());
+
+  auto root = owner.cloned_ ? owner.owner_ : &owner;
+  if (root->refs_ == UINT16_MAX) {
+    return makeCopy(f, root->pool_);
+  }
+
+  auto clone = makeUninitialized(0, root->pool_);
+  clone->data = owner.data;
+  clone->dataLen = f.dataLen;
+  clone->netOffset_ = f.netOffset_;
+  clone->netLen_ = f.netLen_;
+  clone->transportOffset_ = f.transportOffset_;
+  clone->transportLen_ = f.transportLen_;
+  clone->offload = f.offload;
+  clone->cloned_ = true;
+  clone->owner_ = root;
+  root->refs_++;
+  return clone;
+}
+
+void Frame::unshare(FramePtr& f, FramePool* pool) {
+  if (f->shared()) {
+    f = makeCopy(*f, pool);
+  }
+}
+
+void Frame::append(FramePtr frag) {
+  BOOST_ASSERT(frag);
+  auto last = this;
+  while (last->more_) {
+    last = last->next_.get();
+  }
+
+  BOOST_ASSERT(!last->next_);
+  last->next_ = std::move(frag);
+  last->more_ = true;
+}
+
+std::size_t Frame::chainLen() const {
+  std::size_t len = 0;
+  for (auto s = this; s; s = s->frag()) {
+    len += s->dataLen;
+  }
+  return len;
+}
+
+std::size_t Frame::memLen() const {
+  std::size_t len = 0;
+  for (auto s = this; s; s = s->frag()) {
+    len += kFrameLen + s->bufLen_;
+    if (s->cloned_) {
+      len += kFrameLen + s->owner_->bufLen_;
+    }
+  }
+  return len;
+}
+
+void Frame::flatten(FramePtr& f, FramePool* pool) {
+  if (!f->frag()) {
+    return;
+  }
+
+  auto copy = makeCopy(*f, pool);
+  copy->doIpv4Routing = f->doIpv4Routing;
+  copy->hopAddr = f->hopAddr;
+  f = std::move(copy);
+}
+
+bool Frame::ownsData() {
+  auto owner = cloned_ ? owner_ : this;
+  return data >= owner->buf() &&
+         data + dataLen <= owner->buf() + owner->bufLen_;
+}
+
+FramePtr Frame::makeBuf(const std::uint8_t* buf, std::size_t bufLen,
+                        FramePool* pool) {
+  auto f = makeUninitialized(bufLen, pool);
   std::memcpy(f->data, buf, bufLen);
   return f;
 }
 
-std::unique_ptr<Frame> Frame::makeStr(const std::string& s) {
+FramePtr Frame::makeRef(Frame& owner, const std::uint8_t* buf,
+                        std::size_t bufLen) {
+  BOOST_ASSERT(buf >= owner.data &&
+               buf + bufLen <= owner.data + owner.dataLen);
+
+  // The shared frame may turn out to be a copy so we narrow it by offset.
+  auto f = makeShared(owner, owner);
+  f->data += buf - owner.data;
+  f->dataLen = bufLen;
+  f->clearLayers();
+  return f;
+}
+
+FramePtr Frame::makeStr(const std::string& s) {
   return makeBuf(reinterpret_cast<const std::uint8_t*>(s.data()), s.size());
 }
 
@@ -0,0 +1,86 @@
+#include <unet/detail/frame_pool.hpp>
+
+#include <boost/assert.hpp>
+
+namespace unet {
+namespace detail {
+
+FramePool::FramePool(std::size_t maxFreeLen, std::unique_ptr<Arena> arena)
+    : maxFreeLen_{maxFreeLen}, arena_{std::move(arena)} {}
+
+FramePool::~FramePool() {
+  for (auto& free : free_) {
+    for (auto f : free) {
+      this->free(f);
+    }
+  }
+}
+
+std::size_t FramePool::allocations() const {
+  return allocations_;
+}
+
+std::size_t FramePool::freeLen() const {
+  return freeLen_;
+}
+
+Arena* FramePool::arena() const {
+  return arena_.get();
+}
+
+std::size_t FramePool::classOf(std::size_t bufLen) {
+  std::size_t i = 0;
+  while (i < kClassNr && (kMinClassLen << i) < bufLen) {
+    i++;
+  }
+  return i;
+}
+
+FramePtr FramePool::acquire(std::size_t headroom, std::size_t dataLen) {
+  auto bufLen = headroom + dataLen;
+  auto i = classOf(bufLen);
+  if (i == kClassNr) {
+    // Frames this large are rare so they are never kept around.
+    allocations_++;
+    return FramePtr{Frame::allocate(headroom, dataLen, bufLen)};
+  }
+
+  auto& free = free_[i];
+  if (free.empty()) {
+    allocations_++;
+    FramePtr f{
+        Frame::allocate(headroom, dataLen, kMinClassLen << i, arena_.get())};
+    f->pool_ = this;
+    return f;
+  }
+
+  auto f = free.back();
+  free.pop_back();
+  freeLen_ -= f->bufLen_;
+  f->reset(headroom, dataLen);
+  return FramePtr{f};
+}
+
+void FramePool::release(Frame* f) {
+  BOOST_ASSERT(!f->next_);
+
+  auto inArena = arena_ && arena_->contains(f);
+  if (!inArena && freeLen_ + f->bufLen_ > maxFreeLen_) {
+    Frame::free(f);
+    return;
+  }
+
+  freeLen_ += f->bufLen_;
+  free_[classOf(f->bufLen_)].push_back(f);
+}
+
+void FramePool::free(Frame* f) {
+  if (arena_ && arena_->contains(f)) {
+    f->~Frame();
+  } else {
+    Frame::free(f);
+  }
+}
+
+}  // namespace detail
+}  // namespace unet
@@ -0,0 +1,90 @@
+#include <unet/detail/list_queue.hpp>
+
+#include <boost/assert.hpp>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+namespace detail {
+
+// Return the last segment of f, which links f to the next frame in a queue.
+static Frame* lastSegment(Frame* f) {
+  while (auto frag = f->frag()) {
+    f = frag;
+  }
+  return f;
+}
+
+static std::size_t capacityOfFrame(const Frame& f, ListQueue::Policy policy) {
+  switch (policy) {
+    case ListQueue::Policy::One:
+      return 1;
+    case ListQueue::Policy::DataLen:
+      return f.chainLen();
+    case ListQueue::Policy::NetLen:
+      return f.netLen();
+    case ListQueue::Policy::TransportLen:
+      return f.transportLen();
+  }
+
+  throw Exception{"Unknown queue policy!"};
+}
+
+ListQueue::ListQueue(std::size_t capacity, Policy policy)
+    : capacity_{(capacity > 0) ? capacity : 1}, policy_{policy} {}
+
+ListQueue::~ListQueue() {
+  // Avoid stack overflow when destroying huge queues!
+  while (head_) head_ = std::move(head_->next_);
+}
+
+boost::optional<Frame&> ListQueue::peek() {
+  return head_ ? boost::optional<Frame&>{*head_} : boost::none;
+}
+
+FramePtr ListQueue::pop() {
+  auto f = std::move(head_);
+  if (!f) {
+    return {};
+  }
+
+  head_ = std::move(lastSegment(f.get())->next_);
+  if (!head_) {
+    tail_ = nullptr;
+  }
+
+  // Frames are not resized while queued so they give back what they took.
+  capacity_ += capacityOfFrame(*f, policy_);
+  return f;
+}
+
+void ListQueue::push(FramePtr& f) {
+  BOOST_ASSERT(f);
+
+  auto capacity = capacityOfFrame(*f, policy_);
+  if (capacity_ < capacity) {
+    return;
+  }
+
+  capacity_ -= capacity;
+  auto last = lastSegment(f.get());
+  BOOST_ASSERT(!last->next_);
+  if (tail_) {
+    tail_->next_ = std::move(f);
+  } else {
+    head_ = std::move(f);
+  }
+
+  tail_ = last;
+}
+
+bool ListQueue::hasCapacity(std::size_t capacity) const {
+  return capacity_ >= capacity;
+}
+
+bool ListQueue::hasCapacity(const Frame& f) const {
+  return hasCapacity(capacityOfFrame(f, policy_));
+}
+
+}  // namespace detail
+}  // namespace unet
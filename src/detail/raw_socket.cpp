@@ -10,21 +10,37 @@
 namespace unet {
 namespace detail {
 
-static auto socketTypePolicy(std::uint32_t socketType) {
-  return (socketType == RawSocket::kEthernet) ? Queue::Policy::DataLen
-                                              : Queue::Policy::NetLen;
+// Return the length of the smallest frame a socket of the type exchanges.
+static std::size_t minFrameLen(std::uint32_t socketType) {
+  return (socketType == RawSocket::kEthernet) ? sizeof(EthernetHeader)
+                                              : sizeof(Ipv4Header);
+}
+
+// Return the number of slots a queue holding up to queueLen bytes of frames
+// exchanged by a socket of the type needs. This bounds the slots by the
+// smallest frame, eg. 2'341 slots for 32 KiB of Ethernet headers, so the slot
+// limit never refuses frames the byte limit admits. That costs nothing until
+// used since queues grow their slots w/the frames queued and a socket moving
+// full sized frames needs ~22 slots for the same 32 KiB.
+static std::size_t queueSlotNr(std::uint32_t socketType,
+                               std::size_t queueLen) {
+  return queueLen / minFrameLen(socketType) + 1;
 }
 
 RawSocket::RawSocket(std::uint32_t socketType, std::size_t sendQueueLen,
                      std::size_t readQueueLen, std::size_t maxTransmissionUnit,
+                     std::size_t maxTsoFrameLen,
                      std::shared_ptr<Serializer> serializer,
                      List<RawSocket>& sockets, SocketSet& socketSet,
-                     Callback callback)
-    : Socket{socketSet, sendQueueLen, socketTypePolicy(socketType), callback},
+                     Callback callback, std::shared_ptr<MemBudget> memBudget)
+    : Socket{socketSet, sendQueueLen, queueSlotNr(socketType, sendQueueLen),
+             callback, std::move(memBudget)},
       socketType_{socketType},
       socketsHook_{this},
-      readQueue_{readQueueLen, socketTypePolicy(socketType)},
+      readQueue_{readQueueLen, queueSlotNr(socketType, readQueueLen),
+                 &memAccount()},
       sendLenMax_{0},
+      tsoLenMax_{0},
       serializer_{serializer} {
   if (socketType_ != kEthernet && socketType_ != kIpv4) {
     throw Exception{"Unknown socket type."};
@@ -38,92 +54,177 @@ RawSocket::RawSocket(std::uint32_t socketType, std::size_t sendQueueLen,
     throw Exception{"MTU is too small for the specified layer."};
   } else if (socketType_ == kEthernet) {
     sendLenMax_ = maxTransmissionUnit;
+    tsoLenMax_ = maxTsoFrameLen;
   } else if (socketType_ == kIpv4) {
     sendLenMax_ = maxTransmissionUnit - sizeof(EthernetHeader);
+    tsoLenMax_ = maxTsoFrameLen - sizeof(EthernetHeader);
   }
+  tsoLenMax_ = std::max(tsoLenMax_, sendLenMax_);
 
   sockets.push_back(socketsHook_);
-  if (hasCapacity(1)) {
-    pendingEventMaskAdd(eventAsInt(Event::Send));
-  }
+  updateSendEvent();
 }
 
 void RawSocket::onFramePopped() {
   if (closed_ && !hasQueuedFrames()) {
     destroy();
-  } else if (!closed_) {
-    // Sent frames have non-zero length so we don't need to do a capacity check.
+  } else {
+    updateSendEvent();
+  }
+}
+
+void RawSocket::updateSendEvent() {
+  if (closed_) {
+    return;
+  } else if (hasCapacity(1) && !memAccount().low()) {
     pendingEventMaskAdd(eventAsInt(Event::Send));
+  } else {
+    pendingEventMaskRemove(eventAsInt(Event::Send));
   }
 }
 
-void RawSocket::process(const Frame& f) {
-  if (closed_ || !readQueue_.hasCapacity(f) ||
-      (socketType_ == kIpv4 && !f.net)) {
+std::size_t RawSocket::layerLen(const Frame& f) const {
+  return (socketType_ == kEthernet) ? f.dataLen : f.netLen();
+}
+
+void RawSocket::process(Frame& f, FramePtr& copy) {
+  if (closed_ || !readQueue_.hasCapacity(layerLen(f)) ||
+      (socketType_ == kIpv4 && !f.net())) {
     return;
   }
 
-  auto copy = Frame::makeCopy(f);
-  readQueue_.push(copy);
-  pendingEventMaskAdd(eventAsInt(Event::Read));
+  // Sockets queue frames sharing the same bytes. Bytes the frame does not own
+  // are copied once by the first socket to take them.
+  if (!copy && !f.ownsData()) {
+    copy = Frame::makeCopy(f, serializer_->pool());
+  }
+
+  auto shared = Frame::makeShared(f, copy ? *copy : f);
+  readQueue_.push(shared, layerLen(f));
+  if (!shared) {
+    pendingEventMaskAdd(eventAsInt(Event::Read));
+  }
+}
+
+std::size_t RawSocket::sendLenMax(const std::uint8_t* buf,
+                                  std::size_t len) const {
+  // The device checks the rest of the headers before it segments the frame.
+  if (socketType_ == kEthernet) {
+    auto isIpv4 = len >= sizeof(EthernetHeader) + sizeof(Ipv4Header) &&
+                  reinterpret_cast<const EthernetHeader*>(buf)->ethType ==
+                      eth_type::kIpv4;
+    buf += sizeof(EthernetHeader);
+    len = isIpv4 ? len - sizeof(EthernetHeader) : 0;
+  }
+
+  auto isTcp = len >= sizeof(Ipv4Header) &&
+               reinterpret_cast<const Ipv4Header*>(buf)->proto ==
+                   ipv4_proto::kTcp;
+  return isTcp ? tsoLenMax_ : sendLenMax_;
 }
 
 std::size_t RawSocket::send(const std::uint8_t* buf, std::size_t bufLen) {
-  auto headerLen =
-      (socketType_ == kEthernet) ? sizeof(EthernetHeader) : sizeof(Ipv4Header);
+  if (reserved_) {
+    throw Exception{"Commit the reserved frame before sending another."};
+  }
 
-  if (bufLen < headerLen) {
+  auto copyLen = std::min(bufLen, sendLenMax(buf, bufLen));
+  auto reserved = reserve(copyLen);
+  if (!reserved) {
     return 0;
   }
 
-  auto copyLen = std::min(sendLenMax_, bufLen);
-  if (copyLen == 0 || !hasCapacity(copyLen)) {
-    return 0;
+  std::copy(buf, buf + copyLen, reserved);
+  return commit(copyLen);
+}
+
+std::uint8_t* RawSocket::reserve(std::size_t& bufLen) {
+  if (reserved_) {
+    throw Exception{"Commit the reserved frame before reserving another."};
+  } else if (closed_ || bufLen < minFrameLen(socketType_)) {
+    return nullptr;
   }
 
-  std::unique_ptr<Frame> f;
+  bufLen = std::min(tsoLenMax_, bufLen);
+  if (bufLen == 0 || !hasCapacity(bufLen)) {
+    return nullptr;
+  }
 
   switch (socketType_) {
     case kEthernet:
-      f = Frame::makeBuf(buf, copyLen);
-      break;
+      reserved_ = serializer_->makeRaw(bufLen);
+      return reserved_->data;
     case kIpv4:
-      f = serializer_->make(copyLen, [buf, copyLen](Frame& f) {
+      reserved_ = serializer_->make(bufLen, [](Frame& f) {
         f.dataAs<EthernetHeader>()->ethType = eth_type::kIpv4;
-        std::copy(buf, buf + copyLen, f.net);
         f.doIpv4Routing = true;
       });
-      break;
+      return reserved_->net();
   }
 
-  sendFrame(f);
+  return nullptr;
+}
 
-  if (!hasCapacity(1)) {
-    pendingEventMaskRemove(eventAsInt(Event::Send));
+std::size_t RawSocket::commit(std::size_t len) {
+  auto f = std::move(reserved_);
+  if (!f || len < minFrameLen(socketType_)) {
+    return 0;
   }
 
-  return copyLen;
+  // Trims the frame down to the bytes written.
+  len = std::min(len, layerLen(*f));
+  auto buf = f->data + (socketType_ == kEthernet ? 0 : sizeof(EthernetHeader));
+  if (len > sendLenMax(buf, len)) {
+    return 0;
+  }
+
+  if (socketType_ == kEthernet) {
+    f->dataLen = len;
+  } else {
+    f->dataLen = sizeof(EthernetHeader) + len;
+    f->setNet(f->net(), len);
+  }
+
+  sendFrame(f, len);
+  updateSendEvent();
+
+  // The frame stays w/us if the memory budget is exhausted.
+  return f ? 0 : len;
 }
 
 std::size_t RawSocket::read(std::uint8_t* buf, std::size_t bufLen) {
-  auto f = readQueue_.pop();
-  if (!f) {
+  std::size_t readLen;
+  auto readBuf = borrow(readLen);
+  if (!readBuf) {
     return 0;
   }
 
-  auto readBuf = (socketType_ == kEthernet) ? f->data : f->net;
-  auto readLen = (socketType_ == kEthernet) ? f->dataLen : f->netLen;
   auto copyLen = std::min(bufLen, readLen);
   std::copy(readBuf, readBuf + copyLen, buf);
+  release();
+  return copyLen;
+}
 
+const std::uint8_t* RawSocket::borrow(std::size_t& bufLen) {
+  auto f = readQueue_.peek();
+  if (!f) {
+    bufLen = 0;
+    return nullptr;
+  }
+
+  bufLen = layerLen(*f);
+  return (socketType_ == kEthernet) ? f->data : f->net();
+}
+
+void RawSocket::release() {
+  readQueue_.pop();
   if (!readQueue_.peek()) {
     pendingEventMaskRemove(eventAsInt(Event::Read));
   }
-
-  return copyLen;
 }
 
 void RawSocket::close() {
+  reserved_.reset();
   if (!hasQueuedFrames()) {
     destroy();
   } else {
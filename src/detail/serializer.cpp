@@ -3,8 +3,25 @@
 namespace unet {
 namespace detail {
 
-Serializer::Serializer(EthernetAddr ethAddr, Ipv4Addr ipv4Addr)
-    : ethAddr_{ethAddr}, ipv4Addr_{ipv4Addr} {}
+Serializer::Serializer(EthernetAddr ethAddr, Ipv4Addr ipv4Addr,
+                       std::shared_ptr<FramePool> pool, std::size_t headroom)
+    : ethAddr_{ethAddr},
+      ipv4Addr_{ipv4Addr},
+      pool_{std::move(pool)},
+      headroom_{headroom} {}
+
+FramePool* Serializer::pool() const {
+  return pool_.get();
+}
+
+FramePtr Serializer::makeRaw(std::size_t dataLen) const {
+  return Frame::makeUninitialized(dataLen, pool_.get(), headroom_);
+}
+
+void Serializer::pushEthernet(Frame& f) const {
+  f.push(sizeof(EthernetHeader));
+  f.dataAs<EthernetHeader>()->srcAddr = ethAddr_;
+}
 
 }  // namespace detail
 }  // namespace unet
@@ -6,9 +6,11 @@ namespace unet {
 namespace detail {
 
 Socket::Socket(SocketSet& socketSet, std::size_t sendQueueLen,
-               Queue::Policy sendQueuePolicy, Callback callback)
+               std::size_t sendQueueSlotNr, Callback callback,
+               std::shared_ptr<MemBudget> memBudget)
     : socketSet_{socketSet},
-      sendQueue_{sendQueueLen, sendQueuePolicy},
+      memAccount_{std::move(memBudget)},
+      sendQueue_{sendQueueLen, sendQueueSlotNr, &memAccount_},
       callback_{new Callback{callback}},
       ownerHook_{this},
       callbackHook_{this},
@@ -25,19 +27,19 @@ bool Socket::hasQueuedFrames() {
   return !!sendQueue_.peek();
 }
 
-void Socket::sendFrame(std::unique_ptr<Frame>& f) {
+void Socket::sendFrame(FramePtr& f, std::size_t capacity) {
   if (!f) {
     return;
   }
 
   auto hadFrame = !!sendQueue_.peek();
-  sendQueue_.push(f);
+  sendQueue_.push(f, capacity);
   if (!hadFrame && !f) {
     socketSet_.dirty_.push_back(dirtyHook_);
   }
 }
 
-std::unique_ptr<Frame> Socket::popFrame() {
+FramePtr Socket::popFrame() {
   auto f = sendQueue_.pop();
   if (!f) {
     return {};
@@ -57,6 +59,10 @@ std::unique_ptr<Frame> Socket::popFrame() {
   return f;
 }
 
+MemAccount& Socket::memAccount() {
+  return memAccount_;
+}
+
 void Socket::subscribedEventMaskAdd(std::uint32_t mask) {
   eventMasksUpdate(subscribedEventMask_ | mask, pendingEventMask_);
 }
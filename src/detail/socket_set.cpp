@@ -48,7 +48,7 @@ void SocketSet::dispatch() {
   }
 }
 
-void SocketSet::drainRoundRobin(Queue& queue) {
+void SocketSet::drainRoundRobin(Queue<>& queue) {
   while (queue.hasCapacity() && !dirty_.empty()) {
     Hook<Socket>& hook = dirty_.front();
     auto f = hook->popFrame();
@@ -56,5 +56,9 @@ void SocketSet::drainRoundRobin(Queue& queue) {
   }
 }
 
+bool SocketSet::hasPendingWork() const {
+  return !callbacks_.empty() || !dirty_.empty();
+}
+
 }  // namespace detail
 }  // namespace unet
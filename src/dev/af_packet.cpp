@@ -0,0 +1,319 @@
+#include <unet/dev/af_packet.hpp>
+
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <arpa/inet.h>
+#include <linux/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+#ifdef __linux__
+
+// Ring geometry. RX blocks are retired by the kernel once full or after
+// kRxBlockTimeoutMs so a lightly loaded link does not sit on frames.
+constexpr std::size_t kRxBlockLen = 1 << 18;
+constexpr std::size_t kRxBlockNr = 16;
+constexpr std::size_t kRxFrameLen = 1 << 11;
+constexpr std::uint32_t kRxBlockTimeoutMs = 1;
+constexpr std::size_t kTxBlockLen = 1 << 18;
+constexpr std::size_t kTxBlockNr = 4;
+constexpr std::size_t kTxFrameLen = 1 << 11;
+constexpr std::size_t kTxFrameNr = kTxBlockLen / kTxFrameLen * kTxBlockNr;
+
+// The kernel expects TX data right after the aligned frame header.
+constexpr std::size_t kTxDataOffset = TPACKET_ALIGN(sizeof(tpacket3_hdr));
+
+static std::uint32_t loadStatus(const volatile std::uint32_t& status) {
+  std::uint32_t s = status;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return s;
+}
+
+static void storeStatus(volatile std::uint32_t& status, std::uint32_t s) {
+  std::atomic_thread_fence(std::memory_order_release);
+  status = s;
+}
+
+static tpacket_block_desc* rxBlockDesc(std::uint8_t* rxRing,
+                                       std::size_t block) {
+  return reinterpret_cast<tpacket_block_desc*>(
+      rxRing + (block % kRxBlockNr) * kRxBlockLen);
+}
+
+AfPacket::AfPacket(const std::string& name) {
+  if (name.size() >= IFNAMSIZ) {
+    throw Exception{"Interface name should be < IFNAMSIZ."};
+  }
+
+  if ((fd_ = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK,
+                    htons(ETH_P_ALL))) == -1) {
+    throw Exception::fromErrNo();
+  }
+
+  try {
+    // Query interface index and MTU...
+    ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, name.data(), IFNAMSIZ - 1);
+    if (ioctl(fd_, SIOCGIFINDEX, &ifr) == -1) {
+      throw Exception::fromErrNo();
+    }
+    auto ifindex = ifr.ifr_ifindex;
+
+    if (ioctl(fd_, SIOCGIFMTU, &ifr) == -1) {
+      throw Exception::fromErrNo();
+    } else if (ifr.ifr_mtu == 0) {
+      throw Exception{"AfPacket cannot have an MTU of 0."};
+    } else if (static_cast<std::size_t>(ifr.ifr_mtu) + ETH_HLEN >
+               kTxFrameLen - kTxDataOffset) {
+      throw Exception{"AfPacket MTU is too large for the TX ring."};
+    }
+    maxTransmissionUnit_ = ifr.ifr_mtu;
+
+    // Setup rings...
+    int version = TPACKET_V3;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_VERSION, &version,
+                   sizeof(version)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    tpacket_req3 rx;
+    std::memset(&rx, 0, sizeof(rx));
+    rx.tp_block_size = kRxBlockLen;
+    rx.tp_block_nr = kRxBlockNr;
+    rx.tp_frame_size = kRxFrameLen;
+    rx.tp_frame_nr = kRxBlockLen / kRxFrameLen * kRxBlockNr;
+    rx.tp_retire_blk_tov = kRxBlockTimeoutMs;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_RX_RING, &rx, sizeof(rx)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    tpacket_req3 tx;
+    std::memset(&tx, 0, sizeof(tx));
+    tx.tp_block_size = kTxBlockLen;
+    tx.tp_block_nr = kTxBlockNr;
+    tx.tp_frame_size = kTxFrameLen;
+    tx.tp_frame_nr = kTxFrameNr;
+    if (setsockopt(fd_, SOL_PACKET, PACKET_TX_RING, &tx, sizeof(tx)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // The kernel lays out the TX ring right after the RX ring.
+    ringLen_ = kRxBlockLen * kRxBlockNr + kTxBlockLen * kTxBlockNr;
+    auto ring = mmap(nullptr, ringLen_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd_, 0);
+    if (ring == MAP_FAILED) {
+      throw Exception::fromErrNo();
+    }
+    ring_ = static_cast<std::uint8_t*>(ring);
+    rxRing_ = ring_;
+    txRing_ = ring_ + kRxBlockLen * kRxBlockNr;
+
+    // Bind last so frames only start landing in the ring once it is setup.
+    sockaddr_ll addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = ifindex;
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+      throw Exception::fromErrNo();
+    }
+  } catch (...) {
+    if (ring_) {
+      munmap(ring_, ringLen_);
+    }
+    close(fd_);
+    throw;
+  }
+}
+
+AfPacket::~AfPacket() {
+  munmap(ring_, ringLen_);
+  close(fd_);
+}
+
+std::size_t AfPacket::send(const std::uint8_t* buf, std::size_t bufLen) {
+  if (!buf || !bufLen || !pushTxFrame(buf, bufLen)) {
+    return 0;
+  }
+
+  flushTx();
+  return bufLen;
+}
+
+std::size_t AfPacket::read(std::uint8_t* buf, std::size_t bufLen) {
+  releaseRxBlocks();
+
+  DevBuf frame;
+  if (!buf || !bufLen || !nextRxFrame(frame)) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, frame.bufLen);
+  std::memcpy(buf, frame.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t AfPacket::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  std::size_t count = 0;
+  while (count < bufsLen && bufs[count].buf && bufs[count].bufLen &&
+         pushTxFrame(bufs[count].buf, bufs[count].bufLen)) {
+    count++;
+  }
+
+  if (count > 0) {
+    flushTx();
+  }
+
+  return count;
+}
+
+std::size_t AfPacket::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  // Frames handed out by the previous batch are no longer in use.
+  releaseRxBlocks();
+
+  std::size_t count = 0;
+  while (count < bufsLen && nextRxFrame(bufs[count])) {
+    count++;
+  }
+
+  return count;
+}
+
+std::size_t AfPacket::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+int AfPacket::pollFd() const {
+  return fd_;
+}
+
+bool AfPacket::nextRxFrame(DevBuf& buf) {
+  for (;;) {
+    if (rxRemaining_ == 0) {
+      if (rxNextFrame_) {
+        // Done w/the current block. It is released on the next batch.
+        rxBlock_++;
+        rxNextFrame_ = nullptr;
+      }
+
+      // Do not wrap around onto blocks we have not released yet.
+      if (rxBlock_ - rxReleasedBlock_ >= kRxBlockNr) {
+        return false;
+      }
+
+      auto desc = rxBlockDesc(rxRing_, rxBlock_);
+      if (!(loadStatus(desc->hdr.bh1.block_status) & TP_STATUS_USER)) {
+        return false;
+      }
+
+      rxRemaining_ = desc->hdr.bh1.num_pkts;
+      rxNextFrame_ = reinterpret_cast<std::uint8_t*>(desc) +
+                     desc->hdr.bh1.offset_to_first_pkt;
+      continue;
+    }
+
+    auto hdr = reinterpret_cast<tpacket3_hdr*>(rxNextFrame_);
+    auto ll = reinterpret_cast<sockaddr_ll*>(
+        rxNextFrame_ + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+    rxNextFrame_ += hdr->tp_next_offset;
+    rxRemaining_--;
+
+    // Skip frames we sent ourselves.
+    if (ll->sll_pkttype == PACKET_OUTGOING) {
+      continue;
+    }
+
+    buf.buf = reinterpret_cast<std::uint8_t*>(hdr) + hdr->tp_mac;
+    buf.bufLen = hdr->tp_snaplen;
+    return true;
+  }
+}
+
+void AfPacket::releaseRxBlocks() {
+  for (; rxReleasedBlock_ < rxBlock_; rxReleasedBlock_++) {
+    auto desc = rxBlockDesc(rxRing_, rxReleasedBlock_);
+    storeStatus(desc->hdr.bh1.block_status, TP_STATUS_KERNEL);
+  }
+}
+
+bool AfPacket::pushTxFrame(const std::uint8_t* buf, std::size_t bufLen) {
+  if (bufLen > kTxFrameLen - kTxDataOffset) {
+    throw Exception{"Frame is too large for the TX ring."};
+  }
+
+  auto frame = txRing_ + (txFrame_ % kTxFrameNr) * kTxFrameLen;
+  auto hdr = reinterpret_cast<tpacket3_hdr*>(frame);
+  auto status = loadStatus(hdr->tp_status);
+  if (status != TP_STATUS_AVAILABLE && !(status & TP_STATUS_WRONG_FORMAT)) {
+    // The kernel has not sent the frame in this slot yet.
+    return false;
+  }
+
+  std::memcpy(frame + kTxDataOffset, buf, bufLen);
+  hdr->tp_len = bufLen;
+  hdr->tp_snaplen = bufLen;
+  hdr->tp_next_offset = 0;
+  storeStatus(hdr->tp_status, TP_STATUS_SEND_REQUEST);
+  txFrame_++;
+  return true;
+}
+
+void AfPacket::flushTx() {
+  if (::send(fd_, nullptr, 0, MSG_DONTWAIT) == -1 && errno != EAGAIN &&
+      errno != ENOBUFS) {
+    throw Exception::fromErrNo();
+  }
+}
+
+#else
+
+AfPacket::AfPacket(const std::string& name) {
+  (void)name;
+  throw Exception{"AfPacket devices are supported only on Linux."};
+}
+
+AfPacket::~AfPacket() {}
+
+std::size_t AfPacket::send(const std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfPacket::read(std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfPacket::sendBatch(const DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfPacket::readBatch(DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfPacket::maxTransmissionUnit() const {
+  return 0;
+}
+
+int AfPacket::pollFd() const {
+  return -1;
+}
+
+#endif
+
+}  // namespace unet
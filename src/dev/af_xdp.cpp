@@ -0,0 +1,425 @@
+#include <unet/dev/af_xdp.hpp>
+
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/bpf.h>
+#include <linux/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+#ifdef __linux__
+
+// UMEM geometry. Half of the chunks are lent to the kernel for RX via the fill
+// ring and the other half are used for TX.
+constexpr std::size_t kChunkLen = 2'048;
+constexpr std::size_t kChunkNr = 4'096;
+constexpr std::uint32_t kRingLen = kChunkNr / 2;
+
+constexpr auto kBindRetries = 100;
+constexpr auto kBindRetryDelay = std::chrono::milliseconds{10};
+
+static std::uint32_t loadAcquire(std::uint32_t* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void storeRelease(std::uint32_t* p, std::uint32_t x) {
+  __atomic_store_n(p, x, __ATOMIC_RELEASE);
+}
+
+static int bpf(int cmd, bpf_attr& attr) {
+  return syscall(__NR_bpf, cmd, &attr, sizeof(attr));
+}
+
+// Return an XDP program which redirects all frames on a queue to the AF_XDP
+// socket in the XSKMAP, falling back to the kernel stack if there is none:
+//
+//   return bpf_redirect_map(&xsks, ctx->rx_queue_index, XDP_PASS);
+static int loadRedirectProgram(int mapFd) {
+  bpf_insn insns[] = {
+      // r2 = ctx->rx_queue_index
+      {BPF_LDX | BPF_W | BPF_MEM, 2, 1,
+       static_cast<__s16>(offsetof(xdp_md, rx_queue_index)), 0},
+      // r1 = xsks
+      {BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0, mapFd},
+      {0, 0, 0, 0, 0},
+      // r3 = XDP_PASS
+      {BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS},
+      {BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map},
+      {BPF_JMP | BPF_EXIT, 0, 0, 0, 0},
+  };
+
+  static const char kLicense[] = "Dual MIT/GPL";
+
+  bpf_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.expected_attach_type = BPF_XDP;
+  attr.insns = reinterpret_cast<std::uint64_t>(insns);
+  attr.insn_cnt = sizeof(insns) / sizeof(insns[0]);
+  attr.license = reinterpret_cast<std::uint64_t>(kLicense);
+  return bpf(BPF_PROG_LOAD, attr);
+}
+
+AfXdp::AfXdp(const std::string& name, std::uint32_t queueId) {
+  if (name.size() >= IFNAMSIZ) {
+    throw Exception{"Interface name should be < IFNAMSIZ."};
+  }
+
+  try {
+    if ((fd_ = socket(AF_XDP, SOCK_RAW | SOCK_CLOEXEC, 0)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // Query interface index and MTU...
+    auto sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sockfd == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    ifreq ifr;
+    std::memset(&ifr, 0, sizeof(ifr));
+    std::strncpy(ifr.ifr_name, name.data(), IFNAMSIZ - 1);
+    if (ioctl(sockfd, SIOCGIFINDEX, &ifr) == -1) {
+      auto ex = Exception::fromErrNo();
+      close(sockfd);
+      throw ex;
+    }
+    auto ifindex = ifr.ifr_ifindex;
+
+    if (ioctl(sockfd, SIOCGIFMTU, &ifr) == -1) {
+      auto ex = Exception::fromErrNo();
+      close(sockfd);
+      throw ex;
+    }
+    close(sockfd);
+
+    if (ifr.ifr_mtu == 0) {
+      throw Exception{"AfXdp cannot have an MTU of 0."};
+    } else if (static_cast<std::size_t>(ifr.ifr_mtu) + ETH_HLEN >
+               kChunkLen) {
+      throw Exception{"AfXdp MTU is too large for a UMEM chunk."};
+    }
+    maxTransmissionUnit_ = ifr.ifr_mtu;
+
+    // Register UMEM...
+    auto umem = mmap(nullptr, kChunkLen * kChunkNr, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (umem == MAP_FAILED) {
+      throw Exception::fromErrNo();
+    }
+    umem_ = static_cast<std::uint8_t*>(umem);
+
+    xdp_umem_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.addr = reinterpret_cast<std::uint64_t>(umem_);
+    reg.len = kChunkLen * kChunkNr;
+    reg.chunk_size = kChunkLen;
+    if (setsockopt(fd_, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // Setup and map rings...
+    for (auto opt : {XDP_UMEM_FILL_RING, XDP_UMEM_COMPLETION_RING, XDP_RX_RING,
+                     XDP_TX_RING}) {
+      if (setsockopt(fd_, SOL_XDP, opt, &kRingLen, sizeof(kRingLen)) == -1) {
+        throw Exception::fromErrNo();
+      }
+    }
+
+    xdp_mmap_offsets offsets;
+    socklen_t offsetsLen = sizeof(offsets);
+    if (getsockopt(fd_, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &offsetsLen) ==
+        -1) {
+      throw Exception::fromErrNo();
+    }
+
+    mapRing(rx_, XDP_PGOFF_RX_RING, sizeof(xdp_desc), offsets.rx);
+    mapRing(tx_, XDP_PGOFF_TX_RING, sizeof(xdp_desc), offsets.tx);
+    mapRing(fill_, XDP_UMEM_PGOFF_FILL_RING, sizeof(std::uint64_t),
+            offsets.fr);
+    mapRing(completion_, XDP_UMEM_PGOFF_COMPLETION_RING,
+            sizeof(std::uint64_t), offsets.cr);
+
+    // Lend the first half of the chunks to the kernel for RX...
+    auto fill = static_cast<std::uint64_t*>(fill_.descs);
+    for (std::uint32_t i = 0; i < kRingLen; i++) {
+      fill[i] = i * kChunkLen;
+    }
+    storeRelease(fill_.producer, kRingLen);
+
+    for (auto i = kChunkNr; i > kRingLen; i--) {
+      txFree_.push_back((i - 1) * kChunkLen);
+    }
+    rxHeld_.reserve(kRingLen);
+
+    sockaddr_xdp addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sxdp_family = AF_XDP;
+    addr.sxdp_ifindex = ifindex;
+    addr.sxdp_queue_id = queueId;
+    addr.sxdp_flags = XDP_COPY;
+
+    // The kernel releases the queue of a previously closed socket
+    // asynchronously so give it a moment before giving up.
+    auto bindRetries = kBindRetries;
+    while (bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+      if (errno != EBUSY || bindRetries-- == 0) {
+        throw Exception::fromErrNo();
+      }
+      std::this_thread::sleep_for(kBindRetryDelay);
+    }
+
+    // Redirect the queue to the socket...
+    bpf_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(std::uint32_t);
+    attr.value_size = sizeof(std::uint32_t);
+    attr.max_entries = queueId + 1;
+    if ((mapFd_ = bpf(BPF_MAP_CREATE, attr)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    std::uint32_t key = queueId;
+    std::uint32_t value = fd_;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.map_fd = mapFd_;
+    attr.key = reinterpret_cast<std::uint64_t>(&key);
+    attr.value = reinterpret_cast<std::uint64_t>(&value);
+    if (bpf(BPF_MAP_UPDATE_ELEM, attr) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    if ((progFd_ = loadRedirectProgram(mapFd_)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // The program stays attached for as long as the link is open.
+    std::memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = progFd_;
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+    if ((linkFd_ = bpf(BPF_LINK_CREATE, attr)) == -1) {
+      throw Exception::fromErrNo();
+    }
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+AfXdp::~AfXdp() {
+  destroy();
+}
+
+std::size_t AfXdp::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t AfXdp::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b;
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, b.bufLen);
+  std::memcpy(buf, b.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t AfXdp::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  reclaim();
+
+  auto descs = static_cast<xdp_desc*>(tx_.descs);
+  auto producer = *tx_.producer;
+  auto free = kRingLen - (producer - loadAcquire(tx_.consumer));
+  auto count = std::min<std::size_t>({bufsLen, free, txFree_.size()});
+
+  std::size_t sent = 0;
+  for (; sent < count; sent++) {
+    auto& b = bufs[sent];
+    if (!b.buf || !b.bufLen) {
+      break;
+    } else if (b.bufLen > kChunkLen) {
+      throw Exception{"Frame is too large for a UMEM chunk."};
+    }
+
+    auto addr = txFree_.back();
+    txFree_.pop_back();
+    std::memcpy(umem_ + addr, b.buf, b.bufLen);
+
+    auto& desc = descs[(producer + sent) & tx_.mask];
+    desc.addr = addr;
+    desc.len = b.bufLen;
+    desc.options = 0;
+  }
+
+  if (sent == 0) {
+    return 0;
+  }
+
+  storeRelease(tx_.producer, producer + sent);
+
+  // Kick the kernel once for the whole batch.
+  if (sendto(fd_, nullptr, 0, MSG_DONTWAIT, nullptr, 0) == -1 &&
+      errno != EAGAIN && errno != EBUSY && errno != ENOBUFS) {
+    throw Exception::fromErrNo();
+  }
+
+  return sent;
+}
+
+std::size_t AfXdp::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  // Frames handed out by the previous batch are no longer in use.
+  refill();
+
+  auto descs = static_cast<xdp_desc*>(rx_.descs);
+  auto consumer = *rx_.consumer;
+  auto available = loadAcquire(rx_.producer) - consumer;
+  auto count = std::min<std::size_t>(bufsLen, available);
+
+  for (std::size_t i = 0; i < count; i++) {
+    auto& desc = descs[(consumer + i) & rx_.mask];
+    bufs[i].buf = umem_ + desc.addr;
+    bufs[i].bufLen = desc.len;
+    rxHeld_.push_back(desc.addr);
+  }
+
+  storeRelease(rx_.consumer, consumer + count);
+  return count;
+}
+
+std::size_t AfXdp::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+int AfXdp::pollFd() const {
+  return fd_;
+}
+
+void AfXdp::mapRing(Ring& ring, std::uint64_t pgoff, std::size_t descLen,
+                    const xdp_ring_offset& offsets) {
+  ring.mapLen = offsets.desc + kRingLen * descLen;
+  ring.map = mmap(nullptr, ring.mapLen, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd_, pgoff);
+  if (ring.map == MAP_FAILED) {
+    ring.map = nullptr;
+    throw Exception::fromErrNo();
+  }
+
+  auto base = static_cast<std::uint8_t*>(ring.map);
+  ring.producer = reinterpret_cast<std::uint32_t*>(base + offsets.producer);
+  ring.consumer = reinterpret_cast<std::uint32_t*>(base + offsets.consumer);
+  ring.descs = base + offsets.desc;
+  ring.mask = kRingLen - 1;
+}
+
+void AfXdp::refill() {
+  if (rxHeld_.empty()) {
+    return;
+  }
+
+  // The fill ring can hold every RX chunk so there is always room.
+  auto fill = static_cast<std::uint64_t*>(fill_.descs);
+  auto producer = *fill_.producer;
+  for (auto addr : rxHeld_) {
+    fill[producer++ & fill_.mask] = addr;
+  }
+
+  storeRelease(fill_.producer, producer);
+  rxHeld_.clear();
+}
+
+void AfXdp::reclaim() {
+  auto completion = static_cast<std::uint64_t*>(completion_.descs);
+  auto consumer = *completion_.consumer;
+  auto producer = loadAcquire(completion_.producer);
+  for (; consumer != producer; consumer++) {
+    txFree_.push_back(completion[consumer & completion_.mask]);
+  }
+
+  storeRelease(completion_.consumer, consumer);
+}
+
+void AfXdp::destroy() {
+  for (auto fd : {linkFd_, progFd_, mapFd_}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+
+  for (auto ring : {&rx_, &tx_, &fill_, &completion_}) {
+    if (ring->map) {
+      munmap(ring->map, ring->mapLen);
+    }
+  }
+
+  if (fd_ != -1) {
+    close(fd_);
+  }
+
+  if (umem_) {
+    munmap(umem_, kChunkLen * kChunkNr);
+  }
+}
+
+#else
+
+AfXdp::AfXdp(const std::string& name, std::uint32_t queueId) {
+  (void)name;
+  (void)queueId;
+  throw Exception{"AfXdp devices are supported only on Linux."};
+}
+
+AfXdp::~AfXdp() {}
+
+std::size_t AfXdp::send(const std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfXdp::read(std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfXdp::sendBatch(const DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfXdp::readBatch(DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t AfXdp::maxTransmissionUnit() const {
+  return 0;
+}
+
+int AfXdp::pollFd() const {
+  return -1;
+}
+
+void AfXdp::destroy() {}
+
+#endif
+
+}  // namespace unet
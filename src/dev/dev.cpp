@@ -0,0 +1,82 @@
+#include <unet/dev/dev.hpp>
+
+#include <cstring>
+
+#include <unet/detail/check.hpp>
+
+namespace unet {
+
+void completeChecksum(std::uint8_t* buf, std::size_t bufLen,
+                      DevOffload& offload) {
+  if (!offload.csumPartial) {
+    return;
+  }
+
+  // The checksum field holds the sum of the pseudo header so summing from
+  // csumStart through the field yields the full checksum.
+  std::size_t csumAt = offload.csumStart + offload.csumOffset;
+  if (csumAt + sizeof(std::uint16_t) <= bufLen) {
+    auto csum = detail::checksum(buf + offload.csumStart,
+                                 bufLen - offload.csumStart);
+    std::memcpy(buf + csumAt, &csum, sizeof(csum));
+  }
+
+  offload.csumPartial = false;
+}
+
+std::size_t frameLen(const DevBuf& b) {
+  auto len = b.bufLen;
+  for (std::size_t i = 0; i < b.segsLen; i++) {
+    len += b.segs[i].bufLen;
+  }
+  return len;
+}
+
+void gatherFrame(const DevBuf& b, std::uint8_t* dst) {
+  std::memcpy(dst, b.buf, b.bufLen);
+  dst += b.bufLen;
+  for (std::size_t i = 0; i < b.segsLen; i++) {
+    std::memcpy(dst, b.segs[i].buf, b.segs[i].bufLen);
+    dst += b.segs[i].bufLen;
+  }
+}
+
+std::size_t Dev::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  std::size_t count = 0;
+  while (count < bufsLen && send(bufs[count].buf, bufs[count].bufLen) > 0) {
+    count++;
+  }
+  return count;
+}
+
+std::size_t Dev::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  std::size_t count = 0;
+  while (count < bufsLen) {
+    auto r = read(bufs[count].buf, bufs[count].bufLen);
+    if (r == 0) {
+      break;
+    }
+    bufs[count++].bufLen = r;
+  }
+  return count;
+}
+
+std::size_t Dev::maxFrameLen() const {
+  return maxTransmissionUnit();
+}
+
+std::uint32_t Dev::offloads() const {
+  return 0;
+}
+
+void Dev::setTimerManager(std::shared_ptr<TimerManager>) {}
+
+int Dev::pollFd() const {
+  return -1;
+}
+
+bool Dev::prepareWait() {
+  return true;
+}
+
+}  // namespace unet
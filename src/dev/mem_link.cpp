@@ -0,0 +1,126 @@
+#include <unet/dev/mem_link.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+struct MemLink::Ring {
+  Ring(std::size_t slotLen, std::size_t slotNr)
+      : slotLen{slotLen},
+        slotNr{slotNr},
+        slots{std::make_unique<std::uint8_t[]>(slotLen * slotNr)},
+        lens{std::make_unique<std::size_t[]>(slotNr)} {}
+
+  std::uint8_t* slot(std::size_t i) {
+    return slots.get() + (i % slotNr) * slotLen;
+  }
+
+  const std::size_t slotLen;
+  const std::size_t slotNr;
+  std::unique_ptr<std::uint8_t[]> slots;
+  std::unique_ptr<std::size_t[]> lens;
+
+  // Keep the producer and consumer indices on separate cache lines so the two
+  // ends do not contend when driven from different threads.
+  std::atomic<std::size_t> producer{0};
+  std::uint8_t pad[64];
+  std::atomic<std::size_t> consumer{0};
+};
+
+std::pair<std::unique_ptr<MemLink>, std::unique_ptr<MemLink>> MemLink::makePair(
+    std::size_t maxTransmissionUnit, std::size_t ringLen) {
+  if (maxTransmissionUnit == 0) {
+    throw Exception{"MemLink cannot have an MTU of 0."};
+  } else if (ringLen == 0) {
+    throw Exception{"MemLink cannot have a ring length of 0."};
+  }
+
+  auto ab = std::make_shared<Ring>(maxTransmissionUnit, ringLen);
+  auto ba = std::make_shared<Ring>(maxTransmissionUnit, ringLen);
+  return {std::unique_ptr<MemLink>{new MemLink{maxTransmissionUnit, ab, ba}},
+          std::unique_ptr<MemLink>{new MemLink{maxTransmissionUnit, ba, ab}}};
+}
+
+MemLink::MemLink(std::size_t maxTransmissionUnit, std::shared_ptr<Ring> tx,
+                 std::shared_ptr<Ring> rx)
+    : maxTransmissionUnit_{maxTransmissionUnit}, tx_{tx}, rx_{rx} {}
+
+std::size_t MemLink::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t MemLink::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b;
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, b.bufLen);
+  std::memcpy(buf, b.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t MemLink::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  auto& ring = *tx_;
+  auto producer = ring.producer.load(std::memory_order_relaxed);
+  auto consumer = ring.consumer.load(std::memory_order_acquire);
+  auto free = ring.slotNr - (producer - consumer);
+
+  std::size_t count = 0;
+  for (; count < std::min(bufsLen, free); count++) {
+    auto& b = bufs[count];
+    auto len = frameLen(b);
+    if (!b.buf || !b.bufLen) {
+      break;
+    } else if (len > ring.slotLen) {
+      throw Exception{"Frame is too large for the link."};
+    }
+
+    gatherFrame(b, ring.slot(producer + count));
+    ring.lens[(producer + count) % ring.slotNr] = len;
+  }
+
+  ring.producer.store(producer + count, std::memory_order_release);
+  return count;
+}
+
+std::size_t MemLink::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  // Frames handed out by the previous batch are no longer in use.
+  release();
+
+  auto& ring = *rx_;
+  auto consumer = ring.consumer.load(std::memory_order_relaxed);
+  auto producer = ring.producer.load(std::memory_order_acquire);
+  auto count = std::min(bufsLen, producer - consumer);
+
+  for (std::size_t i = 0; i < count; i++) {
+    bufs[i].buf = ring.slot(consumer + i);
+    bufs[i].bufLen = ring.lens[(consumer + i) % ring.slotNr];
+  }
+
+  rxHeld_ = count;
+  return count;
+}
+
+std::size_t MemLink::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+std::uint32_t MemLink::offloads() const {
+  return dev_offload::kTxSg;
+}
+
+void MemLink::release() {
+  if (rxHeld_ > 0) {
+    auto consumer = rx_->consumer.load(std::memory_order_relaxed);
+    rx_->consumer.store(consumer + rxHeld_, std::memory_order_release);
+    rxHeld_ = 0;
+  }
+}
+
+}  // namespace unet
@@ -0,0 +1,277 @@
+#include <unet/dev/netem.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+// The max number of frames moved to or from the wrapped device at once.
+constexpr std::size_t kBatchLen = 32;
+
+// One direction of the link. Frames in flight are kept ordered by the time
+// they are due and their buffers are recycled to avoid allocating per frame.
+class Netem::Pipe {
+ public:
+  struct Pending {
+    std::vector<std::uint8_t> data;
+    DevOffload offload;
+  };
+
+  using Queue = std::multimap<std::chrono::steady_clock::time_point, Pending>;
+
+  explicit Pipe(const NetemParams& params) : params{params} {}
+
+  // Applies impairments to the frame and puts what is left of it in flight.
+  void push(const DevBuf& b, std::chrono::steady_clock::time_point now,
+            std::mt19937& rand) {
+    if (chance(params.loss, rand)) {
+      stats.lost++;
+      return;
+    }
+
+    auto copies = 1;
+    if (chance(params.duplicate, rand)) {
+      stats.duplicated++;
+      copies++;
+    }
+
+    for (auto i = 0; i < copies; i++) {
+      if (queue.size() >= params.queueLen) {
+        stats.overflowed++;
+        return;
+      }
+
+      auto at = now;
+      if (chance(params.reorder, rand)) {
+        stats.reordered++;
+      } else {
+        at += params.delay;
+        if (params.jitter.count() > 0) {
+          std::uniform_int_distribution<std::int64_t> jitter{
+              -params.jitter.count(), params.jitter.count()};
+          at = std::max(at + std::chrono::microseconds{jitter(rand)}, now);
+        }
+      }
+
+      // Frames are serialized onto a rate limited link one at a time.
+      auto bufLen = frameLen(b);
+      if (params.rate > 0) {
+        at = std::max(at, linkFreeAt) +
+             std::chrono::nanoseconds{bufLen * 1'000'000'000 / params.rate};
+        linkFreeAt = at;
+      }
+
+      std::vector<std::uint8_t> data;
+      if (!free.empty()) {
+        data = std::move(free.back());
+        free.pop_back();
+      }
+      data.resize(bufLen);
+      gatherFrame(b, data.data());
+      queue.emplace(at, Pending{std::move(data), b.offload});
+    }
+  }
+
+  // Return true if the first frame in flight is due.
+  bool isDue(std::chrono::steady_clock::time_point now) const {
+    return !queue.empty() && queue.begin()->first <= now;
+  }
+
+  // Takes the first frame out of flight and hands its buffer to held.
+  Pending& pop() {
+    held.push_back(std::move(queue.begin()->second));
+    queue.erase(queue.begin());
+    return held.back();
+  }
+
+  // Recycles buffers of held frames.
+  void release() {
+    for (auto& p : held) {
+      free.push_back(std::move(p.data));
+    }
+    held.clear();
+  }
+
+  // Schedules the timer for when the first frame in flight is due.
+  void schedule(std::chrono::steady_clock::time_point now) {
+    if (queue.empty()) {
+      timer->cancel();
+    } else {
+      timer->runAfter(std::max(queue.begin()->first - now,
+                               std::chrono::steady_clock::duration{0}));
+    }
+  }
+
+  const NetemParams params;
+  NetemStats stats;
+  Queue queue;
+  std::vector<Pending> held;
+  std::vector<std::vector<std::uint8_t>> free;
+  std::chrono::steady_clock::time_point linkFreeAt{};
+  std::unique_ptr<Timer> timer;
+
+ private:
+  static bool chance(double p, std::mt19937& rand) {
+    return p > 0 && std::uniform_real_distribution<double>{0, 1}(rand) < p;
+  }
+};
+
+Netem::Netem(std::unique_ptr<Dev> dev, const NetemParams& tx,
+             const NetemParams& rx, std::uint32_t seed)
+    : dev_{std::move(dev)},
+      rand_{seed},
+      tx_{std::make_unique<Pipe>(tx)},
+      rx_{std::make_unique<Pipe>(rx)} {
+  if (!dev_) {
+    throw Exception{"Netem needs a device to wrap."};
+  }
+}
+
+Netem::~Netem() {}
+
+std::size_t Netem::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t Netem::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b;
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, b.bufLen);
+  std::memcpy(buf, b.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t Netem::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  if (!manager_) {
+    throw Exception{"Netem needs a timer manager."};
+  }
+
+  // Frames lost in flight still count as sent.
+  auto now = manager_->now();
+  std::size_t count = 0;
+  for (; count < bufsLen && bufs[count].buf && bufs[count].bufLen; count++) {
+    tx_->push(bufs[count], now, rand_);
+  }
+
+  flushTx();
+  return count;
+}
+
+std::size_t Netem::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  if (!manager_) {
+    throw Exception{"Netem needs a timer manager."};
+  }
+
+  // Frames handed out by the previous batch are no longer in use.
+  rx_->release();
+
+  // Everything which arrived on the wrapped device is now in flight...
+  auto now = manager_->now();
+  DevBuf pulled[kBatchLen];
+  std::size_t n;
+  do {
+    n = dev_->readBatch(pulled, kBatchLen);
+    for (std::size_t i = 0; i < n; i++) {
+      rx_->push(pulled[i], now, rand_);
+    }
+  } while (n == kBatchLen);
+
+  std::size_t count = 0;
+  for (; count < bufsLen && rx_->isDue(now); count++) {
+    auto& p = rx_->pop();
+    bufs[count].buf = p.data.data();
+    bufs[count].bufLen = p.data.size();
+    bufs[count].offload = p.offload;
+  }
+
+  rx_->schedule(now);
+  return count;
+}
+
+std::size_t Netem::maxTransmissionUnit() const {
+  return dev_->maxTransmissionUnit();
+}
+
+std::size_t Netem::maxFrameLen() const {
+  return dev_->maxFrameLen();
+}
+
+std::uint32_t Netem::offloads() const {
+  // Frames are gathered once they are put in flight.
+  return dev_->offloads() | dev_offload::kTxSg;
+}
+
+void Netem::setTimerManager(std::shared_ptr<TimerManager> manager) {
+  manager_ = manager;
+  tx_->timer = std::make_unique<Timer>(*manager_, [this]() { flushTx(); });
+
+  // Frames read are released by the next read. The timer just makes sure the
+  // stack loop comes around by the time they are due.
+  rx_->timer = std::make_unique<Timer>(*manager_, []() {});
+
+  dev_->setTimerManager(std::move(manager));
+}
+
+int Netem::pollFd() const {
+  return dev_->pollFd();
+}
+
+bool Netem::prepareWait() {
+  // Frames in flight wake the stack up by way of the RX timer once it fires.
+  // A frame may also have come due after readBatch(...) went by the cached
+  // time of the timer manager and the timer already fired, in which case
+  // nothing would wake us.
+  if (rx_->isDue(std::chrono::steady_clock::now())) {
+    return false;
+  }
+  return dev_->prepareWait();
+}
+
+const NetemStats& Netem::txStats() const {
+  return tx_->stats;
+}
+
+const NetemStats& Netem::rxStats() const {
+  return rx_->stats;
+}
+
+void Netem::flushTx() {
+  auto now = manager_->now();
+  DevBuf bufs[kBatchLen];
+
+  while (tx_->isDue(now)) {
+    // Stage a batch of due frames w/o taking them out of flight yet.
+    std::size_t n = 0;
+    for (auto it = tx_->queue.begin();
+         n < kBatchLen && it != tx_->queue.end() && it->first <= now;
+         it++, n++) {
+      bufs[n].buf = it->second.data.data();
+      bufs[n].bufLen = it->second.data.size();
+      bufs[n].offload = it->second.offload;
+    }
+
+    auto sent = dev_->sendBatch(bufs, n);
+    for (std::size_t i = 0; i < sent; i++) {
+      tx_->pop();
+    }
+    tx_->release();
+
+    if (sent < n) {
+      // The wrapped device is exhausted so try again on the next loop.
+      tx_->timer->runAfter(std::chrono::steady_clock::duration{0});
+      return;
+    }
+  }
+
+  tx_->schedule(now);
+}
+
+}  // namespace unet
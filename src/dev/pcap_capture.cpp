@@ -0,0 +1,114 @@
+#include <unet/dev/pcap_capture.hpp>
+
+#include <chrono>
+
+#include <unet/detail/pcap.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+PcapCapture::PcapCapture(std::unique_ptr<Dev> dev, const std::string& path)
+    : dev_{std::move(dev)} {
+  if (!dev_) {
+    throw Exception{"PcapCapture needs a device to wrap."};
+  } else if (!(file_ = std::fopen(path.c_str(), "wb"))) {
+    throw Exception::fromErrNo();
+  }
+
+  detail::PcapHeader header{};
+  header.magic = detail::kPcapMagicNsec;
+  header.versionMajor = 2;
+  header.versionMinor = 4;
+  header.snapLen = dev_->maxFrameLen();
+  header.linkType = detail::kPcapLinkTypeEthernet;
+  if (std::fwrite(&header, sizeof(header), 1, file_) != 1) {
+    std::fclose(file_);
+    throw Exception{"Failed to write the pcap header."};
+  }
+}
+
+PcapCapture::~PcapCapture() {
+  std::fclose(file_);
+}
+
+std::size_t PcapCapture::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t PcapCapture::read(std::uint8_t* buf, std::size_t bufLen) {
+  return dev_->read(buf, bufLen);
+}
+
+std::size_t PcapCapture::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  auto sent = dev_->sendBatch(bufs, bufsLen);
+  write(bufs, sent);
+  return sent;
+}
+
+std::size_t PcapCapture::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  return dev_->readBatch(bufs, bufsLen);
+}
+
+std::size_t PcapCapture::maxTransmissionUnit() const {
+  return dev_->maxTransmissionUnit();
+}
+
+std::size_t PcapCapture::maxFrameLen() const {
+  return dev_->maxFrameLen();
+}
+
+std::uint32_t PcapCapture::offloads() const {
+  return dev_->offloads();
+}
+
+void PcapCapture::setTimerManager(std::shared_ptr<TimerManager> manager) {
+  dev_->setTimerManager(std::move(manager));
+}
+
+int PcapCapture::pollFd() const {
+  return dev_->pollFd();
+}
+
+bool PcapCapture::prepareWait() {
+  return dev_->prepareWait();
+}
+
+void PcapCapture::flush() {
+  if (std::fflush(file_) != 0) {
+    throw Exception::fromErrNo();
+  }
+}
+
+void PcapCapture::write(const DevBuf* bufs, std::size_t bufsLen) {
+  if (bufsLen == 0) {
+    return;
+  }
+
+  // Frames of the same batch share a timestamp.
+  auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count();
+
+  for (std::size_t i = 0; i < bufsLen; i++) {
+    auto& b = bufs[i];
+    detail::PcapRecordHeader record;
+    record.tsSec = now / 1'000'000'000;
+    record.tsFrac = now % 1'000'000'000;
+    record.capLen = frameLen(b);
+    record.origLen = record.capLen;
+    if (std::fwrite(&record, sizeof(record), 1, file_) != 1 ||
+        std::fwrite(b.buf, b.bufLen, 1, file_) != 1) {
+      throw Exception::fromErrNo();
+    }
+
+    for (std::size_t j = 0; j < b.segsLen; j++) {
+      auto& seg = b.segs[j];
+      if (seg.bufLen && std::fwrite(seg.buf, seg.bufLen, 1, file_) != 1) {
+        throw Exception::fromErrNo();
+      }
+    }
+  }
+}
+
+}  // namespace unet
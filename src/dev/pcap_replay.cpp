@@ -0,0 +1,325 @@
+#include <unet/dev/pcap_replay.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include <boost/endian/conversion.hpp>
+
+#include <unet/detail/pcap.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+// The MTU of a replay w/o any frames.
+constexpr std::size_t kDefaultMaxTransmissionUnit = 1'500;
+
+// The type, length and trailing length of a pcapng block.
+constexpr std::size_t kPcapngBlockOverhead = 12;
+
+// The default pcapng timestamp resolution is microseconds.
+constexpr std::uint8_t kPcapngDefaultTsResol = 6;
+
+struct PcapngInterface {
+  bool ethernet;
+  std::uint32_t snapLen;
+  std::uint8_t tsResol;
+};
+
+template <typename T>
+static T load(const std::uint8_t* p, bool swap) {
+  T x;
+  std::memcpy(&x, p, sizeof(x));
+  return swap ? boost::endian::endian_reverse(x) : x;
+}
+
+static Exception malformed() {
+  return Exception{"Malformed pcap file."};
+}
+
+// Return a pcapng timestamp in units of 10^-tsResol seconds or, if the MSB of
+// tsResol is set, 2^-tsResol seconds as nanoseconds.
+static std::chrono::nanoseconds toNanos(std::uint64_t ts,
+                                        std::uint8_t tsResol) {
+  std::uint8_t exp = tsResol & 0x7f;
+  if (tsResol & 0x80) {
+    return std::chrono::nanoseconds{
+        static_cast<std::int64_t>(std::ldexp(ts, -exp) * 1e9)};
+  }
+
+  std::uint64_t scale = 1;
+  for (auto i = std::min<int>(exp, 9); i < std::max<int>(exp, 9); i++) {
+    scale *= 10;
+  }
+  return std::chrono::nanoseconds{exp <= 9 ? ts * scale : ts / scale};
+}
+
+PcapReplay::PcapReplay(const std::string& path, bool realTime)
+    : realTime_{realTime} {
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    throw Exception::fromErrNo();
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    auto err = errno;
+    close(fd);
+    errno = err;
+    throw Exception::fromErrNo();
+  } else if (st.st_size == 0) {
+    close(fd);
+    throw malformed();
+  }
+
+  // Frames are processed in place so map them privately and writable.
+  mapLen_ = st.st_size;
+  auto p = mmap(nullptr, mapLen_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  auto err = errno;
+  close(fd);
+  if (p == MAP_FAILED) {
+    errno = err;
+    throw Exception::fromErrNo();
+  }
+  map_ = static_cast<std::uint8_t*>(p);
+
+  try {
+    auto pcapng = mapLen_ >= sizeof(std::uint32_t) &&
+                  load<std::uint32_t>(map_, false) ==
+                      detail::pcapng_block::kSectionHeader;
+    if (pcapng) {
+      indexPcapng();
+    } else {
+      indexPcap();
+    }
+  } catch (...) {
+    munmap(map_, mapLen_);
+    throw;
+  }
+
+  if (maxTransmissionUnit_ == 0) {
+    maxTransmissionUnit_ = kDefaultMaxTransmissionUnit;
+  }
+}
+
+PcapReplay::~PcapReplay() {
+  munmap(map_, mapLen_);
+}
+
+std::size_t PcapReplay::send(const std::uint8_t*, std::size_t bufLen) {
+  return bufLen;
+}
+
+std::size_t PcapReplay::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b;
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, b.bufLen);
+  std::memcpy(buf, b.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t PcapReplay::sendBatch(const DevBuf*, std::size_t bufsLen) {
+  return bufsLen;
+}
+
+std::size_t PcapReplay::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  if (next_ == records_.size()) {
+    return 0;
+  }
+
+  // Pace frames relative to the first read.
+  auto elapsed = std::chrono::steady_clock::duration::max();
+  if (realTime_) {
+    auto now = std::chrono::steady_clock::now();
+    if (!started_) {
+      started_ = true;
+      startedAt_ = now;
+    }
+    elapsed = now - startedAt_;
+  }
+
+  std::size_t count = 0;
+  for (; count < bufsLen && next_ < records_.size(); count++, next_++) {
+    auto& r = records_[next_];
+    if (r.ts - records_.front().ts > elapsed) {
+      break;
+    }
+
+    bufs[count].buf = r.data;
+    bufs[count].bufLen = r.len;
+    bufs[count].offload = DevOffload{};
+  }
+
+  return count;
+}
+
+std::size_t PcapReplay::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+std::size_t PcapReplay::frameCount() const {
+  return records_.size();
+}
+
+bool PcapReplay::done() const {
+  return next_ == records_.size();
+}
+
+void PcapReplay::rewind() {
+  next_ = 0;
+  started_ = false;
+}
+
+void PcapReplay::indexPcap() {
+  if (mapLen_ < sizeof(detail::PcapHeader)) {
+    throw malformed();
+  }
+
+  auto magic = load<std::uint32_t>(map_, false);
+  auto swap = magic == boost::endian::endian_reverse(detail::kPcapMagicUsec) ||
+              magic == boost::endian::endian_reverse(detail::kPcapMagicNsec);
+  auto nsec = load<std::uint32_t>(map_, swap) == detail::kPcapMagicNsec;
+  if (!nsec && load<std::uint32_t>(map_, swap) != detail::kPcapMagicUsec) {
+    throw Exception{"Unknown capture file format."};
+  } else if (load<std::uint32_t>(map_ + offsetof(detail::PcapHeader, linkType),
+                                 swap) != detail::kPcapLinkTypeEthernet) {
+    throw Exception{"Only Ethernet captures can be replayed."};
+  }
+
+  for (auto off = sizeof(detail::PcapHeader); off < mapLen_;) {
+    if (mapLen_ - off < sizeof(detail::PcapRecordHeader)) {
+      throw malformed();
+    }
+
+    auto p = map_ + off;
+    auto sec = load<std::uint32_t>(p, swap);
+    auto frac = load<std::uint32_t>(p + 4, swap);
+    auto capLen = load<std::uint32_t>(p + 8, swap);
+    off += sizeof(detail::PcapRecordHeader);
+    if (capLen > mapLen_ - off) {
+      throw malformed();
+    }
+
+    auto ts = std::chrono::seconds{sec} +
+              (nsec ? std::chrono::nanoseconds{frac}
+                    : std::chrono::microseconds{frac});
+    records_.push_back(Record{map_ + off, capLen, ts});
+    maxTransmissionUnit_ = std::max<std::size_t>(maxTransmissionUnit_, capLen);
+    off += capLen;
+  }
+}
+
+void PcapReplay::indexPcapng() {
+  auto swap = false;
+  std::vector<PcapngInterface> interfaces;
+  std::chrono::nanoseconds lastTs{0};
+
+  for (std::size_t off = 0; off < mapLen_;) {
+    if (mapLen_ - off < kPcapngBlockOverhead) {
+      throw malformed();
+    }
+
+    // Each section declares its own byte order. The section header block type
+    // reads the same in either.
+    auto p = map_ + off;
+    auto type = load<std::uint32_t>(p, swap);
+    if (type == detail::pcapng_block::kSectionHeader) {
+      if (mapLen_ - off < kPcapngBlockOverhead + sizeof(std::uint32_t)) {
+        throw malformed();
+      }
+
+      auto magic = load<std::uint32_t>(p + 8, false);
+      if (magic == detail::kPcapngByteOrderMagic) {
+        swap = false;
+      } else if (magic ==
+                 boost::endian::endian_reverse(detail::kPcapngByteOrderMagic)) {
+        swap = true;
+      } else {
+        throw malformed();
+      }
+      interfaces.clear();
+    }
+
+    std::size_t len = load<std::uint32_t>(p + 4, swap);
+    if (len < kPcapngBlockOverhead || len % 4 != 0 || len > mapLen_ - off) {
+      throw malformed();
+    }
+
+    auto body = p + 8;
+    auto bodyLen = len - kPcapngBlockOverhead;
+
+    if (type == detail::pcapng_block::kInterfaceDesc) {
+      if (bodyLen < 8) {
+        throw malformed();
+      }
+
+      PcapngInterface iface{
+          load<std::uint16_t>(body, swap) == detail::kPcapLinkTypeEthernet,
+          load<std::uint32_t>(body + 4, swap), kPcapngDefaultTsResol};
+
+      // Look for the timestamp resolution among the options...
+      for (std::size_t opt = 8; opt + 4 <= bodyLen;) {
+        auto code = load<std::uint16_t>(body + opt, swap);
+        std::size_t optLen = load<std::uint16_t>(body + opt + 2, swap);
+        if (code == detail::kPcapngOptEnd) {
+          break;
+        } else if (optLen > bodyLen - opt - 4) {
+          throw malformed();
+        } else if (code == detail::kPcapngOptTsResol && optLen >= 1) {
+          iface.tsResol = body[opt + 4];
+        }
+        opt += 4 + (optLen + 3) / 4 * 4;
+      }
+
+      interfaces.push_back(iface);
+    } else if (type == detail::pcapng_block::kEnhancedPacket) {
+      if (bodyLen < 20) {
+        throw malformed();
+      }
+
+      auto id = load<std::uint32_t>(body, swap);
+      std::uint64_t ts = load<std::uint32_t>(body + 4, swap);
+      ts = ts << 32 | load<std::uint32_t>(body + 8, swap);
+      auto capLen = load<std::uint32_t>(body + 12, swap);
+      if (id >= interfaces.size() || capLen > bodyLen - 20) {
+        throw malformed();
+      }
+
+      lastTs = toNanos(ts, interfaces[id].tsResol);
+      if (interfaces[id].ethernet) {
+        records_.push_back(Record{body + 20, capLen, lastTs});
+        maxTransmissionUnit_ =
+            std::max<std::size_t>(maxTransmissionUnit_, capLen);
+      }
+    } else if (type == detail::pcapng_block::kSimplePacket) {
+      if (bodyLen < 4 || interfaces.empty()) {
+        throw malformed();
+      }
+
+      // Simple packets belong to the first interface and have no timestamp.
+      std::size_t capLen = load<std::uint32_t>(body, swap);
+      capLen = std::min(capLen, bodyLen - 4);
+      if (interfaces[0].snapLen > 0) {
+        capLen = std::min<std::size_t>(capLen, interfaces[0].snapLen);
+      }
+
+      if (interfaces[0].ethernet) {
+        records_.push_back(Record{body + 4, capLen, lastTs});
+        maxTransmissionUnit_ = std::max(maxTransmissionUnit_, capLen);
+      }
+    }
+
+    off += len;
+  }
+}
+
+}  // namespace unet
@@ -0,0 +1,422 @@
+#include <unet/dev/shm_link.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+// Both processes access the rings through atomics so these must not fall back
+// to process local locks.
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2,
+              "ShmLink requires lock free atomics.");
+
+constexpr std::uint64_t kMagic = 0x6b6e696c6d687375;  // "ushmlink"
+constexpr std::size_t kCacheLineLen = 64;
+
+static std::size_t roundUp(std::size_t len) {
+  return (len + kCacheLineLen - 1) / kCacheLineLen * kCacheLineLen;
+}
+
+// Describes the layout of the region and is written once by makePair(...).
+struct alignas(kCacheLineLen) ShmLink::Header {
+  std::uint64_t magic;
+  std::uint64_t maxTransmissionUnit;
+  std::uint64_t ringLen;
+
+  // Return the length of the region of a link w/the provided geometry.
+  static std::size_t regionLen(std::size_t maxTransmissionUnit,
+                               std::size_t ringLen);
+};
+
+// The control block of a ring followed by the lengths and slots of its frames.
+// The geometry is passed in from the validated copy of the attaching end since
+// the peer can rewrite the region at any time.
+struct ShmLink::Ring {
+  static std::size_t len(std::size_t slotLen, std::size_t slotNr) {
+    return roundUp(sizeof(Ring) + slotNr * sizeof(std::uint32_t)) +
+           roundUp(slotLen) * slotNr;
+  }
+
+  Ring(std::size_t slotLen, std::size_t slotNr)
+      : slotLen{slotLen}, slotNr{slotNr} {}
+
+  std::uint32_t& frameLen(std::uint64_t i, std::size_t ringLen) {
+    return reinterpret_cast<std::uint32_t*>(this + 1)[i % ringLen];
+  }
+
+  std::uint8_t* slot(std::uint64_t i, std::size_t mtu, std::size_t ringLen) {
+    auto slots = reinterpret_cast<std::uint8_t*>(this) +
+                 roundUp(sizeof(Ring) + ringLen * sizeof(std::uint32_t));
+    return slots + (i % ringLen) * roundUp(mtu);
+  }
+
+  const std::uint64_t slotLen;
+  const std::uint64_t slotNr;
+
+  // Keep the producer and consumer indices on separate cache lines so the two
+  // processes do not contend.
+  alignas(kCacheLineLen) std::atomic<std::uint64_t> producer{0};
+  alignas(kCacheLineLen) std::atomic<std::uint64_t> consumer{0};
+
+  // Set while the consumer is blocked in wait(...).
+  std::atomic<std::uint32_t> waiting{0};
+};
+
+std::size_t ShmLink::Header::regionLen(std::size_t maxTransmissionUnit,
+                                       std::size_t ringLen) {
+  return sizeof(Header) + 2 * Ring::len(maxTransmissionUnit, ringLen);
+}
+
+#ifdef __linux__
+
+// The seals every region must carry.
+constexpr int kSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL;
+
+static void closeFds(const ShmLink::Fds& fds) {
+  for (auto fd : {fds.mem, fds.rxEvent, fds.txEvent}) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+std::pair<std::unique_ptr<ShmLink>, std::unique_ptr<ShmLink>> ShmLink::makePair(
+    std::size_t maxTransmissionUnit, std::size_t ringLen) {
+  if (maxTransmissionUnit == 0) {
+    throw Exception{"ShmLink cannot have an MTU of 0."};
+  } else if (ringLen == 0) {
+    throw Exception{"ShmLink cannot have a ring length of 0."};
+  }
+
+  auto len = Header::regionLen(maxTransmissionUnit, ringLen);
+  Fds a;
+  try {
+    // Seal the size of the region so a peer can not shrink it from under the
+    // mapping of the other end.
+    if ((a.mem = memfd_create("unet-shm-link",
+                              MFD_CLOEXEC | MFD_ALLOW_SEALING)) == -1 ||
+        ftruncate(a.mem, len) == -1 ||
+        fcntl(a.mem, F_ADD_SEALS, kSeals) == -1 ||
+        (a.rxEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1 ||
+        (a.txEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    auto p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, a.mem, 0);
+    if (p == MAP_FAILED) {
+      throw Exception::fromErrNo();
+    }
+
+    auto region = static_cast<std::uint8_t*>(p);
+    auto ringOffset = Ring::len(maxTransmissionUnit, ringLen);
+    new (region + sizeof(Header)) Ring{maxTransmissionUnit, ringLen};
+    new (region + sizeof(Header) + ringOffset)
+        Ring{maxTransmissionUnit, ringLen};
+    new (region) Header{kMagic, maxTransmissionUnit, ringLen};
+    munmap(p, len);
+  } catch (...) {
+    closeFds(a);
+    throw;
+  }
+
+  std::unique_ptr<ShmLink> first{new ShmLink{a}};
+
+  // The second end reads what the first end sends and vice versa.
+  Fds b;
+  b.end = 1;
+  if ((b.mem = fcntl(a.mem, F_DUPFD_CLOEXEC, 0)) == -1 ||
+      (b.rxEvent = fcntl(a.txEvent, F_DUPFD_CLOEXEC, 0)) == -1 ||
+      (b.txEvent = fcntl(a.rxEvent, F_DUPFD_CLOEXEC, 0)) == -1) {
+    auto err = errno;
+    closeFds(b);
+    errno = err;
+    throw Exception::fromErrNo();
+  }
+
+  return {std::move(first), attach(b)};
+}
+
+std::unique_ptr<ShmLink> ShmLink::attach(const Fds& fds) {
+  return std::unique_ptr<ShmLink>{new ShmLink{fds}};
+}
+
+ShmLink::ShmLink(const Fds& fds) : fds_{fds} {
+  try {
+    // Only a region whose size is sealed is safe to map.
+    struct stat st;
+    int seals;
+    if (fstat(fds_.mem, &st) == -1) {
+      throw Exception::fromErrNo();
+    } else if ((seals = fcntl(fds_.mem, F_GET_SEALS)) == -1 ||
+               (seals & kSeals) != kSeals) {
+      throw Exception{"ShmLink region is not sealed."};
+    } else if (fds_.end > 1 ||
+               static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+      throw Exception{"Invalid ShmLink region."};
+    }
+
+    mapLen_ = st.st_size;
+    if ((map_ = mmap(nullptr, mapLen_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fds_.mem, 0)) == MAP_FAILED) {
+      map_ = nullptr;
+      throw Exception::fromErrNo();
+    }
+
+    // Validate a copy of the geometry once so the peer can not point us
+    // outside of the region by rewriting it later. The bounds keep the length
+    // of the region from overflowing.
+    auto region = static_cast<std::uint8_t*>(map_);
+    auto header = *reinterpret_cast<const Header*>(region);
+    if (header.magic != kMagic || header.maxTransmissionUnit == 0 ||
+        header.maxTransmissionUnit > UINT32_MAX ||
+        header.maxTransmissionUnit > mapLen_ || header.ringLen == 0 ||
+        header.ringLen > mapLen_ / roundUp(header.maxTransmissionUnit) ||
+        Header::regionLen(header.maxTransmissionUnit, header.ringLen) >
+            mapLen_) {
+      throw Exception{"Invalid ShmLink region."};
+    }
+
+    maxTransmissionUnit_ = header.maxTransmissionUnit;
+    ringLen_ = header.ringLen;
+    auto ringOffset = Ring::len(maxTransmissionUnit_, ringLen_);
+    auto rings = region + sizeof(Header);
+    tx_ = reinterpret_cast<Ring*>(rings + fds_.end * ringOffset);
+    rx_ = reinterpret_cast<Ring*>(rings + (1 - fds_.end) * ringOffset);
+    for (auto ring : {tx_, rx_}) {
+      if (ring->slotLen != maxTransmissionUnit_ || ring->slotNr != ringLen_) {
+        throw Exception{"Invalid ShmLink region."};
+      }
+    }
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+ShmLink::~ShmLink() {
+  destroy();
+}
+
+std::size_t ShmLink::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t ShmLink::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b;
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+
+  auto copyLen = std::min(bufLen, b.bufLen);
+  std::memcpy(buf, b.buf, copyLen);
+  return copyLen;
+}
+
+std::size_t ShmLink::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  auto& ring = *tx_;
+  auto producer = ring.producer.load(std::memory_order_relaxed);
+  auto consumer = ring.consumer.load(std::memory_order_acquire);
+  auto free = ringLen_ - std::min<std::uint64_t>(producer - consumer, ringLen_);
+
+  std::size_t count = 0;
+  for (; count < std::min<std::size_t>(bufsLen, free); count++) {
+    auto& b = bufs[count];
+    if (!b.buf || !b.bufLen) {
+      break;
+    } else if (b.bufLen > maxTransmissionUnit_) {
+      throw Exception{"Frame is too large for the link."};
+    }
+
+    std::memcpy(ring.slot(producer + count, maxTransmissionUnit_, ringLen_),
+                b.buf, b.bufLen);
+    ring.frameLen(producer + count, ringLen_) = b.bufLen;
+  }
+
+  if (count > 0) {
+    ring.producer.store(producer + count, std::memory_order_release);
+    notify();
+  }
+  return count;
+}
+
+std::size_t ShmLink::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  // Frames handed out by the previous batch are no longer in use.
+  release();
+
+  // Any wait ended before this read so the peer no longer needs to wake us.
+  auto& ring = *rx_;
+  if (ring.waiting.load(std::memory_order_relaxed)) {
+    ring.waiting.store(0, std::memory_order_relaxed);
+  }
+
+  auto consumer = ring.consumer.load(std::memory_order_relaxed);
+  auto producer = ring.producer.load(std::memory_order_acquire);
+  auto count = std::min<std::uint64_t>(
+      {bufsLen, producer - consumer, static_cast<std::uint64_t>(ringLen_)});
+
+  for (std::size_t i = 0; i < count; i++) {
+    // Never trust a length written by another process.
+    bufs[i].buf = ring.slot(consumer + i, maxTransmissionUnit_, ringLen_);
+    bufs[i].bufLen = std::min<std::size_t>(
+        ring.frameLen(consumer + i, ringLen_), maxTransmissionUnit_);
+  }
+
+  rxHeld_ = count;
+  return count;
+}
+
+std::size_t ShmLink::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+int ShmLink::pollFd() const {
+  return fds_.rxEvent;
+}
+
+bool ShmLink::prepareWait() {
+  if (ready()) {
+    return false;
+  }
+
+  // Announce we are about to block before checking the ring one last time.
+  // This pairs w/the fence in notify(...) so a frame sent concurrently is
+  // either seen here or wakes us up.
+  rx_->waiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  std::uint64_t n;
+  while (::read(fds_.rxEvent, &n, sizeof(n)) > 0) {
+  }
+
+  return !ready();
+}
+
+bool ShmLink::wait(int timeoutMs) {
+  if (prepareWait()) {
+    pollfd pfd{fds_.rxEvent, POLLIN, 0};
+    if (poll(&pfd, 1, timeoutMs) == -1 && errno != EINTR) {
+      rx_->waiting.store(0, std::memory_order_relaxed);
+      throw Exception::fromErrNo();
+    }
+  }
+
+  rx_->waiting.store(0, std::memory_order_relaxed);
+  return ready();
+}
+
+const ShmLink::Fds& ShmLink::fds() const {
+  return fds_;
+}
+
+void ShmLink::destroy() {
+  if (map_) {
+    munmap(map_, mapLen_);
+  }
+  closeFds(fds_);
+}
+
+void ShmLink::release() {
+  if (rxHeld_ > 0) {
+    auto consumer = rx_->consumer.load(std::memory_order_relaxed);
+    rx_->consumer.store(consumer + rxHeld_, std::memory_order_release);
+    rxHeld_ = 0;
+  }
+}
+
+void ShmLink::notify() {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (tx_->waiting.load(std::memory_order_relaxed) &&
+      tx_->waiting.exchange(0, std::memory_order_relaxed)) {
+    std::uint64_t one = 1;
+    if (write(fds_.txEvent, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+      throw Exception::fromErrNo();
+    }
+  }
+}
+
+bool ShmLink::ready() const {
+  return rx_->producer.load(std::memory_order_acquire) !=
+         rx_->consumer.load(std::memory_order_relaxed) + rxHeld_;
+}
+
+#else
+
+std::pair<std::unique_ptr<ShmLink>, std::unique_ptr<ShmLink>> ShmLink::makePair(
+    std::size_t, std::size_t) {
+  throw Exception{"ShmLink devices are supported only on Linux."};
+}
+
+std::unique_ptr<ShmLink> ShmLink::attach(const Fds&) {
+  throw Exception{"ShmLink devices are supported only on Linux."};
+}
+
+ShmLink::ShmLink(const Fds& fds) : fds_{fds} {}
+
+ShmLink::~ShmLink() {}
+
+std::size_t ShmLink::send(const std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t ShmLink::read(std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t ShmLink::sendBatch(const DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t ShmLink::readBatch(DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t ShmLink::maxTransmissionUnit() const {
+  return 0;
+}
+
+int ShmLink::pollFd() const {
+  return -1;
+}
+
+bool ShmLink::prepareWait() {
+  return true;
+}
+
+bool ShmLink::wait(int) {
+  return false;
+}
+
+const ShmLink::Fds& ShmLink::fds() const {
+  return fds_;
+}
+
+void ShmLink::destroy() {}
+
+void ShmLink::release() {}
+
+void ShmLink::notify() {}
+
+bool ShmLink::ready() const {
+  return false;
+}
+
+#endif
+
+}  // namespace unet
@@ -6,6 +6,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #ifdef __linux__
@@ -16,10 +17,33 @@
 #include <cstring>
 
 #include <unet/exception.hpp>
+#include <unet/wire/ethernet.hpp>
+#include <unet/wire/wire.hpp>
 
 namespace unet {
 
-Tap::Tap(const std::string& name) {
+// Mirrors the virtio-net header which prefixes each frame w/offloads. The TAP
+// uses native byte order for it.
+struct UNET_PACK VnetHdr {
+  std::uint8_t flags;
+  std::uint8_t gsoType;
+  std::uint16_t hdrLen;
+  std::uint16_t gsoSize;
+  std::uint16_t csumStart;
+  std::uint16_t csumOffset;
+};
+
+UNET_ASSERT_SIZE(VnetHdr, 10);
+
+constexpr std::uint8_t kVnetHdrNeedsCsum = 1;
+constexpr std::uint8_t kVnetHdrDataValid = 2;
+
+// The largest frame the kernel coalesces for us w/offloads.
+constexpr std::size_t kMaxGsoFrameLen = sizeof(EthernetHeader) + 65'535;
+
+Tap::Tap(const std::string& name, bool offloads) : Tap{name, offloads, false} {}
+
+Tap::Tap(const std::string& name, bool offloads, bool multiQueue) {
 #ifdef __linux__
   if (name.size() >= IFNAMSIZ) {
     throw Exception{"Interface name should be < IFNAMSIZ."};
@@ -32,12 +56,21 @@ Tap::Tap(const std::string& name) {
 
   ifreq ifr;
   std::strncpy(ifr.ifr_name, name.data(), IFNAMSIZ);
-  ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI | (offloads ? IFF_VNET_HDR : 0) |
+                  (multiQueue ? IFF_MULTI_QUEUE : 0);
   if (ioctl(fd_, TUNSETIFF, &ifr) == -1) {
     close(fd_);
     throw Exception::fromErrNo();
   }
 
+  // Let the kernel hand us frames w/partial checksums and coalesced TCP/IPv4
+  // frames...
+  if (offloads && ioctl(fd_, TUNSETOFFLOAD, TUN_F_CSUM | TUN_F_TSO4) == -1) {
+    close(fd_);
+    throw Exception::fromErrNo();
+  }
+  vnetHdr_ = offloads;
+
   // Query MTU...
   auto sockfd = socket(AF_INET, SOCK_DGRAM, 0);
   if (sockfd == -1) {
@@ -60,6 +93,8 @@ Tap::Tap(const std::string& name) {
 
 #else
   (void)name;
+  (void)offloads;
+  (void)multiQueue;
   throw Exception{"Tap devices are supported only on Linux."};
 #endif
 }
@@ -70,38 +105,149 @@ Tap::~Tap() {
   }
 }
 
-std::size_t Tap::send(const std::uint8_t* buf, std::size_t bufLen) {
-  if (!buf || !bufLen) {
-    return 0;
+std::vector<std::unique_ptr<Tap>> Tap::makeQueues(const std::string& name,
+                                                  std::size_t queueNr,
+                                                  bool offloads) {
+  if (queueNr == 0) {
+    throw Exception{"Tap needs at least 1 queue."};
   }
 
-  auto w = write(fd_, buf, bufLen);
+  // Each open of a multi-queue interface attaches another queue.
+  std::vector<std::unique_ptr<Tap>> queues;
+  queues.reserve(queueNr);
+  for (std::size_t i = 0; i < queueNr; i++) {
+    queues.push_back(std::unique_ptr<Tap>{new Tap{name, offloads, true}});
+  }
+  return queues;
+}
+
+static VnetHdr toVnetHdr(const DevOffload& offload) {
+  VnetHdr hdr{};
+  if (offload.csumPartial) {
+    hdr.flags = kVnetHdrNeedsCsum;
+    hdr.csumStart = offload.csumStart;
+    hdr.csumOffset = offload.csumOffset;
+  }
+  hdr.gsoType = offload.gsoType;
+  hdr.hdrLen = offload.hdrLen;
+  hdr.gsoSize = offload.gsoSize;
+  return hdr;
+}
+
+static DevOffload fromVnetHdr(const VnetHdr& hdr) {
+  DevOffload offload;
+  offload.csumPartial = hdr.flags & kVnetHdrNeedsCsum;
+  offload.csumValid = hdr.flags & kVnetHdrDataValid;
+  offload.gsoType = hdr.gsoType;
+  offload.gsoSize = hdr.gsoSize;
+  offload.hdrLen = hdr.hdrLen;
+  offload.csumStart = hdr.csumStart;
+  offload.csumOffset = hdr.csumOffset;
+  return offload;
+}
+
+// Writes a frame to the TAP, prefixed w/a virtio-net header if vnetHdr is set.
+// Payload segments are gathered by the kernel. Return 0 if the TAP is
+// exhausted.
+static std::size_t tapWrite(int fd, bool vnetHdr, const DevBuf& b) {
+  auto hdr = toVnetHdr(b.offload);
+  iovec iov[2 + kDevMaxSegs]{{&hdr, sizeof(hdr)}, {b.buf, b.bufLen}};
+  for (std::size_t i = 0; i < b.segsLen; i++) {
+    iov[2 + i] = {const_cast<std::uint8_t*>(b.segs[i].buf), b.segs[i].bufLen};
+  }
+
+  auto w = vnetHdr ? writev(fd, iov, 2 + b.segsLen)
+                   : writev(fd, iov + 1, 1 + b.segsLen);
   if (w < 0 && errno == EAGAIN) {
     return 0;
   } else if (w < 0) {
     throw Exception::fromErrNo();
   } else {
-    return w;
+    return vnetHdr ? w - sizeof(hdr) : w;
   }
 }
 
-std::size_t Tap::read(std::uint8_t* buf, std::size_t bufLen) {
-  if (!buf || !bufLen) {
-    return 0;
-  }
+// Reads a frame from the TAP, stripping the virtio-net header into the offload
+// metadata if vnetHdr is set. Return 0 if the TAP is exhausted.
+static std::size_t tapRead(int fd, bool vnetHdr, DevBuf& b) {
+  VnetHdr hdr{};
+  iovec iov[2]{{&hdr, sizeof(hdr)}, {b.buf, b.bufLen}};
 
-  auto r = ::read(fd_, buf, bufLen);
+  auto r = vnetHdr ? readv(fd, iov, 2) : ::read(fd, b.buf, b.bufLen);
   if (r < 0 && errno == EAGAIN) {
     return 0;
   } else if (r < 0) {
     throw Exception::fromErrNo();
-  } else {
+  } else if (!vnetHdr) {
     return r;
+  } else if (static_cast<std::size_t>(r) <= sizeof(hdr)) {
+    throw Exception{"Tap read a frame w/o a virtio-net header."};
   }
+
+  b.offload = fromVnetHdr(hdr);
+  return r - sizeof(hdr);
+}
+
+std::size_t Tap::send(const std::uint8_t* buf, std::size_t bufLen) {
+  if (!buf || !bufLen) {
+    return 0;
+  }
+
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return tapWrite(fd_, vnetHdr_, b);
+}
+
+std::size_t Tap::read(std::uint8_t* buf, std::size_t bufLen) {
+  if (!buf || !bufLen) {
+    return 0;
+  }
+
+  DevBuf b{buf, bufLen};
+  auto r = tapRead(fd_, vnetHdr_, b);
+  completeChecksum(buf, r, b.offload);
+  return r;
+}
+
+std::size_t Tap::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  // A TAP file descriptor transfers exactly one frame per syscall so the best
+  // we can do is avoid the virtual dispatch per frame.
+  std::size_t count = 0;
+  for (; count < bufsLen; count++) {
+    auto& b = bufs[count];
+    if (!b.buf || !b.bufLen || tapWrite(fd_, vnetHdr_, b) == 0) {
+      break;
+    }
+  }
+  return count;
+}
+
+std::size_t Tap::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  std::size_t count = 0;
+  for (; count < bufsLen; count++) {
+    auto& b = bufs[count];
+    auto r = (b.buf && b.bufLen) ? tapRead(fd_, vnetHdr_, b) : 0;
+    if (r == 0) {
+      break;
+    }
+    b.bufLen = r;
+  }
+  return count;
 }
 
 std::size_t Tap::maxTransmissionUnit() const {
   return maxTransmissionUnit_;
 }
 
+int Tap::pollFd() const {
+  return fd_;
+}
+
+std::size_t Tap::maxFrameLen() const {
+  return vnetHdr_ ? kMaxGsoFrameLen : maxTransmissionUnit_;
+}
+
+std::uint32_t Tap::offloads() const {
+  return dev_offload::kTxSg | (vnetHdr_ ? dev_offload::kTxTso4 : 0);
+}
+
 }  // namespace unet
@@ -0,0 +1,300 @@
+#include <unet/dev/udp_link.hpp>
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <unet/exception.hpp>
+
+namespace unet {
+
+#ifdef __linux__
+
+// The kernel caps the vector length of a single sendmmsg(...) or
+// recvmmsg(...) at UIO_MAXIOV.
+constexpr std::size_t kMaxMsgsLen = 1'024;
+constexpr std::size_t kMaxDatagramLen = 65'507;
+
+// Deep socket buffers absorb bursts while the stack is busy processing.
+constexpr int kSocketBufLen = 1 << 22;
+
+static sockaddr_in makeSockaddr(SocketAddr addr) {
+  sockaddr_in sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = hostToNet(addr.port());
+  std::memcpy(&sa.sin_addr, addr.addr().addr, sizeof(sa.sin_addr));
+  return sa;
+}
+
+static bool isExhausted(int err) {
+  return err == EAGAIN || err == EWOULDBLOCK || err == ENOBUFS;
+}
+
+UdpLink::UdpLink(SocketAddr local, const std::vector<SocketAddr>& peers,
+                 std::size_t maxTransmissionUnit, std::size_t maxLearnedLen)
+    : maxTransmissionUnit_{maxTransmissionUnit},
+      maxLearnedLen_{maxLearnedLen} {
+  if (maxTransmissionUnit == 0) {
+    throw Exception{"UdpLink cannot have an MTU of 0."};
+  } else if (maxLearnedLen == 0) {
+    throw Exception{"UdpLink must learn at least one address."};
+  } else if (maxTransmissionUnit > kMaxDatagramLen) {
+    throw Exception{"UdpLink MTU is too large for a datagram."};
+  } else if (peers.empty()) {
+    throw Exception{"UdpLink needs at least one peer."};
+  }
+
+  peersLen_ = peers.size();
+  peers_ = std::make_unique<sockaddr_in[]>(peersLen_);
+  for (std::size_t i = 0; i < peersLen_; i++) {
+    peers_[i] = makeSockaddr(peers[i]);
+  }
+
+  if ((fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) ==
+      -1) {
+    throw Exception::fromErrNo();
+  }
+
+  auto addr = makeSockaddr(local);
+  if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &kSocketBufLen,
+                 sizeof(kSocketBufLen)) == -1 ||
+      setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &kSocketBufLen,
+                 sizeof(kSocketBufLen)) == -1 ||
+      bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1) {
+    auto err = errno;
+    close(fd_);
+    errno = err;
+    throw Exception::fromErrNo();
+  }
+
+  reserve(peersLen_);
+}
+
+UdpLink::~UdpLink() {
+  close(fd_);
+}
+
+std::size_t UdpLink::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t UdpLink::read(std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{buf, bufLen};
+  if (!buf || !bufLen || readBatch(&b, 1) == 0) {
+    return 0;
+  }
+  return b.bufLen;
+}
+
+std::size_t UdpLink::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  reserve(std::min(bufsLen * peersLen_, kMaxMsgsLen));
+
+  std::size_t msgsLen = 0;
+  std::size_t count = 0;
+  for (; count < bufsLen; count++) {
+    auto& b = bufs[count];
+    if (!b.buf || !b.bufLen) {
+      break;
+    } else if (b.bufLen > maxTransmissionUnit_) {
+      throw Exception{"Frame is too large for the link."};
+    }
+
+    // Flood frames to multicast or unknown addresses.
+    auto peer = peersLen_;
+    if (b.bufLen >= sizeof(EthernetHeader)) {
+      auto& header = *reinterpret_cast<const EthernetHeader*>(b.buf);
+      auto it = learned_.find(header.dstAddr);
+      if (it != learned_.end()) {
+        peer = it->second.peer;
+        it->second.usedAt = uses_++;
+      }
+    }
+
+    auto n = peer == peersLen_ ? peersLen_ : 1;
+    if (msgsLen + n > msgsLen_) {
+      break;
+    }
+
+    for (std::size_t i = 0; i < n; i++, msgsLen++) {
+      iovecs_[msgsLen].iov_base = b.buf;
+      iovecs_[msgsLen].iov_len = b.bufLen;
+      auto& hdr = msgs_[msgsLen].msg_hdr;
+      std::memset(&hdr, 0, sizeof(hdr));
+      hdr.msg_name = &peers_[peer == peersLen_ ? i : peer];
+      hdr.msg_namelen = sizeof(sockaddr_in);
+      hdr.msg_iov = &iovecs_[msgsLen];
+      hdr.msg_iovlen = 1;
+      msgFrames_[msgsLen] = count;
+    }
+  }
+
+  if (msgsLen == 0) {
+    return 0;
+  }
+
+  auto sent = sendmmsg(fd_, msgs_.get(), msgsLen, 0);
+  if (sent == -1) {
+    if (isExhausted(errno)) {
+      return 0;
+    }
+    throw Exception::fromErrNo();
+  }
+
+  // A flooded frame counts as sent once any of its datagrams is sent so it is
+  // never duplicated to peers which already got it.
+  return sent == static_cast<int>(msgsLen) ? count
+                                            : msgFrames_[sent - 1] + 1;
+}
+
+std::size_t UdpLink::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  std::size_t count = 0;
+  while (count < bufsLen) {
+    auto len = std::min(bufsLen - count, kMaxMsgsLen);
+    reserve(len);
+
+    for (std::size_t i = 0; i < len; i++) {
+      iovecs_[i].iov_base = bufs[count + i].buf;
+      iovecs_[i].iov_len = bufs[count + i].bufLen;
+      auto& hdr = msgs_[i].msg_hdr;
+      std::memset(&hdr, 0, sizeof(hdr));
+      hdr.msg_name = &srcAddrs_[i];
+      hdr.msg_namelen = sizeof(sockaddr_in);
+      hdr.msg_iov = &iovecs_[i];
+      hdr.msg_iovlen = 1;
+    }
+
+    auto n = recvmmsg(fd_, msgs_.get(), len, MSG_DONTWAIT, nullptr);
+    if (n == -1) {
+      if (isExhausted(errno)) {
+        break;
+      }
+      throw Exception::fromErrNo();
+    }
+
+    // Move frames we keep to the front of the batch. Frames are copied
+    // rather than swapping buffers since callers may rely on each buffer
+    // staying in place. Drops are rare so this is seldom needed. Buffers of
+    // dropped frames are reused by the next recvmmsg(...).
+    auto end = count;
+    for (std::size_t i = 0; i < static_cast<std::size_t>(n); i++) {
+      auto peer = findPeer(srcAddrs_[i]);
+      auto frameLen = msgs_[i].msg_len;
+      auto& src = bufs[count + i];
+      auto& dst = bufs[end];
+      if (peer == peersLen_ || (msgs_[i].msg_hdr.msg_flags & MSG_TRUNC) ||
+          frameLen < sizeof(EthernetHeader) || frameLen > dst.bufLen) {
+        continue;
+      } else if (&dst != &src) {
+        std::memmove(dst.buf, src.buf, frameLen);
+      }
+
+      end++;
+      dst.bufLen = frameLen;
+      dst.offload = DevOffload{};
+
+      auto& header = *reinterpret_cast<const EthernetHeader*>(dst.buf);
+      if (!(header.srcAddr.addr[0] & 0x01)) {
+        learn(header.srcAddr, peer);
+      }
+    }
+
+    count = end;
+    if (static_cast<std::size_t>(n) < len) {
+      break;
+    }
+  }
+
+  return count;
+}
+
+std::size_t UdpLink::maxTransmissionUnit() const {
+  return maxTransmissionUnit_;
+}
+
+int UdpLink::pollFd() const {
+  return fd_;
+}
+
+void UdpLink::reserve(std::size_t len) {
+  if (len <= msgsLen_) {
+    return;
+  }
+
+  msgs_ = std::make_unique<mmsghdr[]>(len);
+  iovecs_ = std::make_unique<iovec[]>(len);
+  srcAddrs_ = std::make_unique<sockaddr_in[]>(len);
+  msgFrames_.resize(len);
+  msgsLen_ = len;
+}
+
+std::size_t UdpLink::findPeer(const sockaddr_in& addr) const {
+  std::size_t i = 0;
+  for (; i < peersLen_; i++) {
+    if (peers_[i].sin_addr.s_addr == addr.sin_addr.s_addr &&
+        peers_[i].sin_port == addr.sin_port) {
+      break;
+    }
+  }
+  return i;
+}
+
+void UdpLink::learn(EthernetAddr addr, std::size_t peer) {
+  learned_[addr] = Learned{peer, uses_++};
+  if (learned_.size() <= maxLearnedLen_) {
+    return;
+  }
+
+  // Forget the least recently used address. Peers can claim any number of
+  // source addresses so the table must not grow w/o bound.
+  auto leastRecentlyUsed = learned_.begin();
+  for (auto p = learned_.begin(); p != learned_.end(); p++) {
+    if (p->second.usedAt < leastRecentlyUsed->second.usedAt) {
+      leastRecentlyUsed = p;
+    }
+  }
+  learned_.erase(leastRecentlyUsed);
+}
+
+#else
+
+UdpLink::UdpLink(SocketAddr, const std::vector<SocketAddr>&, std::size_t,
+                 std::size_t) {
+  throw Exception{"UdpLink devices are supported only on Linux."};
+}
+
+UdpLink::~UdpLink() {}
+
+std::size_t UdpLink::send(const std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t UdpLink::read(std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t UdpLink::sendBatch(const DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t UdpLink::readBatch(DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t UdpLink::maxTransmissionUnit() const {
+  return 0;
+}
+
+int UdpLink::pollFd() const {
+  return -1;
+}
+
+#endif
+
+}  // namespace unet
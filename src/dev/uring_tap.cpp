@@ -0,0 +1,370 @@
+#include <unet/dev/uring_tap.hpp>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+#include <cstring>
+
+#include <unet/exception.hpp>
+#include <unet/wire/ethernet.hpp>
+
+namespace unet {
+
+#ifdef __linux__
+
+constexpr std::uint32_t kRxBufNr = 64;
+constexpr std::uint32_t kTxBufNr = 64;
+constexpr std::uint32_t kRingEntries = kRxBufNr + kTxBufNr;
+constexpr std::uint64_t kCancelIndex = ~0ull;
+
+static std::uint32_t loadAcquire(std::uint32_t* p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static void storeRelease(std::uint32_t* p, std::uint32_t x) {
+  __atomic_store_n(p, x, __ATOMIC_RELEASE);
+}
+
+static void* mapRing(int fd, std::size_t len, std::uint64_t offset) {
+  auto p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (p == MAP_FAILED) {
+    throw Exception::fromErrNo();
+  }
+  return p;
+}
+
+// Throws an Exception for the negated errno of a failed completion.
+static void throwCompletionError(int res) {
+  errno = -res;
+  throw Exception::fromErrNo();
+}
+
+UringTap::UringTap(const std::string& name)
+    : Tap{name, false}, rxReady_{kRxBufNr} {
+  try {
+    // io_uring completes reads on a non-blocking file w/EAGAIN instead of
+    // waiting for a frame so the TAP needs to be in blocking mode.
+    auto flags = fcntl(fd_, F_GETFL);
+    if (flags == -1 || fcntl(fd_, F_SETFL, flags & ~O_NONBLOCK) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // Setup and map rings...
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    if ((ringFd_ = syscall(__NR_io_uring_setup, kRingEntries, &params)) ==
+        -1) {
+      throw Exception::fromErrNo();
+    }
+
+    sqRingLen_ =
+        params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+    sqRing_ = mapRing(ringFd_, sqRingLen_, IORING_OFF_SQ_RING);
+    cqRingLen_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    cqRing_ = mapRing(ringFd_, cqRingLen_, IORING_OFF_CQ_RING);
+    sqesLen_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mapRing(ringFd_, sqesLen_, IORING_OFF_SQES);
+
+    auto sq = static_cast<std::uint8_t*>(sqRing_);
+    sqTail_ = reinterpret_cast<std::uint32_t*>(sq + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<std::uint32_t*>(sq + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<std::uint32_t*>(sq + params.sq_off.ring_mask);
+
+    auto cq = static_cast<std::uint8_t*>(cqRing_);
+    cqHead_ = reinterpret_cast<std::uint32_t*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<std::uint32_t*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<std::uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes_ = cq + params.cq_off.cqes;
+
+    // Register buffers and the TAP...
+    bufLen_ = maxTransmissionUnit() + sizeof(EthernetHeader);
+    bufs_ = std::make_unique<std::uint8_t[]>(bufLen_ * kRingEntries);
+
+    std::vector<iovec> iovecs(kRingEntries);
+    for (std::uint32_t i = 0; i < kRingEntries; i++) {
+      iovecs[i].iov_base = bufs_.get() + i * bufLen_;
+      iovecs[i].iov_len = bufLen_;
+    }
+
+    if (syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS,
+                iovecs.data(), kRingEntries) == -1 ||
+        syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_FILES, &fd_,
+                1) == -1) {
+      throw Exception::fromErrNo();
+    }
+
+    // Keep a read outstanding on every RX buffer...
+    rxHeld_.reserve(kRxBufNr);
+    for (std::uint32_t i = 0; i < kRxBufNr; i++) {
+      prepare(IORING_OP_READ_FIXED, i, bufLen_);
+    }
+    submit();
+
+    txFree_.reserve(kTxBufNr);
+    for (auto i = kRingEntries; i > kRxBufNr; i--) {
+      txFree_.push_back(i - 1);
+    }
+  } catch (...) {
+    destroy();
+    throw;
+  }
+}
+
+UringTap::~UringTap() {
+  destroy();
+}
+
+std::size_t UringTap::send(const std::uint8_t* buf, std::size_t bufLen) {
+  DevBuf b{const_cast<std::uint8_t*>(buf), bufLen};
+  return sendBatch(&b, 1) == 1 ? bufLen : 0;
+}
+
+std::size_t UringTap::read(std::uint8_t* buf, std::size_t bufLen) {
+  if (!buf || !bufLen) {
+    return 0;
+  }
+
+  // Frames which do not fit buf are dropped instead of truncated.
+  DevBuf b;
+  while (readBatch(&b, 1) == 1) {
+    if (b.bufLen <= bufLen) {
+      std::memcpy(buf, b.buf, b.bufLen);
+      return b.bufLen;
+    }
+  }
+  return 0;
+}
+
+std::size_t UringTap::sendBatch(const DevBuf* bufs, std::size_t bufsLen) {
+  harvest();
+
+  std::size_t count = 0;
+  for (; count < bufsLen && !txFree_.empty(); count++) {
+    // Chained frames are gathered into the registered buffer.
+    auto& b = bufs[count];
+    auto len = frameLen(b);
+    if (!b.buf || !b.bufLen) {
+      break;
+    } else if (len > bufLen_) {
+      throw Exception{"Frame is too large for a registered buffer."};
+    }
+
+    auto index = txFree_.back();
+    txFree_.pop_back();
+    gatherFrame(b, bufs_.get() + index * bufLen_);
+    prepare(IORING_OP_WRITE_FIXED, index, len);
+  }
+
+  submit();
+
+  // Writes are queued last so those the kernel did not take are at the end of
+  // the submission queue. Take them back so they are not reported as sent.
+  for (; queued_ > 0 && count > 0; count--) {
+    txFree_.push_back(unprepare());
+  }
+  return count;
+}
+
+std::size_t UringTap::readBatch(DevBuf* bufs, std::size_t bufsLen) {
+  // Frames handed out by the previous batch are no longer in use so their
+  // buffers can receive again.
+  for (auto index : rxHeld_) {
+    prepare(IORING_OP_READ_FIXED, index, bufLen_);
+  }
+  rxHeld_.clear();
+  submit();
+
+  harvest();
+
+  std::size_t count = 0;
+  for (; count < bufsLen && !rxReady_.empty(); count++) {
+    auto c = rxReady_.front();
+    rxReady_.pop_front();
+    bufs[count].buf = bufs_.get() + c.index * bufLen_;
+    bufs[count].bufLen = c.len;
+    rxHeld_.push_back(c.index);
+  }
+
+  return count;
+}
+
+int UringTap::pollFd() const {
+  return ringFd_;
+}
+
+bool UringTap::prepareWait() {
+  // Rearm buffers of the last batch so reads are outstanding while we block.
+  for (auto index : rxHeld_) {
+    prepare(IORING_OP_READ_FIXED, index, bufLen_);
+  }
+  rxHeld_.clear();
+  submit();
+
+  // Completions harvested while sending do not wake up the ring.
+  harvest();
+  return rxReady_.empty();
+}
+
+void UringTap::prepare(std::uint8_t opcode, std::uint32_t index,
+                       std::size_t len) {
+  // We are the only producer so the tail can be read w/o synchronization.
+  auto tail = *sqTail_;
+  auto slot = tail & sqMask_;
+
+  auto sqe = static_cast<io_uring_sqe*>(sqes_) + slot;
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->flags = IOSQE_FIXED_FILE;
+  sqe->fd = 0;
+  sqe->addr = reinterpret_cast<std::uint64_t>(bufs_.get() + index * bufLen_);
+  sqe->len = len;
+  sqe->buf_index = index;
+  sqe->user_data = index;
+
+  sqArray_[slot] = slot;
+  storeRelease(sqTail_, tail + 1);
+  queued_++;
+}
+
+std::uint32_t UringTap::unprepare() {
+  auto tail = *sqTail_ - 1;
+  auto sqe = static_cast<io_uring_sqe*>(sqes_) + (tail & sqMask_);
+  storeRelease(sqTail_, tail);
+  queued_--;
+  return static_cast<std::uint32_t>(sqe->user_data);
+}
+
+void UringTap::submit() {
+  if (queued_ == 0) {
+    return;
+  }
+
+  auto submitted = syscall(__NR_io_uring_enter, ringFd_, queued_, 0, 0,
+                           nullptr, 0);
+  if (submitted == -1 && errno != EAGAIN && errno != EBUSY && errno != EINTR) {
+    throw Exception::fromErrNo();
+  } else if (submitted > 0) {
+    // Anything not submitted is retried on the next submit.
+    queued_ -= submitted;
+  }
+}
+
+void UringTap::harvest() {
+  auto cqes = static_cast<io_uring_cqe*>(cqes_);
+  auto head = *cqHead_;
+  auto tail = loadAcquire(cqTail_);
+
+  for (; head != tail; head++) {
+    auto cqe = cqes[head & cqMask_];
+    storeRelease(cqHead_, head + 1);
+
+    auto index = static_cast<std::uint32_t>(cqe.user_data);
+    if (index >= kRxBufNr) {
+      txFree_.push_back(index);
+      if (cqe.res < 0) {
+        throwCompletionError(cqe.res);
+      }
+    } else if (cqe.res > 0) {
+      rxReady_.push_back(
+          Completion{index, static_cast<std::uint32_t>(cqe.res)});
+    } else {
+      // Try again w/this buffer on the next batch.
+      rxHeld_.push_back(index);
+      if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+        throwCompletionError(cqe.res);
+      }
+    }
+  }
+}
+
+void UringTap::destroy() {
+  // Cancel outstanding reads and unregister the TAP so it is released by the
+  // time we return instead of whenever the kernel tears down the ring.
+  if (sqes_ && cqRing_) {
+    auto tail = *sqTail_;
+    auto slot = tail & sqMask_;
+    auto sqe = static_cast<io_uring_sqe*>(sqes_) + slot;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ALL | IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = kCancelIndex;
+    sqArray_[slot] = slot;
+    storeRelease(sqTail_, tail + 1);
+
+    auto cqes = static_cast<io_uring_cqe*>(cqes_);
+    for (auto done = false; !done;) {
+      if (syscall(__NR_io_uring_enter, ringFd_, queued_ + 1, 1,
+                  IORING_ENTER_GETEVENTS, nullptr, 0) == -1 &&
+          errno != EINTR) {
+        break;
+      }
+      queued_ = 0;
+
+      auto head = *cqHead_;
+      for (auto t = loadAcquire(cqTail_); head != t; head++) {
+        done = done || cqes[head & cqMask_].user_data == kCancelIndex;
+      }
+      storeRelease(cqHead_, head);
+    }
+
+    syscall(__NR_io_uring_register, ringFd_, IORING_UNREGISTER_FILES, nullptr,
+            0);
+  }
+
+  for (auto ring : {std::make_pair(sqRing_, sqRingLen_),
+                    std::make_pair(cqRing_, cqRingLen_),
+                    std::make_pair(sqes_, sqesLen_)}) {
+    if (ring.first) {
+      munmap(ring.first, ring.second);
+    }
+  }
+
+  // Closing the ring cancels all outstanding reads.
+  if (ringFd_ != -1) {
+    close(ringFd_);
+  }
+}
+
+#else
+
+UringTap::UringTap(const std::string& name) : Tap{name, false} {}
+
+UringTap::~UringTap() {}
+
+std::size_t UringTap::send(const std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t UringTap::read(std::uint8_t*, std::size_t) {
+  return 0;
+}
+
+std::size_t UringTap::sendBatch(const DevBuf*, std::size_t) {
+  return 0;
+}
+
+std::size_t UringTap::readBatch(DevBuf*, std::size_t) {
+  return 0;
+}
+
+int UringTap::pollFd() const {
+  return -1;
+}
+
+bool UringTap::prepareWait() {
+  return true;
+}
+
+#endif
+
+}  // namespace unet
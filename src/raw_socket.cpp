@@ -8,17 +8,50 @@ RawSocket::RawSocket(Stack& stack, Type type,
           (type == kEthernet) ? detail::RawSocket::kEthernet
                               : detail::RawSocket::kIpv4,
           stack.opts_.rawSocketSendQueueLen, stack.opts_.rawSocketReadQueueLen,
-          stack.dev_->maxTransmissionUnit(), stack.serializer_,
+          stack.dev_->maxTransmissionUnit(),
+          (stack.dev_->offloads() & dev_offload::kTxTso4)
+              ? stack.dev_->maxFrameLen()
+              : stack.dev_->maxTransmissionUnit(),
+          stack.serializer_,
           (type == kEthernet) ? stack.ethernetSockets_ : stack.ipv4Sockets_,
           stack.socketSet_,
-          [this, callback](auto mask) { callback(*this, mask); }}} {}
+          [this, callback](auto mask) { callback(*this, mask); },
+          stack.memBudget_}} {}
 
 std::size_t RawSocket::send(const std::uint8_t* buf, std::size_t bufLen) {
   return socketSafe()->send(buf, bufLen);
 }
 
+FrameBuf RawSocket::reserve(std::size_t bufLen) {
+  FrameBuf view;
+  view.bufLen = bufLen;
+  view.buf = socketSafe()->reserve(view.bufLen);
+  if (!view.buf) {
+    view.bufLen = 0;
+  }
+  return view;
+}
+
+std::size_t RawSocket::commit(std::size_t len) {
+  return socketSafe()->commit(len);
+}
+
 std::size_t RawSocket::read(std::uint8_t* buf, std::size_t bufLen) {
   return socketSafe()->read(buf, bufLen);
 }
 
+FrameView RawSocket::borrow() {
+  FrameView view;
+  view.buf = socketSafe()->borrow(view.bufLen);
+  return view;
+}
+
+void RawSocket::release() {
+  socketSafe()->release();
+}
+
+std::size_t RawSocket::memUsed() {
+  return socketSafe()->memAccount().used();
+}
+
 }  // namespace unet
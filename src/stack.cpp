@@ -1,15 +1,68 @@
 #include <unet/stack.hpp>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
 #include <cstring>
 
 #include <boost/scope_exit.hpp>
 
+#include <unet/detail/check.hpp>
 #include <unet/exception.hpp>
 #include <unet/wire/arp.hpp>
 #include <unet/wire/icmpv4.hpp>
 
 namespace unet {
 
+// The bits of TCP the stack needs to hand off segmentation to a device.
+constexpr std::size_t kTcpHeaderLen = 20;
+constexpr std::size_t kTcpDataOffset = 12;
+constexpr std::size_t kTcpChecksumOffset = 16;
+constexpr std::size_t kTcpv4HeadersLen =
+    sizeof(EthernetHeader) + sizeof(Ipv4Header) + kTcpHeaderLen;
+
+static std::shared_ptr<detail::FramePool> makeFramePool(const Options& opts) {
+  std::unique_ptr<detail::Arena> arena;
+  if (opts.frameArenaLen > 0) {
+    arena = std::make_unique<detail::Arena>(opts.frameArenaLen,
+                                            opts.frameArenaLock);
+  }
+  return std::make_shared<detail::FramePool>(opts.framePoolLen,
+                                             std::move(arena));
+}
+
+static std::shared_ptr<detail::MemBudget> makeMemBudget(const Options& opts) {
+  if (opts.memBudgetLen == 0) {
+    return std::make_shared<detail::MemBudget>(SIZE_MAX, 0);
+  } else if (opts.memBudgetLowLen == 0) {
+    return std::make_shared<detail::MemBudget>(opts.memBudgetLen,
+                                               opts.memBudgetLen / 4);
+  } else if (opts.memBudgetLowLen > opts.memBudgetLen) {
+    throw Exception{"Memory budget low mark must not exceed the budget."};
+  }
+  return std::make_shared<detail::MemBudget>(opts.memBudgetLen,
+                                             opts.memBudgetLowLen);
+}
+
+// Return CoDel managing the send queue or nullptr if it is tail dropping.
+static std::unique_ptr<detail::Codel> makeCodel(const Options& opts) {
+  if (opts.sendQueueAqm != SendQueueAqm::Codel) {
+    return nullptr;
+  }
+
+  // Frames are timestamped w/a fresh reading of the clock since the time of
+  // the loop iteration goes stale while a burst is processed.
+  return std::make_unique<detail::Codel>(
+      opts.codelTarget, opts.codelInterval,
+      opts.codelClock ? opts.codelClock : detail::Codel::Clock::now);
+}
+
 Stack::Stack(std::unique_ptr<Dev> dev, EthernetAddr ethAddr,
              Ipv4AddrCidr ipv4AddrCidr, Ipv4Addr defaultGateway, Options opts)
     : dev_{std::move(dev)},
@@ -17,17 +70,40 @@ Stack::Stack(std::unique_ptr<Dev> dev, EthernetAddr ethAddr,
       ipv4AddrCidr_{ipv4AddrCidr},
       defaultGateway_{defaultGateway},
       opts_{opts},
-      sendQueue_{std::make_shared<detail::Queue>(opts.stackSendQueueLen)},
+      framePool_{makeFramePool(opts)},
+      memBudget_{makeMemBudget(opts)},
+      memAccount_{memBudget_},
       timerManager_{std::make_shared<TimerManager>()},
+      codel_{makeCodel(opts)},
+      sendQueue_{std::make_shared<detail::Queue<>>(
+          opts.stackSendQueueLen, 0, &memAccount_, codel_.get())},
       arpQueue_{opts.arpQueueLen, opts.arpCacheSize, opts.arpTimeout,
-                opts.arpCacheTTL, sendQueue_,        timerManager_},
-      serializer_{
-          std::make_shared<detail::Serializer>(ethAddr, *ipv4AddrCidr)} {
+                opts.arpCacheTTL, sendQueue_,        timerManager_,
+                &memAccount_},
+      serializer_{std::make_shared<detail::Serializer>(
+          ethAddr, *ipv4AddrCidr, framePool_, opts.frameHeadroom)} {
   if (!dev_) {
     throw Exception{"Invalid dev."};
   } else if (!ipv4AddrCidr.isInSubnet(defaultGateway)) {
     throw Exception{"Default gateway should be on the same subnet."};
   }
+
+  // Preallocate everything needed to move a burst of frames to and from the
+  // device so the loop does not allocate per burst.
+  auto batchLen = std::max<std::size_t>(opts_.devBatchLen, 1);
+  readFrameLen_ = dev_->maxFrameLen();
+  if (readFrameLen_ > dev_->maxTransmissionUnit() + sizeof(EthernetHeader)) {
+    shortFrameLen_ = dev_->maxTransmissionUnit() + sizeof(EthernetHeader);
+  }
+  readFrames_.resize(batchLen);
+  readFrame_ = detail::Frame::makeUninitialized(0);
+  devOffloads_ = dev_->offloads();
+  dev_->setTimerManager(timerManager_);
+  sendFrames_.reserve(batchLen);
+  devBufs_.resize(batchLen);
+  if (devOffloads_ & dev_offload::kTxSg) {
+    devSegs_.resize(batchLen * kDevMaxSegs);
+  }
 }
 
 void Stack::runLoop() {
@@ -45,8 +121,64 @@ void Stack::runLoop() {
   }
   BOOST_SCOPE_EXIT_END
 
+  auto epollFd = -1;
+
+  BOOST_SCOPE_EXIT(&epollFd) {
+#ifdef __linux__
+    if (epollFd != -1) {
+      close(epollFd);
+    }
+#endif
+  }
+  BOOST_SCOPE_EXIT_END
+
+#ifdef __linux__
+  auto devFd = dev_->pollFd();
+  if (devFd != -1) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    if ((epollFd = epoll_create1(EPOLL_CLOEXEC)) == -1 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, devFd, &event) == -1) {
+      throw Exception::fromErrNo();
+    }
+  }
+#endif
+
+  // Frames are mostly touched by the thread running the loop.
+  if (auto arena = framePool_->arena()) {
+    arena->bindToCurrentNode();
+  }
+
+  // Once out of work the loop keeps busy polling for a while in case more
+  // arrives shortly before it falls back to blocking.
+  auto spinning = false;
+  std::chrono::steady_clock::time_point idleSince;
+  std::chrono::steady_clock::time_point lastPoll;
+
   while (runningLoop_) {
     runLoopOnce();
+    if (!idle_) {
+      spinning = false;
+      continue;
+    }
+
+    auto now = timerManager_->now();
+    if (spinning) {
+      loopStats_.spinTime += now - lastPoll;
+    } else {
+      spinning = true;
+      idleSince = now;
+    }
+    lastPoll = now;
+
+    auto idleFor =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - idleSince);
+    if (runningLoop_ && epollFd != -1 && idleFor >= opts_.loopBusyPollTime &&
+        waitForWork(epollFd)) {
+      loopStats_.sleepTime += std::chrono::steady_clock::now() - now;
+      loopStats_.sleeps++;
+      spinning = false;
+    }
   }
 }
 
@@ -57,6 +189,41 @@ void Stack::stopLoop() {
   }
 }
 
+void Stack::runLoopOnce() {
+  auto read = readLoop();
+  timerManager_->run();
+  socketSet_.dispatch();
+  socketSet_.drainRoundRobin(*sendQueue_);
+  auto sent = sendLoop();
+  updateSendEvents();
+
+  // Staged frames stay behind only when the link is exhausted, which the
+  // device fd does not signal, so we keep spinning until they are sent.
+  idle_ = read == 0 && sent == 0 && sendFrames_.empty() &&
+          !socketSet_.hasPendingWork();
+}
+
+const LoopStats& Stack::loopStats() const {
+  return loopStats_;
+}
+
+SendQueueStats Stack::sendQueueStats() const {
+  SendQueueStats stats;
+  stats.tailDrops = sendQueue_->tailDrops();
+  if (codel_) {
+    auto& codelStats = codel_->stats();
+    stats.codelDrops = codelStats.drops;
+    stats.codelDropStarts = codelStats.dropStarts;
+    stats.sojournTime = codelStats.sojournTime;
+    stats.maxSojournTime = codelStats.maxSojournTime;
+  }
+  return stats;
+}
+
+std::size_t Stack::memUsed() const {
+  return memBudget_->used();
+}
+
 std::unique_ptr<Timer> Stack::createTimer(std::function<void()> f) {
   return std::make_unique<Timer>(*timerManager_, f);
 }
@@ -69,75 +236,183 @@ Ipv4Addr Stack::getIpv4Addr() const {
   return *ipv4AddrCidr_;
 }
 
-void Stack::runLoopOnce() {
-  readLoop();
-  timerManager_->run();
-  socketSet_.dispatch();
-  socketSet_.drainRoundRobin(*sendQueue_);
-  sendLoop();
-}
+std::size_t Stack::sendLoop() {
+  std::size_t count = 0;
+  for (;;) {
+    // Stage a burst of frames for the link. Frames which are not going on the
+    // link are looped back right away.
+    while (sendFrames_.size() < devBufs_.size()) {
+      auto f = sendQueue_->peek();
+      if (!f) {
+        break;
+      }
 
-void Stack::sendLoop() {
-  while (auto f = sendQueue_->peek()) {
-    if (f->doIpv4Routing && !tryNextIpv4Hop(*f)) {
-      // Lookup of the Ethernet address for the next hop has failed.
-      if (arpQueue_.delay(sendQueue_->pop())) {
-        // Send an ARP request for the hop and delay the frame in the meantime.
-        sendArp(f->hopAddr, kEthernetBcastAddr, arp_op::kRequest);
+      if (f->doIpv4Routing && !tryNextIpv4Hop(*f)) {
+        // Lookup of the Ethernet address for the next hop has failed.
+        if (arpQueue_.delay(sendQueue_->pop())) {
+          // Send an ARP request for the hop and delay the frame in the
+          // meantime.
+          sendArp(f->hopAddr, kEthernetBcastAddr, arp_op::kRequest);
+        }
+        continue;
+      }
+
+      auto frame = sendQueue_->pop();
+      count++;
+      auto dstAddr = frame->dataAs<EthernetHeader>()->dstAddr;
+      if (frame->frag() &&
+          (!canGather(*frame) || dstAddr == ethAddr_ ||
+           dstAddr == kEthernetBcastAddr)) {
+        // Frames we process ourselves need to be contiguous.
+        detail::Frame::flatten(frame, framePool_.get());
+      }
+
+      if (dstAddr == ethAddr_) {
+        process(*frame);
+      } else if (frame->chainLen() > dev_->maxTransmissionUnit() &&
+                 !offloadSegmentation(*frame)) {
+        // Drop frames which neither fit the link nor can be segmented by the
+        // device.
+        continue;
+      } else {
+        sendFrames_.push_back(std::move(frame));
       }
-      continue;
     }
 
-    // Only send on the link if the frame is not destined for us.
-    auto dstAddr = f->dataAs<EthernetHeader>()->dstAddr;
-    auto shouldSendOnLink = dstAddr != ethAddr_;
-    if (shouldSendOnLink && dev_->send(f->data, f->dataLen) == 0) {
-      // Link exhausted, try again on the next loop.
-      return;
+    if (sendFrames_.empty()) {
+      return count;
     }
 
-    // We can drop the frame now that it has made it onto the link (or we didn't
-    // try sending it at all). Check if we need to loopback before doing so.
-    if (dstAddr == ethAddr_ || dstAddr == kEthernetBcastAddr) {
-      process(*f);
+    auto seg = devSegs_.data();
+    for (std::size_t i = 0; i < sendFrames_.size(); i++) {
+      auto& f = *sendFrames_[i];
+      devBufs_[i] = DevBuf{f.data, f.dataLen, f.offload, seg, 0};
+      for (auto frag = f.frag(); frag; frag = frag->frag()) {
+        *seg++ = DevSeg{frag->data, frag->dataLen};
+        devBufs_[i].segsLen++;
+      }
     }
 
-    sendQueue_->pop();
+    auto sent = dev_->sendBatch(devBufs_.data(), sendFrames_.size());
+
+    // We can drop frames now that they have made it onto the link. Check if we
+    // need to loopback before doing so.
+    for (std::size_t i = 0; i < sent; i++) {
+      auto& f = *sendFrames_[i];
+      if (f.dataAs<EthernetHeader>()->dstAddr == kEthernetBcastAddr) {
+        process(f);
+      }
+    }
+
+    sendFrames_.erase(sendFrames_.begin(), sendFrames_.begin() + sent);
+    if (!sendFrames_.empty()) {
+      // Link exhausted, try the remaining staged frames on the next loop.
+      return count;
+    }
   }
 }
 
-void Stack::readLoop() {
-  auto frameLen = dev_->maxTransmissionUnit();
-  auto f = detail::Frame::makeUninitialized(frameLen);
-  while ((f->dataLen = dev_->read(f->data, frameLen)) > 0) {
-    f->net = nullptr;
-    f->netLen = 0;
-    process(*f);
+std::size_t Stack::readLoop() {
+  std::size_t total = 0;
+  std::size_t count;
+  do {
+    // The device reads straight into pooled frames which sockets can hold on
+    // to w/o copying them.
+    for (std::size_t i = 0; i < devBufs_.size(); i++) {
+      auto& f = readFrames_[i];
+      if (!f) {
+        f = detail::Frame::makeUninitialized(readFrameLen_, framePool_.get());
+      }
+      devBufs_[i] = DevBuf{f->data, readFrameLen_};
+    }
+
+    count = dev_->readBatch(devBufs_.data(), devBufs_.size());
+
+    // The device may have pointed buffers at its own memory instead of copying
+    // into ours so we process those in place w/a reusable frame. Short frames
+    // read into buffers sized for segmented frames are processed the same way
+    // so sockets copy them into right sized frames instead of pinning ours.
+    for (std::size_t i = 0; i < count; i++) {
+      auto inPlace = devBufs_[i].buf == readFrames_[i]->data &&
+                     devBufs_[i].bufLen > shortFrameLen_;
+      auto& f = inPlace ? *readFrames_[i] : *readFrame_;
+      f.data = devBufs_[i].buf;
+      f.dataLen = devBufs_[i].bufLen;
+      f.offload = devBufs_[i].offload;
+      f.clearLayers();
+      process(f);
+
+      // Sockets holding on to the frame keep it so the next read needs
+      // another.
+      if (inPlace && f.shared()) {
+        readFrames_[i].reset();
+      }
+    }
+    total += count;
+  } while (count == devBufs_.size());
+
+  return total;
+}
+
+bool Stack::waitForWork(int epollFd) {
+#ifdef __linux__
+  if (!dev_->prepareWait()) {
+    return false;
+  }
+
+  // Timers expire only once now is past their time point so we round up.
+  auto timeoutMs = -1;
+  if (auto expiry = timerManager_->nextExpiry()) {
+    auto delay = *expiry - std::chrono::steady_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(delay);
+    timeoutMs = delay.count() < 0
+                    ? 0
+                    : static_cast<int>(std::min<std::int64_t>(
+                          ms.count() + 1, INT_MAX));
   }
+
+  epoll_event event;
+  if (epoll_wait(epollFd, &event, 1, timeoutMs) == -1 && errno != EINTR) {
+    throw Exception::fromErrNo();
+  }
+  return true;
+#else
+  (void)epollFd;
+  return false;
+#endif
 }
 
 void Stack::process(detail::Frame& f) {
-  if (f.dataLen < sizeof(EthernetHeader)) {
+  // Drop frames larger than any Ethernet frame along w/runts.
+  if (f.dataLen < sizeof(EthernetHeader) ||
+      f.dataLen > sizeof(EthernetHeader) + detail::Frame::kMaxLayerLen) {
     return;
   }
 
-  f.net = f.data + sizeof(EthernetHeader);
-  f.netLen = f.dataLen - sizeof(EthernetHeader);
+  f.setNet(f.data + sizeof(EthernetHeader),
+           f.dataLen - sizeof(EthernetHeader));
+
+  // Sockets expect to see complete checksums.
+  completeChecksum(f.data, f.dataLen, f.offload);
+
+  // Sockets share the bytes of the frame, copying them at most once if they
+  // live in device memory.
+  detail::FramePtr copy;
 
   // Safe loop because process(...) is guaranteed to not destroy the socket.
   for (detail::Hook<detail::RawSocket>& hook : ethernetSockets_) {
-    hook->process(f);
+    hook->process(f, copy);
   }
 
   if (f.dataAs<EthernetHeader>()->ethType == eth_type::kArp) {
     processArp(f);
   } else if (f.dataAs<EthernetHeader>()->ethType == eth_type::kIpv4) {
-    processIpv4(f);
+    processIpv4(f, copy);
   }
 }
 
 void Stack::processArp(detail::Frame& f) {
-  if (f.netLen < sizeof(ArpHeader)) {
+  if (f.netLen() < sizeof(ArpHeader)) {
     return;
   }
 
@@ -177,28 +452,30 @@ void Stack::sendArp(Ipv4Addr dstIpv4Addr, EthernetAddr dstHwAddr,
       arp->dstProtoAddr = dstIpv4Addr;
     });
     sendQueue_->push(f);
+  } else {
+    sendQueue_->countTailDrop();
   }
 }
 
-void Stack::processIpv4(detail::Frame& f) {
-  if (f.netLen < sizeof(Ipv4Header)) {
+void Stack::processIpv4(detail::Frame& f, detail::FramePtr& copy) {
+  if (f.netLen() < sizeof(Ipv4Header)) {
     return;
   }
 
   auto ipv4 = f.netAs<Ipv4Header>();
   std::size_t headerLen = ipv4->ihl * 4;
-  if (headerLen > f.netLen || ipv4->version != 4 ||
-      netToHost(ipv4->len) != f.netLen || checksumIpv4(ipv4) != 0 ||
+  if (headerLen > f.netLen() || ipv4->version != 4 ||
+      netToHost(ipv4->len) != f.netLen() ||
+      (!f.offload.csumValid && checksumIpv4(ipv4) != 0) ||
       ipv4->dstAddr != *ipv4AddrCidr_) {
     return;
   }
 
-  f.transport = f.net + headerLen;
-  f.transportLen = f.netLen - headerLen;
+  f.setTransport(f.net() + headerLen, f.netLen() - headerLen);
 
   // Safe loop because process(...) is guaranteed to not destroy the socket.
   for (detail::Hook<detail::RawSocket>& hook : ipv4Sockets_) {
-    hook->process(f);
+    hook->process(f, copy);
   }
 
   if (ipv4->proto == ipv4_proto::kIcmp) {
@@ -220,34 +497,118 @@ bool Stack::tryNextIpv4Hop(detail::Frame& f) {
   return true;
 }
 
+bool Stack::canGather(const detail::Frame& f) const {
+  if (!(devOffloads_ & dev_offload::kTxSg)) {
+    return false;
+  }
+
+  std::size_t segsLen = 0;
+  for (auto frag = f.frag(); frag; frag = frag->frag()) {
+    segsLen++;
+  }
+  return segsLen <= kDevMaxSegs;
+}
+
+bool Stack::offloadSegmentation(detail::Frame& f) {
+  // Headers are expected to be in the first segment.
+  if (!(devOffloads_ & dev_offload::kTxTso4) ||
+      f.dataLen < kTcpv4HeadersLen ||
+      f.dataAs<EthernetHeader>()->ethType != eth_type::kIpv4) {
+    return false;
+  }
+
+  // Frames from raw Ethernet sockets do not have their layers parsed.
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(f.data + sizeof(EthernetHeader));
+  std::size_t csumStart = sizeof(EthernetHeader) + ipv4->ihl * 4;
+  if (ipv4->proto != ipv4_proto::kTcp ||
+      csumStart + kTcpHeaderLen > f.dataLen) {
+    return false;
+  }
+
+  auto tcpHeaderLen = (f.data[csumStart + kTcpDataOffset] >> 4) * 4;
+  std::size_t hdrLen = csumStart + tcpHeaderLen;
+  auto frameLen = f.chainLen();
+  auto mtu = dev_->maxTransmissionUnit();
+  if (hdrLen >= mtu || hdrLen > f.dataLen || hdrLen >= frameLen) {
+    return false;
+  }
+
+  // The device computes the checksum of each segment starting from the sum of
+  // the pseudo header.
+  auto csum = pseudoChecksumIpv4(ipv4, frameLen - csumStart);
+  std::memcpy(f.data + csumStart + kTcpChecksumOffset, &csum, sizeof(csum));
+
+  f.offload.csumPartial = true;
+  f.offload.csumStart = csumStart;
+  f.offload.csumOffset = kTcpChecksumOffset;
+  f.offload.gsoType = gso_type::kTcpv4;
+  f.offload.hdrLen = hdrLen;
+  f.offload.gsoSize = mtu - hdrLen;
+  return true;
+}
+
 void Stack::processIcmpv4(detail::Frame& f) {
-  if (f.transportLen < sizeof(Icmpv4Header)) {
+  if (f.transportLen() < sizeof(Icmpv4Header)) {
     return;
   }
 
   auto icmp = f.transportAs<Icmpv4Header>();
-  auto payloadLen = f.transportLen - sizeof(Icmpv4Header);
+  auto payloadLen = f.transportLen() - sizeof(Icmpv4Header);
   if (icmp->type != 8 || icmp->code != 0 ||
-      checksumIcmpv4(icmp, payloadLen) != 0) {
+      (!f.offload.csumValid && checksumIcmpv4(icmp, payloadLen) != 0)) {
     return;
   }
 
-  if (sendQueue_->hasCapacity()) {
-    auto dstAddr = f.netAs<Ipv4Header>()->srcAddr;
-    auto f = serializer_->makeIpv4(
-        sizeof(Icmpv4Header) + payloadLen,
-        [icmp, payloadLen, dstAddr](detail::Frame& f) {
-          auto ipv4 = f.netAs<Ipv4Header>();
-          ipv4->proto = ipv4_proto::kIcmp;
-          ipv4->dstAddr = dstAddr;
-
-          auto icmp_ = f.transportAs<Icmpv4Header>();
-          icmp_->type = 0;
-          icmp_->code = 0;
-          std::memcpy(icmp_->data, icmp->data, sizeof(Icmpv4Echo) + payloadLen);
-          icmp_->checksum = checksumIcmpv4(icmp_, payloadLen);
-        });
-    sendQueue_->push(f);
+  if (!sendQueue_->hasCapacity()) {
+    sendQueue_->countTailDrop();
+    return;
+  }
+
+  // Devices which gather payload segments send the echoed payload straight
+  // from the request instead of a copy of it.
+  auto dstAddr = f.netAs<Ipv4Header>()->srcAddr;
+  auto payloadBuf = f.transport() + sizeof(Icmpv4Header);
+  detail::FramePtr payload;
+  if ((devOffloads_ & dev_offload::kTxSg) && payloadLen > 0 && f.ownsData()) {
+    payload = detail::Frame::makeRef(f, payloadBuf, payloadLen);
+  }
+
+  auto copyLen = payload ? 0 : payloadLen;
+  auto reply = serializer_->makeIpv4(
+      sizeof(Icmpv4Header) + copyLen,
+      [icmp, payloadBuf, payloadLen, copyLen, dstAddr](detail::Frame& f) {
+        auto ipv4 = f.netAs<Ipv4Header>();
+        ipv4->proto = ipv4_proto::kIcmp;
+        ipv4->dstAddr = dstAddr;
+
+        auto icmp_ = f.transportAs<Icmpv4Header>();
+        icmp_->type = 0;
+        icmp_->code = 0;
+        icmp_->checksum = 0;
+        std::memcpy(icmp_->data, icmp->data, sizeof(Icmpv4Echo) + copyLen);
+
+        DevSeg segs[2]{{f.transport(), f.transportLen()},
+                       {payloadBuf, payloadLen - copyLen}};
+        icmp_->checksum = detail::checksum(segs, 2);
+      },
+      std::move(payload));
+  sendQueue_->push(reply);
+}
+
+void Stack::updateSendEvents() {
+  // Sockets withhold Send while memory runs low so they are told once it turns
+  // either way, including when it ran low and recovered within the loop.
+  auto ranLow = memBudget_->takeRanLow();
+  auto low = memBudget_->low();
+  if (low == memLow_ && (low || !ranLow)) {
+    return;
+  }
+
+  memLow_ = low;
+  for (auto sockets : {&ethernetSockets_, &ipv4Sockets_}) {
+    for (detail::Hook<detail::RawSocket>& hook : *sockets) {
+      hook->updateSendEvent();
+    }
   }
 }
 
@@ -19,8 +19,8 @@ void Timer::runAt(std::chrono::steady_clock::time_point tp) {
 }
 
 bool Timer::Core::operator<(const Timer::Core& other) const {
-  if (runAt < other.runAt) {
-    return true;
+  if (runAt != other.runAt) {
+    return runAt < other.runAt;
   }
 
   // Use address as tie breaker to support more than one timer with the same
@@ -54,4 +54,12 @@ std::chrono::steady_clock::time_point TimerManager::now() const {
   return now_;
 }
 
+boost::optional<std::chrono::steady_clock::time_point>
+TimerManager::nextExpiry() const {
+  if (cores_.empty()) {
+    return boost::none;
+  }
+  return cores_.begin()->runAt;
+}
+
 }  // namespace unet
@@ -77,4 +77,19 @@ std::uint16_t checksumIpv4(const Ipv4Header* header) {
                           sizeof(Ipv4Header));
 }
 
+std::uint16_t pseudoChecksumIpv4(const Ipv4Header* header,
+                                 std::size_t transportLen) {
+  struct UNET_PACK {
+    Ipv4Addr srcAddr;
+    Ipv4Addr dstAddr;
+    std::uint8_t zero;
+    std::uint8_t proto;
+    std::uint16_t len;
+  } pseudo{header->srcAddr, header->dstAddr, 0, header->proto,
+           hostToNet<std::uint16_t>(transportLen)};
+
+  return ~detail::checksum(reinterpret_cast<const std::uint8_t*>(&pseudo),
+                           sizeof(pseudo));
+}
+
 }  // namespace unet
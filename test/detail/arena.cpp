@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+
+#include <unet/detail/arena.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+namespace detail {
+
+TEST(ArenaTest, Allocate) {
+  Arena arena{4'096, false};
+  ASSERT_GE(arena.len(), 4'096);
+
+  auto p = static_cast<std::uint8_t*>(arena.allocate(10, 1));
+  auto q = static_cast<std::uint8_t*>(arena.allocate(100, 64));
+  ASSERT_TRUE(arena.contains(p));
+  ASSERT_TRUE(arena.contains(q + 99));
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(q) % 64, 0);
+  ASSERT_GE(q, p + 10);
+  ASSERT_EQ(arena.used(), q + 100 - p);
+  std::memset(q, 0xff, 100);
+
+  // The arena never hands out more than it has.
+  ASSERT_EQ(arena.allocate(arena.len(), 1), nullptr);
+  ASSERT_NE(arena.allocate(arena.len() - arena.used(), 1), nullptr);
+  ASSERT_EQ(arena.allocate(1, 1), nullptr);
+
+  int x;
+  ASSERT_FALSE(arena.contains(&x));
+}
+
+TEST(ArenaTest, Empty) {
+  ASSERT_THROW((Arena{0, false}), Exception);
+}
+
+}  // namespace detail
+}  // namespace unet
@@ -21,7 +21,7 @@ constexpr std::chrono::steady_clock::time_point kTpNowBase{};
 class ArpQueueTest : public Test {
  public:
   void SetUp() override {
-    sendQueue = std::make_shared<Queue>(2);
+    sendQueue = std::make_shared<Queue<>>(2);
     timerManager = std::make_shared<TimerManager>(kTpNowBase);
     arpQueue = std::make_shared<ArpQueue>(2, 2, std::chrono::seconds{1},
                                           std::chrono::seconds{60}, sendQueue,
@@ -38,7 +38,7 @@ class ArpQueueTest : public Test {
     return p;
   }
 
-  std::shared_ptr<Queue> sendQueue;
+  std::shared_ptr<Queue<>> sendQueue;
   std::shared_ptr<TimerManager> timerManager;
   std::shared_ptr<ArpQueue> arpQueue;
 };
@@ -20,5 +20,17 @@ TEST(CheckTest, ChecksumOddLen) {
   ASSERT_EQ(hostToNet<std::uint16_t>(0xB928), checksum(buf, sizeof(buf)));
 }
 
+TEST(CheckTest, ChecksumSegments) {
+  std::uint8_t buf[] = {0x45, 0x00, 0x00, 0x73, 0x00, 0x00, 0x40,
+                        0x00, 0x40, 0x11, 0x00, 0x00, 0xc0, 0xa8,
+                        0x00, 0x01, 0xc0, 0xa8, 0x00, 0xc7};
+
+  // Words may straddle segments of any length.
+  DevSeg segs[]{{buf, 3}, {buf + 3, 0}, {buf + 3, 1}, {buf + 4, 5},
+                {buf + 9, sizeof(buf) - 9}};
+  ASSERT_EQ(checksum(buf, sizeof(buf)), checksum(segs, 5));
+  ASSERT_EQ(checksum(buf, 9), checksum(segs, 4));
+}
+
 }  // namespace detail
 }  // namespace unet
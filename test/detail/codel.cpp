@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include <unet/detail/codel.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+namespace detail {
+
+using std::chrono::milliseconds;
+
+class CodelTest : public testing::Test {
+ public:
+  // Return true if CoDel drops a head which has waited for the specified
+  // time.
+  bool shouldDrop(milliseconds waited, bool last = false) {
+    return codel.shouldDrop(now - waited, last);
+  }
+
+  Codel::Clock::time_point now =
+      Codel::Clock::time_point{} + std::chrono::hours{1};
+  Codel codel{milliseconds{5}, milliseconds{100},
+              [this]() { return this->now; }};
+};
+
+TEST_F(CodelTest, KeepBelowTarget) {
+  for (auto i = 0; i < 10; i++) {
+    ASSERT_FALSE(shouldDrop(milliseconds{4}));
+    now += milliseconds{100};
+  }
+  ASSERT_EQ(codel.stats().drops, 0);
+  ASSERT_EQ(codel.stats().maxSojournTime, milliseconds{4});
+}
+
+TEST_F(CodelTest, DropStandingQueue) {
+  // Frames may wait above target for an interval...
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  now += milliseconds{99};
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+
+  // ...before they get dropped, once per interval at first.
+  now += milliseconds{1};
+  ASSERT_TRUE(shouldDrop(milliseconds{10}));
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  now += milliseconds{100};
+  ASSERT_TRUE(shouldDrop(milliseconds{10}));
+
+  // The next drop comes an interval / sqrt(2) later.
+  now += milliseconds{70};
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  now += milliseconds{1};
+  ASSERT_TRUE(shouldDrop(milliseconds{10}));
+
+  ASSERT_EQ(codel.stats().drops, 3);
+  ASSERT_EQ(codel.stats().dropStarts, 1);
+}
+
+TEST_F(CodelTest, StopOnceQueueDrains) {
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  now += milliseconds{100};
+  ASSERT_TRUE(shouldDrop(milliseconds{10}));
+
+  // A lone frame is no standing queue.
+  now += milliseconds{100};
+  ASSERT_FALSE(shouldDrop(milliseconds{10}, true));
+
+  // Frames waiting above target again get another interval.
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  now += milliseconds{99};
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+
+  codel.onEmpty();
+  now += milliseconds{1};
+  ASSERT_FALSE(shouldDrop(milliseconds{10}));
+  ASSERT_EQ(codel.stats().drops, 1);
+}
+
+TEST_F(CodelTest, RejectInvalidTimes) {
+  ASSERT_THROW((Codel{milliseconds{0}, milliseconds{100}}), Exception);
+  ASSERT_THROW((Codel{milliseconds{10}, milliseconds{5}}), Exception);
+}
+
+}  // namespace detail
+}  // namespace unet
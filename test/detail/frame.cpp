@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
+
 #include <unet/detail/frame.hpp>
 
 namespace unet {
@@ -23,16 +25,117 @@ TEST(FrameTest, Make) {
 
 TEST(FrameTest, Copy) {
   auto f1 = Frame::makeStr("abc...def...");
-  f1->net = f1->data + 3;
-  f1->transport = f1->data + 6;
-  f1->netLen = 9;
-  f1->transportLen = 6;
+  f1->setNet(f1->data + 3, 9);
+  f1->setTransport(f1->data + 6, 6);
 
   auto f2 = Frame::makeCopy(*f1);
-  ASSERT_EQ(f2->net, f2->data + 3);
-  ASSERT_EQ(f2->transport, f2->data + 6);
-  ASSERT_EQ(f2->netLen, 9);
-  ASSERT_EQ(f2->transportLen, 6);
+  ASSERT_TRUE(*f2 == "abc...def...");
+  ASSERT_EQ(f2->net(), f2->data + 3);
+  ASSERT_EQ(f2->transport(), f2->data + 6);
+  ASSERT_EQ(f2->netLen(), 9);
+  ASSERT_EQ(f2->transportLen(), 6);
+}
+
+TEST(FrameTest, Layout) {
+  auto f = Frame::makeUninitialized(100);
+  ASSERT_EQ(f->net(), nullptr);
+  ASSERT_EQ(f->transport(), nullptr);
+
+  // The buffer lives in the same allocation right after the metadata.
+  auto p = reinterpret_cast<std::uintptr_t>(f.get());
+  ASSERT_EQ(p % 64, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(f->data) % 64, 0);
+  ASSERT_LE(reinterpret_cast<std::uintptr_t>(f->data) - p, 64);
+}
+
+TEST(FrameTest, PushPull) {
+  auto f = Frame::makeUninitialized(4, nullptr, 8);
+  std::memcpy(f->data, "data", 4);
+  f->setNet(f->data, 4);
+  ASSERT_EQ(f->headroom(), 8);
+  ASSERT_EQ(f->tailroom(), 0);
+
+  // Headers are prepended in place and the layers stay put.
+  std::memcpy(f->push(3), "hdr", 3);
+  ASSERT_TRUE(*f == "hdrdata");
+  ASSERT_EQ(f->headroom(), 5);
+  ASSERT_EQ(f->net(), f->data + 3);
+  ASSERT_EQ(f->netLen(), 4);
+
+  f->pull(5);
+  ASSERT_TRUE(*f == "ta");
+  ASSERT_EQ(f->net(), nullptr);
+  ASSERT_EQ(f->netLen(), 0);
+
+  f->pull(2);
+  ASSERT_EQ(f->dataLen, 0);
+  ASSERT_EQ(f->headroom(), 12);
+}
+
+TEST(FrameTest, Shared) {
+  auto owner = Frame::makeStr("abc...def...");
+  owner->setNet(owner->data + 3, 9);
+  ASSERT_FALSE(owner->shared());
+
+  auto f1 = Frame::makeShared(*owner, *owner);
+  auto f2 = Frame::makeShared(*f1, *f1);
+  ASSERT_TRUE(owner->shared());
+  ASSERT_EQ(f1->data, owner->data);
+  ASSERT_EQ(f2->data, owner->data);
+  ASSERT_EQ(f2->net(), owner->data + 3);
+  ASSERT_EQ(f2->netLen(), 9);
+
+  // The bytes outlive the owner until the last frame sharing them is gone.
+  owner.reset();
+  f1.reset();
+  ASSERT_TRUE(*f2 == "abc...def...");
+
+  Frame::unshare(f2);
+  ASSERT_FALSE(f2->shared());
+  ASSERT_TRUE(*f2 == "abc...def...");
+}
+
+TEST(FrameTest, Unshare) {
+  auto owner = Frame::makeStr("abc");
+  auto p = owner->data;
+  Frame::unshare(owner);
+  ASSERT_EQ(owner->data, p);
+
+  auto f = Frame::makeShared(*owner, *owner);
+  Frame::unshare(owner);
+  ASSERT_NE(owner->data, p);
+  ASSERT_FALSE(owner->shared());
+  ASSERT_EQ(f->data, p);
+
+  owner->data[0] = 'x';
+  ASSERT_TRUE(*f == "abc");
+}
+
+TEST(FrameTest, Chain) {
+  auto payload = Frame::makeStr("..pay..");
+  auto f = Frame::makeStr("hdr");
+  f->setNet(f->data + 1, 2);
+  f->append(Frame::makeRef(*payload, payload->data + 2, 3));
+  f->append(Frame::makeStr("load"));
+  ASSERT_EQ(f->dataLen, 3);
+  ASSERT_EQ(f->chainLen(), 10);
+  ASSERT_EQ(f->frag()->data, payload->data + 2);
+  ASSERT_TRUE(payload->shared());
+
+  // Referenced bytes outlive the frame they were taken from.
+  payload.reset();
+  ASSERT_TRUE(*f->frag()->frag() == "load");
+  ASSERT_EQ(f->frag()->frag()->frag(), nullptr);
+
+  // Copies gather all segments.
+  ASSERT_TRUE(*Frame::makeCopy(*f) == "hdrpayload");
+
+  f->doIpv4Routing = true;
+  Frame::flatten(f);
+  ASSERT_TRUE(*f == "hdrpayload");
+  ASSERT_EQ(f->frag(), nullptr);
+  ASSERT_EQ(f->net(), f->data + 1);
+  ASSERT_TRUE(f->doIpv4Routing);
 }
 
 TEST(FrameTest, DataAs) {
@@ -45,8 +148,7 @@ TEST(FrameTest, DataAs) {
 
 TEST(FrameTest, NetAs) {
   auto f = Frame::makeUninitialized(sizeof(S) * 2);
-  f->net = f->data + sizeof(S);
-  f->netLen = f->dataLen - sizeof(S);
+  f->setNet(f->data + sizeof(S), f->dataLen - sizeof(S));
   f->data[4] = 42;
   ASSERT_EQ(f->netAs<S>()->a, 42);
   f->netAs<S>()->a = 0;
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <unet/detail/frame_pool.hpp>
+
+namespace unet {
+namespace detail {
+
+TEST(FramePoolTest, Recycle) {
+  FramePool pool{1'024 * 1'024};
+
+  auto f = Frame::makeUninitialized(100, &pool);
+  auto p = f.get();
+  f->setNet(f->data + 14, 86);
+  f->doIpv4Routing = true;
+  f.reset();
+
+  // The frame comes back for any length in its size class w/clean metadata.
+  for (auto i = 0; i < 100; i++) {
+    auto g = Frame::makeUninitialized(65 + i % 60, &pool);
+    ASSERT_EQ(g.get(), p);
+    ASSERT_EQ(g->dataLen, 65 + i % 60);
+    ASSERT_EQ(g->net(), nullptr);
+    ASSERT_EQ(g->netLen(), 0);
+    ASSERT_FALSE(g->doIpv4Routing);
+  }
+
+  ASSERT_EQ(pool.allocations(), 1);
+}
+
+TEST(FramePoolTest, SizeClasses) {
+  FramePool pool{1'024 * 1'024};
+
+  auto small = Frame::makeUninitialized(60, &pool);
+  auto large = Frame::makeUninitialized(1'500, &pool);
+  small.reset();
+  large.reset();
+  ASSERT_EQ(pool.freeLen(), 64 + 2'048);
+
+  auto f = Frame::makeCopy(*Frame::makeStr("abc"), &pool);
+  auto g = Frame::makeUninitialized(2'000, &pool);
+  ASSERT_EQ(pool.allocations(), 2);
+  ASSERT_TRUE(*f == "abc");
+  ASSERT_EQ(pool.freeLen(), 0);
+}
+
+TEST(FramePoolTest, RecycleSegmentedFrames) {
+  FramePool pool{1'024 * 1'024};
+
+  // Frames for devices which segment and coalesce exceed 64K.
+  auto p = Frame::makeUninitialized(65'549, &pool).get();
+  auto f = Frame::makeUninitialized(65'549, &pool);
+  ASSERT_EQ(pool.allocations(), 1);
+  ASSERT_EQ(f.get(), p);
+}
+
+TEST(FramePoolTest, Headroom) {
+  FramePool pool{1'024 * 1'024};
+
+  // Headroom counts towards the size class and the rest is tailroom.
+  auto f = Frame::makeUninitialized(40, &pool, 32);
+  ASSERT_EQ(f->headroom(), 32);
+  ASSERT_EQ(f->tailroom(), 128 - 72);
+  std::memcpy(f->put(4), "tail", 4);
+  ASSERT_EQ(f->dataLen, 44);
+  f.reset();
+
+  f = Frame::makeUninitialized(100, &pool, 16);
+  ASSERT_EQ(pool.allocations(), 1);
+  ASSERT_EQ(f->headroom(), 16);
+  ASSERT_EQ(f->dataLen, 100);
+}
+
+TEST(FramePoolTest, Shared) {
+  FramePool pool{1'024 * 1'024};
+
+  // Frames sharing bytes go back to the pool once the last of them is gone.
+  auto owner = Frame::makeUninitialized(1'000, &pool);
+  auto clone = Frame::makeShared(*owner, *owner);
+  owner.reset();
+  ASSERT_EQ(pool.freeLen(), 0);
+  clone.reset();
+  ASSERT_EQ(pool.freeLen(), 64 + 1'024);
+
+  auto f = Frame::makeUninitialized(1'000, &pool);
+  ASSERT_FALSE(f->shared());
+  f = Frame::makeUninitialized(10, &pool);
+  ASSERT_EQ(pool.allocations(), 2);
+}
+
+TEST(FramePoolTest, MaxFreeLen) {
+  FramePool pool{128};
+
+  auto f1 = Frame::makeUninitialized(64, &pool);
+  auto f2 = Frame::makeUninitialized(64, &pool);
+  auto f3 = Frame::makeUninitialized(64, &pool);
+  f1.reset();
+  f2.reset();
+  f3.reset();
+  ASSERT_EQ(pool.freeLen(), 128);
+
+  // Huge frames are never kept around.
+  Frame::makeUninitialized(1'000'000, &pool).reset();
+  ASSERT_EQ(pool.freeLen(), 128);
+}
+
+TEST(FramePoolTest, Arena) {
+  auto arena = std::make_unique<Arena>(4'096, false);
+  auto& a = *arena;
+  FramePool pool{0, std::move(arena)};
+  ASSERT_EQ(pool.arena(), &a);
+
+  // Frames come from the arena until it runs out and stay w/the pool even
+  // beyond maxFreeLen.
+  std::vector<FramePtr> fs;
+  while (a.used() + 128 <= a.len()) {
+    fs.push_back(Frame::makeUninitialized(64, &pool));
+    ASSERT_TRUE(a.contains(fs.back().get()));
+  }
+  auto f = Frame::makeUninitialized(64, &pool);
+  ASSERT_FALSE(a.contains(f.get()));
+
+  auto p = fs.back().get();
+  fs.clear();
+  f.reset();
+  ASSERT_EQ(pool.freeLen(), a.used() / 2);
+  ASSERT_EQ(Frame::makeUninitialized(64, &pool).get(), p);
+}
+
+}  // namespace detail
+}  // namespace unet
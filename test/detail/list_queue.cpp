@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include <unet/detail/list_queue.hpp>
+
+namespace unet {
+namespace detail {
+
+TEST(ListQueueTest, PushAndPop) {
+  ListQueue q{6, ListQueue::Policy::DataLen};
+
+  auto f1 = Frame::makeStr("ab");
+  f1->append(Frame::makeStr("cd"));
+  q.push(f1);
+  ASSERT_FALSE(f1);
+
+  auto f2 = Frame::makeStr("e");
+  q.push(f2);
+  ASSERT_FALSE(f2);
+
+  auto f3 = Frame::makeStr("f");
+  q.push(f3);
+  ASSERT_FALSE(f3);
+  ASSERT_FALSE(q.hasCapacity());
+
+  // Payload segments stay w/their frame.
+  auto f4 = q.pop();
+  ASSERT_TRUE(*Frame::makeCopy(*f4) == "abcd");
+  ASSERT_EQ(*q.pop(), "e");
+  ASSERT_EQ(*q.peek(), "f");
+  ASSERT_TRUE(q.hasCapacity(5));
+}
+
+}  // namespace detail
+}  // namespace unet
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <unet/detail/mem_budget.hpp>
+
+namespace unet {
+namespace detail {
+
+TEST(MemBudgetTest, ChargeAndRefund) {
+  MemBudget budget{100, 30};
+
+  ASSERT_TRUE(budget.charge(60));
+  ASSERT_FALSE(budget.low());
+  ASSERT_TRUE(budget.charge(20));
+  ASSERT_TRUE(budget.low());
+
+  // Charges exceeding what is left are refused as a whole.
+  ASSERT_FALSE(budget.charge(21));
+  ASSERT_EQ(budget.used(), 80);
+  ASSERT_TRUE(budget.charge(20));
+
+  budget.refund(50);
+  ASSERT_EQ(budget.used(), 50);
+  ASSERT_FALSE(budget.low());
+
+  // The budget remembers it ran low after it recovered.
+  ASSERT_TRUE(budget.takeRanLow());
+  ASSERT_FALSE(budget.takeRanLow());
+}
+
+TEST(MemBudgetTest, Accounts) {
+  auto budget = std::make_shared<MemBudget>(100, 0);
+  MemAccount a{budget};
+  MemAccount b{budget};
+
+  ASSERT_TRUE(a.charge(70));
+  ASSERT_FALSE(b.charge(40));
+  ASSERT_TRUE(b.charge(30));
+  ASSERT_EQ(a.used(), 70);
+  ASSERT_EQ(b.used(), 30);
+  ASSERT_EQ(budget->used(), 100);
+
+  a.refund(70);
+  b.refund(30);
+  ASSERT_EQ(budget->used(), 0);
+
+  // Accounts w/o a budget only keep count.
+  MemAccount c;
+  ASSERT_TRUE(c.charge(1'000));
+  ASSERT_FALSE(c.low());
+  c.refund(1'000);
+}
+
+}  // namespace detail
+}  // namespace unet
@@ -1,12 +1,14 @@
 #include <gtest/gtest.h>
 
+#include <chrono>
+
 #include <unet/detail/queue.hpp>
 
 namespace unet {
 namespace detail {
 
 TEST(QueueTest, PushPeekAndPop) {
-  Queue q{2};
+  Queue<> q{2};
 
   auto f1 = Frame::makeStr("a");
   q.push(f1);
@@ -33,8 +35,34 @@ TEST(QueueTest, PushPeekAndPop) {
   ASSERT_EQ(*f6, "b");
 }
 
+TEST(QueueTest, PushChains) {
+  Queue<queue_policy::DataLen> q{10};
+
+  auto f1 = Frame::makeStr("ab");
+  f1->append(Frame::makeStr("cd"));
+  f1->append(Frame::makeStr("ef"));
+  q.push(f1);
+  ASSERT_FALSE(f1);
+
+  auto f2 = Frame::makeStr("g");
+  f2->append(Frame::makeStr("hi"));
+  q.push(f2);
+  ASSERT_FALSE(f2);
+  ASSERT_FALSE(q.hasCapacity(2));
+
+  // Payload segments stay w/their frame.
+  auto f3 = q.pop();
+  ASSERT_EQ(f3->chainLen(), 6);
+  ASSERT_TRUE(*Frame::makeCopy(*f3) == "abcdef");
+  ASSERT_TRUE(q.hasCapacity(7));
+
+  auto f4 = q.pop();
+  ASSERT_TRUE(*Frame::makeCopy(*f4) == "ghi");
+  ASSERT_FALSE(q.pop());
+}
+
 TEST(QueueTest, PushFull) {
-  Queue q{1};
+  Queue<> q{1};
 
   auto f1 = Frame::makeStr("a");
   q.push(f1);
@@ -46,7 +74,7 @@ TEST(QueueTest, PushFull) {
 }
 
 TEST(QueueTest, PeekPopEmpty) {
-  Queue q{1};
+  Queue<> q{1};
 
   auto f1 = q.peek();
   ASSERT_FALSE(f1);
@@ -56,7 +84,7 @@ TEST(QueueTest, PeekPopEmpty) {
 }
 
 TEST(QueueTest, PopAddsCapacity) {
-  Queue q{1};
+  Queue<> q{1};
 
   auto f1 = Frame::makeStr("a");
   q.push(f1);
@@ -76,7 +104,7 @@ TEST(QueueTest, PopAddsCapacity) {
 }
 
 TEST(QueueTest, HasCapacity) {
-  Queue q{1};
+  Queue<> q{1};
   ASSERT_TRUE(q.hasCapacity());
 
   auto f = Frame::makeStr("a");
@@ -88,7 +116,7 @@ TEST(QueueTest, HasCapacity) {
 }
 
 TEST(QueueTest, DestroyHuge) {
-  Queue q{100'000};
+  Queue<> q{100'000};
 
   for (auto count = 0; count < 100'000; count++) {
     auto f = Frame::makeUninitialized(1);
@@ -105,7 +133,7 @@ TEST(QueueTest, NonDefaultPolicy) {
   auto p2 = f2.get();
   auto p3 = f3.get();
 
-  Queue q{4, Queue::Policy::DataLen};
+  Queue<queue_policy::DataLen> q{4};
 
   q.push(f1);
   ASSERT_FALSE(f1);
@@ -129,5 +157,113 @@ TEST(QueueTest, NonDefaultPolicy) {
   ASSERT_EQ(f6.get(), p3);
 }
 
+TEST(QueueTest, ExplicitPolicy) {
+  // Frames take up what they were pushed w/and stop at the last slot.
+  Queue<queue_policy::Explicit> q{10, 2};
+  auto f1 = Frame::makeStr("a");
+  auto f2 = Frame::makeStr("b");
+  auto f3 = Frame::makeStr("c");
+
+  q.push(f1, 6);
+  ASSERT_FALSE(f1);
+  ASSERT_FALSE(q.hasCapacity(5));
+
+  q.push(f2, 1);
+  ASSERT_FALSE(f2);
+  ASSERT_FALSE(q.hasCapacity(1));
+
+  q.push(f3, 1);
+  ASSERT_TRUE(f3);
+
+  q.pop();
+  ASSERT_TRUE(q.hasCapacity(9));
+  ASSERT_FALSE(q.hasCapacity(10));
+}
+
+TEST(QueueTest, WrapAround) {
+  Queue<> q{3};
+
+  for (auto round = 0; round < 10; round++) {
+    auto f1 = Frame::makeStr(std::to_string(round));
+    auto f2 = Frame::makeStr("x");
+    q.push(f1);
+    q.push(f2);
+    ASSERT_FALSE(f1);
+    ASSERT_FALSE(f2);
+
+    ASSERT_EQ(*q.peek(), std::to_string(round));
+    ASSERT_EQ(*q.pop(), std::to_string(round));
+    ASSERT_EQ(*q.pop(), "x");
+    ASSERT_FALSE(q.peek());
+  }
+}
+
+TEST(QueueTest, GrowSlots) {
+  Queue<> q{100};
+
+  // Wrap around the initial slots before they grow so frames must keep their
+  // order across the move.
+  for (auto i = 0; i < 10; i++) {
+    auto f = Frame::makeStr("x");
+    q.push(f);
+    q.pop();
+  }
+
+  for (auto i = 0; i < 100; i++) {
+    auto f = Frame::makeStr(std::to_string(i));
+    q.push(f);
+    ASSERT_FALSE(f);
+  }
+  ASSERT_FALSE(q.hasCapacity());
+
+  for (auto i = 0; i < 100; i++) {
+    ASSERT_EQ(*q.pop(), std::to_string(i));
+  }
+  ASSERT_FALSE(q.peek());
+}
+
+TEST(QueueTest, MemAccount) {
+  auto f1 = Frame::makeStr("a");
+  auto f2 = Frame::makeStr("b");
+  auto memLen = f1->memLen();
+  MemAccount account{std::make_shared<MemBudget>(memLen, 0)};
+  Queue<> q{10, 0, &account};
+
+  // Frames are charged while queued and dropped once the budget is spent.
+  q.push(f1);
+  ASSERT_FALSE(f1);
+  ASSERT_EQ(account.used(), memLen);
+  q.push(f2);
+  ASSERT_TRUE(f2);
+
+  ASSERT_EQ(*q.pop(), "a");
+  ASSERT_EQ(account.used(), 0);
+  q.push(f2);
+  ASSERT_FALSE(f2);
+}
+
+TEST(QueueTest, Codel) {
+  auto now = Codel::Clock::time_point{} + std::chrono::hours{1};
+  Codel codel{std::chrono::milliseconds{5}, std::chrono::milliseconds{100},
+              [&now]() { return now; }};
+  Queue<> q{10, 0, nullptr, &codel};
+
+  for (auto str : {"a", "b", "c"}) {
+    auto f = Frame::makeStr(str);
+    q.push(f);
+  }
+
+  now += std::chrono::milliseconds{10};
+  ASSERT_EQ(*q.peek(), "a");
+  ASSERT_EQ(*q.pop(), "a");
+
+  // The queue stood above target for an interval so its head is dropped.
+  now += std::chrono::milliseconds{100};
+  ASSERT_EQ(*q.peek(), "c");
+  ASSERT_EQ(codel.stats().drops, 1);
+  ASSERT_EQ(*q.pop(), "c");
+  ASSERT_FALSE(q.peek());
+}
+
 }  // namespace detail
 }  // namespace unet
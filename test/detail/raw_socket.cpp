@@ -4,6 +4,7 @@
 #include <unet/detail/raw_socket.hpp>
 #include <unet/detail/socket_set.hpp>
 #include <unet/event.hpp>
+#include <unet/exception.hpp>
 
 namespace unet {
 namespace detail {
@@ -25,6 +26,7 @@ class RawSocketTest : public Test {
                       1500,
                       1500,
                       1500,
+                      1500,
                       std::make_shared<Serializer>(EthernetAddr{}, Ipv4Addr{}),
                       sockets,
                       ss,
@@ -89,8 +91,10 @@ TEST_F(RawSocketTest, ReadCallback) {
 
   ss.dispatch();
 
-  socket->process(*Frame::makeStr(kMessage));
-  socket->process(*Frame::makeStr(kMessage));
+  FramePtr copy;
+  socket->process(*Frame::makeStr(kMessage), copy);
+  socket->process(*Frame::makeStr(kMessage), copy);
+  ASSERT_FALSE(copy);
 
   ss.dispatch();
 
@@ -103,6 +107,199 @@ TEST_F(RawSocketTest, ReadCallback) {
   ss.dispatch();
 }
 
+TEST_F(RawSocketTest, BorrowAndRelease) {
+  {
+    InSequence s;
+    EXPECT_CALL(cb, Call(Event::Send | Event::Read)).Times(2);
+    EXPECT_CALL(cb, Call(eventAsInt(Event::Send))).Times(1);
+  }
+
+  FramePtr copy;
+  auto f = Frame::makeStr(kMessage);
+  socket->process(*f, copy);
+  socket->process(*Frame::makeStr("!"), copy);
+
+  // The socket hands out the bytes of the frame it was given until released.
+  std::size_t bufLen;
+  ASSERT_EQ(socket->borrow(bufLen), f->data);
+  ASSERT_EQ(bufLen, kMessage.size());
+  ASSERT_EQ(socket->borrow(bufLen), f->data);
+
+  ss.dispatch();
+
+  socket->release();
+  auto buf = socket->borrow(bufLen);
+  ASSERT_EQ(bufLen, 1);
+  ASSERT_EQ(*buf, '!');
+
+  ss.dispatch();
+
+  socket->release();
+  ASSERT_EQ(socket->borrow(bufLen), nullptr);
+  ASSERT_EQ(bufLen, 0);
+  socket->release();
+
+  ss.dispatch();
+}
+
+TEST_F(RawSocketTest, ShareAcrossSockets) {
+  EXPECT_CALL(cb, Call(testing::_)).Times(testing::AnyNumber());
+  auto other =
+      new RawSocket{RawSocket::kEthernet,
+                    1500,
+                    1500,
+                    1500,
+                    1500,
+                    std::make_shared<Serializer>(EthernetAddr{}, Ipv4Addr{}),
+                    sockets,
+                    ss,
+                    cb.AsStdFunction()};
+
+  // Bytes the frame does not own are copied once for both sockets.
+  std::string message = kMessage;
+  auto f = Frame::makeUninitialized(0);
+  f->data = reinterpret_cast<std::uint8_t*>(&message[0]);
+  f->dataLen = message.size();
+
+  FramePtr copy;
+  socket->process(*f, copy);
+  ASSERT_TRUE(copy);
+  auto p = copy.get();
+  other->process(*f, copy);
+  ASSERT_EQ(copy.get(), p);
+  ASSERT_TRUE(copy->shared());
+  copy.reset();
+
+  message.assign(message.size(), '!');
+  ASSERT_NO_FATAL_FAILURE(ReadMessage());
+  std::swap(socket, other);
+  ASSERT_NO_FATAL_FAILURE(ReadMessage());
+
+  socket->close();
+  other->close();
+}
+
+TEST_F(RawSocketTest, WithholdSendWhileMemLow) {
+  MockCallback otherCb;
+  EXPECT_CALL(cb, Call(eventAsInt(Event::Send))).Times(3);
+  EXPECT_CALL(otherCb, Call(eventAsInt(Event::Send))).Times(2);
+
+  // Any frame queued runs the budget low.
+  auto budget = std::make_shared<MemBudget>(10'000, 10'000);
+  auto other =
+      new RawSocket{RawSocket::kEthernet,
+                    1500,
+                    1500,
+                    1500,
+                    1500,
+                    std::make_shared<Serializer>(EthernetAddr{}, Ipv4Addr{}),
+                    sockets,
+                    ss,
+                    otherCb.AsStdFunction(),
+                    budget};
+  other->subscribedEventMaskAdd(eventAsInt(Event::Send));
+
+  ss.dispatch();
+
+  // Frames can still be sent while the budget lasts w/o signaling Send.
+  auto buf = reinterpret_cast<const std::uint8_t*>(kMessage.data());
+  ASSERT_EQ(other->send(buf, kMessage.size()), kMessage.size());
+  ASSERT_EQ(other->send(buf, kMessage.size()), kMessage.size());
+  ASSERT_GT(budget->used(), 0);
+  ASSERT_EQ(other->memAccount().used(), budget->used());
+
+  ss.dispatch();
+
+  other->popFrame();
+  other->popFrame();
+  ASSERT_EQ(budget->used(), 0);
+
+  ss.dispatch();
+
+  other->close();
+}
+
+TEST_F(RawSocketTest, ReserveAndCommit) {
+  {
+    InSequence s;
+    EXPECT_CALL(cb, Call(eventAsInt(Event::Send))).Times(2);
+  }
+
+  ss.dispatch();
+
+  // Too short for an Ethernet header...
+  std::size_t bufLen = 1;
+  ASSERT_FALSE(socket->reserve(bufLen));
+  ASSERT_EQ(socket->commit(1), 0);
+
+  // Truncated to the MTU...
+  bufLen = 2000;
+  auto buf = socket->reserve(bufLen);
+  ASSERT_TRUE(buf);
+  ASSERT_EQ(bufLen, 1500);
+
+  // Only the bytes written are sent.
+  std::copy(kMessage.begin(), kMessage.end(), buf);
+  ASSERT_EQ(socket->commit(kMessage.size()), kMessage.size());
+  ASSERT_EQ(socket->commit(kMessage.size()), 0);
+
+  auto f = socket->popFrame();
+  ASSERT_TRUE(f);
+  ASSERT_EQ(f->data, buf);
+  ASSERT_EQ(*f, kMessage);
+
+  // A reservation must be committed before sending or reserving again.
+  bufLen = kMessage.size();
+  ASSERT_TRUE(socket->reserve(bufLen));
+  ASSERT_THROW(socket->reserve(bufLen), Exception);
+  ASSERT_THROW(
+      socket->send(reinterpret_cast<const std::uint8_t*>(kMessage.data()),
+                   kMessage.size()),
+      Exception);
+  ASSERT_EQ(socket->commit(0), 0);
+
+  // Committing 0 bytes dropped the frame.
+  bufLen = kMessage.size();
+  buf = socket->reserve(bufLen);
+  std::copy(kMessage.begin(), kMessage.end(), buf);
+  ASSERT_EQ(socket->commit(kMessage.size()), kMessage.size());
+  ASSERT_EQ(*socket->popFrame(), kMessage);
+  ASSERT_FALSE(socket->popFrame());
+
+  ss.dispatch();
+}
+
+TEST_F(RawSocketTest, ReserveIpv4) {
+  auto ipv4 = new RawSocket{
+      RawSocket::kIpv4,
+      1500,
+      1500,
+      1500,
+      1500,
+      std::make_shared<Serializer>(EthernetAddr{}, Ipv4Addr{}),
+      sockets,
+      ss,
+      cb.AsStdFunction()};
+
+  std::size_t bufLen = sizeof(Ipv4Header) + kMessage.size();
+  auto buf = ipv4->reserve(bufLen);
+  ASSERT_TRUE(buf);
+  ASSERT_EQ(bufLen, sizeof(Ipv4Header) + kMessage.size());
+  std::copy(kMessage.begin(), kMessage.end(), buf + sizeof(Ipv4Header));
+  ASSERT_EQ(ipv4->commit(bufLen), bufLen);
+
+  // The Ethernet header below the socket is filled in.
+  auto f = ipv4->popFrame();
+  ASSERT_TRUE(f);
+  ASSERT_EQ(f->net(), buf);
+  ASSERT_EQ(f->netLen(), bufLen);
+  ASSERT_EQ(f->dataLen, sizeof(EthernetHeader) + bufLen);
+  ASSERT_EQ(f->dataAs<EthernetHeader>()->ethType, eth_type::kIpv4);
+  ASSERT_TRUE(f->doIpv4Routing);
+
+  ipv4->close();
+}
+
 TEST_F(RawSocketTest, Close) {
   {
     InSequence s;
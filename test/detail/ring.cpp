@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include <unet/detail/ring.hpp>
+
+namespace unet {
+namespace detail {
+
+TEST(RingTest, SpscPushAndPop) {
+  SpscRing ring{3};
+  FramePtr fs[5];
+  for (auto i = 0; i < 5; i++) {
+    fs[i] = Frame::makeStr(std::to_string(i));
+  }
+
+  // The ring is rounded up to 4 frames.
+  ASSERT_EQ(ring.push(fs, 5), 4);
+  ASSERT_FALSE(fs[3]);
+  ASSERT_TRUE(fs[4]);
+  ring.push(fs[4]);
+  ASSERT_TRUE(fs[4]);
+
+  ASSERT_EQ(ring.pop(fs, 3), 3);
+  ASSERT_EQ(*fs[0], "0");
+  ASSERT_EQ(*fs[2], "2");
+
+  ring.push(fs[4]);
+  ASSERT_FALSE(fs[4]);
+  ASSERT_EQ(*ring.pop(), "3");
+  ASSERT_EQ(*ring.pop(), "4");
+  ASSERT_FALSE(ring.pop());
+}
+
+TEST(RingTest, MpscPushAndPop) {
+  MpscRing ring{2};
+  FramePtr fs[3];
+  for (auto i = 0; i < 3; i++) {
+    fs[i] = Frame::makeStr(std::to_string(i));
+  }
+
+  ASSERT_EQ(ring.push(fs, 3), 2);
+  ASSERT_TRUE(fs[2]);
+  ASSERT_EQ(*ring.pop(), "0");
+
+  ring.push(fs[2]);
+  ASSERT_FALSE(fs[2]);
+  ASSERT_EQ(ring.pop(fs, 3), 2);
+  ASSERT_EQ(*fs[0], "1");
+  ASSERT_EQ(*fs[1], "2");
+  ASSERT_FALSE(ring.pop());
+}
+
+TEST(RingTest, MpscAcrossThreads) {
+  constexpr auto kProducerNr = 4;
+  constexpr auto kFrameNr = 1'000;
+  MpscRing ring{64};
+
+  // Each producer pushes its frames in order, tagged w/its index.
+  std::vector<std::thread> producers;
+  for (auto p = 0; p < kProducerNr; p++) {
+    producers.emplace_back([&ring, p]() {
+      for (auto i = 0; i < kFrameNr; i++) {
+        auto f = Frame::makeUninitialized(2);
+        f->data[0] = p;
+        f->data[1] = i % 256;
+        while (f) {
+          ring.push(f);
+        }
+      }
+    });
+  }
+
+  int next[kProducerNr]{};
+  FramePtr fs[16];
+  for (auto popped = 0; popped < kProducerNr * kFrameNr;) {
+    auto n = ring.pop(fs, 16);
+    for (std::size_t i = 0; i < n; i++) {
+      auto p = fs[i]->data[0];
+      EXPECT_EQ(fs[i]->data[1], next[p]++ % 256);
+    }
+    popped += n;
+  }
+
+  for (auto& t : producers) {
+    t.join();
+  }
+  ASSERT_FALSE(ring.pop());
+}
+
+}  // namespace detail
+}  // namespace unet
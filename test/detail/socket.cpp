@@ -21,7 +21,7 @@ using MockCallback = StrictMock<MockFunction<void(std::uint32_t)>>;
 class MockSocket : public Socket {
  public:
   MockSocket(SocketSet& socketSet, Callback callback)
-      : Socket{socketSet, 1024, Queue::Policy::One, callback} {}
+      : Socket{socketSet, 1024, 1024, callback} {}
 
   MOCK_METHOD0(onFramePopped, void());
 };
@@ -241,7 +241,7 @@ TEST_F(SocketTest, DestroyPrevAndNextInline) {
 }
 
 TEST_F(SocketTest, OnFramePoppedDestroyThisInline) {
-  Queue q{6};
+  Queue<> q{6};
 
   PushFrame(*s1, "a");
   PushFrame(*s1, "b");
@@ -269,7 +269,7 @@ TEST_F(SocketTest, OnFramePoppedDestroyThisInline) {
 }
 
 TEST_F(SocketTest, OnFramePoppedDestroyPrevAndNextInline) {
-  Queue q{6};
+  Queue<> q{6};
 
   PushFrame(*s1, "a");
   PushFrame(*s1, "b");
@@ -297,7 +297,7 @@ TEST_F(SocketTest, OnFramePoppedDestroyPrevAndNextInline) {
 }
 
 TEST_F(SocketTest, OnFramePoppedException) {
-  Queue q{4};
+  Queue<> q{4};
 
   PushFrame(*s1, "a");
   PushFrame(*s1, "b");
@@ -323,12 +323,12 @@ TEST_F(SocketTest, OnFramePoppedException) {
 }
 
 TEST_F(SocketTest, OnFramePoppedEmpty) {
-  Queue q{1};
+  Queue<> q{1};
   q.pop();
 }
 
 TEST_F(SocketTest, RoundRobinDrain) {
-  Queue q{4};
+  Queue<> q{4};
   PushFrame(*s1, "a");
   PushFrame(*s1, "b");
   PushFrame(*s1, "c");
@@ -0,0 +1,74 @@
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <unet/detail/check.hpp>
+#include <unet/dev/dev.hpp>
+
+namespace unet {
+
+using testing::_;
+using testing::Return;
+
+namespace {
+
+class MockDev : public Dev {
+ public:
+  MOCK_METHOD2(send, std::size_t(const std::uint8_t*, std::size_t));
+  MOCK_METHOD2(read, std::size_t(std::uint8_t*, std::size_t));
+  MOCK_CONST_METHOD0(maxTransmissionUnit, std::size_t());
+};
+
+}  // namespace
+
+TEST(DevTest, SendBatchStopsWhenExhausted) {
+  std::uint8_t data[4]{};
+  DevBuf bufs[3]{{data, 1}, {data, 2}, {data, 3}};
+
+  MockDev dev;
+  EXPECT_CALL(dev, send(data, 1)).WillOnce(Return(1));
+  EXPECT_CALL(dev, send(data, 2)).WillOnce(Return(0));
+  EXPECT_CALL(dev, send(data, 3)).Times(0);
+
+  ASSERT_EQ(dev.sendBatch(bufs, 3), 1);
+}
+
+TEST(DevTest, ReadBatchUpdatesLens) {
+  std::uint8_t data[8]{};
+  DevBuf bufs[3]{{data, 8}, {data, 8}, {data, 8}};
+
+  MockDev dev;
+  EXPECT_CALL(dev, read(data, 8))
+      .WillOnce(Return(3))
+      .WillOnce(Return(5))
+      .WillOnce(Return(0));
+
+  ASSERT_EQ(dev.readBatch(bufs, 3), 2);
+  ASSERT_EQ(bufs[0].bufLen, 3);
+  ASSERT_EQ(bufs[1].bufLen, 5);
+}
+
+TEST(DevTest, ReadBatchFull) {
+  std::uint8_t data[8]{};
+  DevBuf bufs[2]{{data, 8}, {data, 8}};
+
+  MockDev dev;
+  EXPECT_CALL(dev, read(_, _)).Times(2).WillRepeatedly(Return(8));
+
+  ASSERT_EQ(dev.readBatch(bufs, 2), 2);
+}
+
+TEST(DevTest, CompleteChecksum) {
+  std::uint8_t data[9]{0xff, 0xff, 0x12, 0x34, 0x00, 0x00, 0x56, 0x78, 0x9a};
+
+  DevOffload offload;
+  offload.csumPartial = true;
+  offload.csumStart = 2;
+  offload.csumOffset = 2;
+  completeChecksum(data, sizeof(data), offload);
+
+  ASSERT_FALSE(offload.csumPartial);
+  ASSERT_EQ(data[0], 0xff);
+  ASSERT_EQ(detail::checksum(data + 2, sizeof(data) - 2), 0);
+}
+
+}  // namespace unet
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include <unet/dev/mem_link.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+TEST(MemLinkTest, SendAndReadBothWays) {
+  auto link = MemLink::makePair(64, 4);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  std::uint8_t buf[64];
+  ASSERT_EQ(a.send(reinterpret_cast<const std::uint8_t*>("hello"), 5), 5);
+  ASSERT_EQ(b.read(buf, sizeof(buf)), 5);
+  ASSERT_EQ(std::memcmp(buf, "hello", 5), 0);
+  ASSERT_EQ(b.read(buf, sizeof(buf)), 0);
+
+  ASSERT_EQ(b.send(reinterpret_cast<const std::uint8_t*>("world!"), 6), 6);
+  ASSERT_EQ(a.read(buf, sizeof(buf)), 6);
+  ASSERT_EQ(std::memcmp(buf, "world!", 6), 0);
+}
+
+TEST(MemLinkTest, BatchesStopWhenRingIsFull) {
+  auto link = MemLink::makePair(64, 2);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  std::uint8_t data[3]{1, 2, 3};
+  DevBuf bufs[3]{{data, 1}, {data + 1, 1}, {data + 2, 1}};
+  ASSERT_EQ(a.sendBatch(bufs, 3), 2);
+
+  DevBuf reads[3];
+  ASSERT_EQ(b.readBatch(reads, 3), 2);
+  ASSERT_EQ(*reads[0].buf, 1);
+  ASSERT_EQ(*reads[1].buf, 2);
+
+  // Slots are held until the next read so the ring is still full.
+  ASSERT_EQ(a.sendBatch(bufs + 2, 1), 0);
+  ASSERT_EQ(b.readBatch(reads, 3), 0);
+  ASSERT_EQ(a.sendBatch(bufs + 2, 1), 1);
+  ASSERT_EQ(b.readBatch(reads, 3), 1);
+  ASSERT_EQ(*reads[0].buf, 3);
+}
+
+TEST(MemLinkTest, GatherSegments) {
+  auto link = MemLink::makePair(64);
+  ASSERT_TRUE(link.first->offloads() & dev_offload::kTxSg);
+
+  std::uint8_t hdr[2]{1, 2};
+  std::uint8_t payload[3]{3, 4, 5};
+  DevSeg segs[2]{{payload, 1}, {payload + 1, 2}};
+  DevBuf b{hdr, sizeof(hdr)};
+  b.segs = segs;
+  b.segsLen = 2;
+  ASSERT_EQ(link.first->sendBatch(&b, 1), 1);
+
+  std::uint8_t buf[64];
+  ASSERT_EQ(link.second->read(buf, sizeof(buf)), 5);
+  std::uint8_t expected[5]{1, 2, 3, 4, 5};
+  ASSERT_EQ(std::memcmp(buf, expected, 5), 0);
+}
+
+TEST(MemLinkTest, FrameTooLarge) {
+  auto link = MemLink::makePair(4);
+  std::uint8_t data[5]{};
+  ASSERT_THROW(link.first->send(data, sizeof(data)), Exception);
+}
+
+TEST(MemLinkTest, InvalidGeometry) {
+  ASSERT_THROW(MemLink::makePair(0), Exception);
+  ASSERT_THROW(MemLink::makePair(64, 0), Exception);
+}
+
+}  // namespace unet
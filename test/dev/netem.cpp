@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+
+#include <unet/dev/mem_link.hpp>
+#include <unet/dev/netem.hpp>
+#include <unet/exception.hpp>
+#include <unet/timer.hpp>
+
+namespace unet {
+
+static const std::chrono::steady_clock::time_point kTpNowBase{};
+
+class NetemTest : public testing::Test {
+ protected:
+  // Wraps one end of an in-memory link w/the impairments.
+  void wrap(const NetemParams& tx, const NetemParams& rx = NetemParams{}) {
+    auto link = MemLink::makePair(1'500);
+    netem_ = std::make_unique<Netem>(std::move(link.first), tx, rx);
+    netem_->setTimerManager(manager_);
+    peer_ = std::move(link.second);
+  }
+
+  // Return the number of frames read from dev.
+  static std::size_t drain(Dev& dev) {
+    std::uint8_t buf[1'500];
+    std::size_t read = 0;
+    while (dev.read(buf, sizeof(buf)) > 0) {
+      read++;
+    }
+    return read;
+  }
+
+  void runAt(std::chrono::milliseconds ms) {
+    manager_->run(kTpNowBase + ms);
+  }
+
+  std::shared_ptr<TimerManager> manager_ =
+      std::make_shared<TimerManager>(kTpNowBase);
+  std::unique_ptr<Netem> netem_;
+  std::unique_ptr<Dev> peer_;
+  std::uint8_t frame_[100]{};
+};
+
+TEST_F(NetemTest, PassThrough) {
+  wrap(NetemParams{});
+
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(drain(*peer_), 1);
+
+  ASSERT_EQ(peer_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(drain(*netem_), 1);
+}
+
+TEST_F(NetemTest, Delay) {
+  NetemParams params;
+  params.delay = std::chrono::milliseconds{10};
+  wrap(params, params);
+
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(peer_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  runAt(std::chrono::milliseconds{5});
+  ASSERT_EQ(drain(*peer_), 0);
+  ASSERT_EQ(drain(*netem_), 0);
+
+  runAt(std::chrono::milliseconds{11});
+  ASSERT_EQ(drain(*peer_), 1);
+
+  // Frames read are delayed from when they were first seen.
+  ASSERT_EQ(drain(*netem_), 0);
+  runAt(std::chrono::milliseconds{16});
+  ASSERT_EQ(drain(*netem_), 1);
+}
+
+TEST_F(NetemTest, LossAndDuplication) {
+  NetemParams lossy;
+  lossy.loss = 1;
+  wrap(lossy);
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(drain(*peer_), 0);
+  ASSERT_EQ(netem_->txStats().lost, 1);
+
+  NetemParams noisy;
+  noisy.duplicate = 1;
+  wrap(noisy);
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(drain(*peer_), 2);
+  ASSERT_EQ(netem_->txStats().duplicated, 1);
+}
+
+TEST_F(NetemTest, Reorder) {
+  NetemParams params;
+  params.delay = std::chrono::milliseconds{10};
+  params.reorder = 1;
+  wrap(params);
+
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(drain(*peer_), 1);
+  ASSERT_EQ(netem_->txStats().reordered, 1);
+}
+
+TEST_F(NetemTest, RateLimit) {
+  NetemParams params;
+  params.rate = 1'000;
+  wrap(params);
+
+  // Each frame takes 100ms to go across the link.
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  runAt(std::chrono::milliseconds{99});
+  ASSERT_EQ(drain(*peer_), 0);
+  runAt(std::chrono::milliseconds{101});
+  ASSERT_EQ(drain(*peer_), 1);
+  runAt(std::chrono::milliseconds{201});
+  ASSERT_EQ(drain(*peer_), 1);
+}
+
+TEST_F(NetemTest, QueueOverflow) {
+  NetemParams params;
+  params.delay = std::chrono::milliseconds{10};
+  params.queueLen = 1;
+  wrap(params);
+
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(netem_->send(frame_, sizeof(frame_)), sizeof(frame_));
+  ASSERT_EQ(netem_->txStats().overflowed, 1);
+  runAt(std::chrono::milliseconds{11});
+  ASSERT_EQ(drain(*peer_), 1);
+}
+
+TEST_F(NetemTest, NeedsTimerManager) {
+  Netem netem{MemLink::makePair(1'500).first, NetemParams{}};
+  ASSERT_THROW(netem.send(frame_, sizeof(frame_)), Exception);
+}
+
+}  // namespace unet
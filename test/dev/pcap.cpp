@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unet/dev/mem_link.hpp>
+#include <unet/dev/pcap_capture.hpp>
+#include <unet/dev/pcap_replay.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+class PcapTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    unlink(path_.c_str());
+  }
+
+  // Writes the raw bytes to the file at path_.
+  void write(const std::vector<std::uint8_t>& bytes) {
+    std::ofstream file{path_, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+  // Appends x in host byte order to bytes.
+  template <typename T>
+  static void append(std::vector<std::uint8_t>& bytes, T x) {
+    auto p = reinterpret_cast<const std::uint8_t*>(&x);
+    bytes.insert(bytes.end(), p, p + sizeof(x));
+  }
+
+  const std::string path_ =
+      "/tmp/unet-pcap-test-" + std::to_string(getpid()) + ".pcap";
+};
+
+TEST_F(PcapTest, CaptureAndReplay) {
+  std::vector<std::uint8_t> frames[3]{std::vector<std::uint8_t>(60, 1),
+                                      std::vector<std::uint8_t>(100, 2),
+                                      std::vector<std::uint8_t>(80, 3)};
+
+  {
+    PcapCapture capture{MemLink::makePair(1'500).first, path_};
+    for (auto& frame : frames) {
+      ASSERT_EQ(capture.send(frame.data(), frame.size()), frame.size());
+    }
+  }
+
+  PcapReplay replay{path_};
+  ASSERT_EQ(replay.frameCount(), 3);
+  ASSERT_EQ(replay.maxTransmissionUnit(), 100);
+
+  for (auto round = 0; round < 2; round++) {
+    DevBuf bufs[4];
+    ASSERT_EQ(replay.readBatch(bufs, 4), 3);
+    for (auto i = 0; i < 3; i++) {
+      ASSERT_EQ(bufs[i].bufLen, frames[i].size());
+      ASSERT_EQ(std::memcmp(bufs[i].buf, frames[i].data(), frames[i].size()),
+                0);
+    }
+
+    ASSERT_TRUE(replay.done());
+    ASSERT_EQ(replay.readBatch(bufs, 4), 0);
+    replay.rewind();
+  }
+}
+
+TEST_F(PcapTest, ReplayPcapng) {
+  std::vector<std::uint8_t> bytes;
+
+  // Section header...
+  append<std::uint32_t>(bytes, 0x0a0d0d0a);
+  append<std::uint32_t>(bytes, 28);
+  append<std::uint32_t>(bytes, 0x1a2b3c4d);
+  append<std::uint16_t>(bytes, 1);
+  append<std::uint16_t>(bytes, 0);
+  append<std::int64_t>(bytes, -1);
+  append<std::uint32_t>(bytes, 28);
+
+  // Ethernet interface w/nanosecond timestamps and a non-Ethernet one...
+  append<std::uint32_t>(bytes, 1);
+  append<std::uint32_t>(bytes, 32);
+  append<std::uint16_t>(bytes, 1);
+  append<std::uint16_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint16_t>(bytes, 9);
+  append<std::uint16_t>(bytes, 1);
+  append<std::uint32_t>(bytes, 9);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 32);
+
+  append<std::uint32_t>(bytes, 1);
+  append<std::uint32_t>(bytes, 20);
+  append<std::uint16_t>(bytes, 101);
+  append<std::uint16_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 20);
+
+  // A packet on each interface...
+  for (std::uint32_t id = 0; id < 2; id++) {
+    append<std::uint32_t>(bytes, 6);
+    append<std::uint32_t>(bytes, 40);
+    append<std::uint32_t>(bytes, id);
+    append<std::uint32_t>(bytes, 0);
+    append<std::uint32_t>(bytes, 1'000);
+    append<std::uint32_t>(bytes, 5);
+    append<std::uint32_t>(bytes, 5);
+    bytes.insert(bytes.end(), {'h', 'e', 'l', 'l', 'o', 0, 0, 0});
+    append<std::uint32_t>(bytes, 40);
+  }
+
+  write(bytes);
+
+  PcapReplay replay{path_};
+  ASSERT_EQ(replay.frameCount(), 1);
+
+  std::uint8_t buf[16];
+  ASSERT_EQ(replay.read(buf, sizeof(buf)), 5);
+  ASSERT_EQ(std::memcmp(buf, "hello", 5), 0);
+}
+
+TEST_F(PcapTest, ReplayInRealTime) {
+  std::vector<std::uint8_t> bytes;
+  append<std::uint32_t>(bytes, 0xa1b2c3d4);
+  append<std::uint16_t>(bytes, 2);
+  append<std::uint16_t>(bytes, 4);
+  append<std::int32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 65'535);
+  append<std::uint32_t>(bytes, 1);
+
+  // Two frames 50ms apart...
+  for (std::uint32_t usec : {900'000, 950'000}) {
+    append<std::uint32_t>(bytes, 7);
+    append<std::uint32_t>(bytes, usec);
+    append<std::uint32_t>(bytes, 1);
+    append<std::uint32_t>(bytes, 1);
+    bytes.push_back(0);
+  }
+
+  write(bytes);
+
+  PcapReplay replay{path_, true};
+  DevBuf bufs[2];
+  ASSERT_EQ(replay.readBatch(bufs, 2), 1);
+  ASSERT_EQ(replay.readBatch(bufs, 2), 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds{60});
+  ASSERT_EQ(replay.readBatch(bufs, 2), 1);
+  ASSERT_TRUE(replay.done());
+}
+
+TEST_F(PcapTest, Malformed) {
+  ASSERT_THROW(PcapReplay{path_}, Exception);
+
+  write({1, 2, 3, 4});
+  ASSERT_THROW(PcapReplay{path_}, Exception);
+
+  // A record which runs past the end of the file...
+  std::vector<std::uint8_t> bytes;
+  append<std::uint32_t>(bytes, 0xa1b2c3d4);
+  bytes.resize(20);
+  append<std::uint32_t>(bytes, 1);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 0);
+  append<std::uint32_t>(bytes, 100);
+  append<std::uint32_t>(bytes, 100);
+  write(bytes);
+  ASSERT_THROW(PcapReplay{path_}, Exception);
+}
+
+}  // namespace unet
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unet/dev/shm_link.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+TEST(ShmLinkTest, SendAndReadBothWays) {
+  auto link = ShmLink::makePair(64, 4);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  std::uint8_t buf[64];
+  ASSERT_EQ(a.send(reinterpret_cast<const std::uint8_t*>("hello"), 5), 5);
+  ASSERT_EQ(b.read(buf, sizeof(buf)), 5);
+  ASSERT_EQ(std::memcmp(buf, "hello", 5), 0);
+  ASSERT_EQ(b.read(buf, sizeof(buf)), 0);
+
+  ASSERT_EQ(b.send(reinterpret_cast<const std::uint8_t*>("world!"), 6), 6);
+  ASSERT_EQ(a.read(buf, sizeof(buf)), 6);
+  ASSERT_EQ(std::memcmp(buf, "world!", 6), 0);
+}
+
+TEST(ShmLinkTest, BatchesStopWhenRingIsFull) {
+  auto link = ShmLink::makePair(64, 2);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  std::uint8_t data[3]{1, 2, 3};
+  DevBuf bufs[3]{{data, 1}, {data + 1, 1}, {data + 2, 1}};
+  ASSERT_EQ(a.sendBatch(bufs, 3), 2);
+
+  DevBuf reads[3];
+  ASSERT_EQ(b.readBatch(reads, 3), 2);
+  ASSERT_EQ(*reads[0].buf, 1);
+  ASSERT_EQ(*reads[1].buf, 2);
+
+  // Slots are held until the next read so the ring is still full.
+  ASSERT_EQ(a.sendBatch(bufs + 2, 1), 0);
+  ASSERT_EQ(b.readBatch(reads, 3), 0);
+  ASSERT_EQ(a.sendBatch(bufs + 2, 1), 1);
+  ASSERT_EQ(b.readBatch(reads, 3), 1);
+  ASSERT_EQ(*reads[0].buf, 3);
+}
+
+TEST(ShmLinkTest, WaitWakesOnSend) {
+  auto link = ShmLink::makePair(64);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  ASSERT_FALSE(b.wait(0));
+
+  std::thread sender{[&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    std::uint8_t data = 1;
+    a.send(&data, 1);
+  }};
+
+  auto ready = b.wait(-1);
+  sender.join();
+  ASSERT_TRUE(ready);
+
+  std::uint8_t buf;
+  ASSERT_EQ(b.read(&buf, 1), 1);
+  ASSERT_EQ(buf, 1);
+}
+
+TEST(ShmLinkTest, ReadEndsWait) {
+  auto link = ShmLink::makePair(64);
+  auto& a = *link.first;
+  auto& b = *link.second;
+
+  // A wait which timed out w/o a frame leaves nothing for the peer to wake.
+  ASSERT_TRUE(b.prepareWait());
+  DevBuf buf;
+  ASSERT_EQ(b.readBatch(&buf, 1), 0);
+
+  std::uint8_t data = 1;
+  ASSERT_EQ(a.send(&data, 1), 1);
+  std::uint64_t n;
+  ASSERT_EQ(::read(b.fds().rxEvent, &n, sizeof(n)), -1);
+  ASSERT_EQ(b.readBatch(&buf, 1), 1);
+}
+
+TEST(ShmLinkTest, AcrossProcesses) {
+  auto link = ShmLink::makePair(64);
+
+  auto pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    // Echo a single frame back to the parent.
+    link.first.reset();
+    auto& b = *link.second;
+    std::uint8_t buf[64];
+    std::size_t len = 0;
+    while (b.wait(-1) && (len = b.read(buf, sizeof(buf))) == 0) {
+    }
+    _exit(b.send(buf, len) == len ? 0 : 1);
+  }
+
+  link.second.reset();
+  auto& a = *link.first;
+  ASSERT_EQ(a.send(reinterpret_cast<const std::uint8_t*>("ping"), 4), 4);
+
+  std::uint8_t buf[64];
+  ASSERT_TRUE(a.wait(5'000));
+  ASSERT_EQ(a.read(buf, sizeof(buf)), 4);
+  ASSERT_EQ(std::memcmp(buf, "ping", 4), 0);
+
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(ShmLinkTest, FrameTooLarge) {
+  auto link = ShmLink::makePair(4);
+  std::uint8_t data[5]{};
+  ASSERT_THROW(link.first->send(data, sizeof(data)), Exception);
+}
+
+TEST(ShmLinkTest, AttachValidatesRegion) {
+  auto link = ShmLink::makePair(64, 4);
+  auto& fds = link.second->fds();
+  auto mapLen = lseek(fds.mem, 0, SEEK_END);
+  auto map = static_cast<std::uint64_t*>(
+      mmap(nullptr, mapLen, PROT_READ | PROT_WRITE, MAP_SHARED, fds.mem, 0));
+  ASSERT_NE(map, MAP_FAILED);
+
+  auto attach = [&]() {
+    ShmLink::Fds dup = fds;
+    dup.mem = fcntl(fds.mem, F_DUPFD_CLOEXEC, 0);
+    dup.rxEvent = fcntl(fds.rxEvent, F_DUPFD_CLOEXEC, 0);
+    dup.txEvent = fcntl(fds.txEvent, F_DUPFD_CLOEXEC, 0);
+    return ShmLink::attach(dup);
+  };
+  ASSERT_NO_THROW(attach());
+
+  // The slot count of the first ring, which follows the 64 byte header, no
+  // longer matches the region.
+  map[9] = 1'024 * 1'024;
+  ASSERT_THROW(attach(), Exception);
+
+  // Ends already attached keep using the geometry they validated.
+  std::uint8_t data = 1;
+  DevBuf buf;
+  ASSERT_EQ(link.first->send(&data, 1), 1);
+  ASSERT_EQ(link.second->readBatch(&buf, 1), 1);
+  ASSERT_EQ(*buf.buf, 1);
+  munmap(map, mapLen);
+}
+
+TEST(ShmLinkTest, AttachRequiresSealedRegion) {
+  auto link = ShmLink::makePair(64, 4);
+  auto& fds = link.second->fds();
+  auto mapLen = lseek(fds.mem, 0, SEEK_END);
+  ASSERT_EQ(ftruncate(fds.mem, 0), -1);
+  ASSERT_EQ(ftruncate(fds.mem, mapLen * 2), -1);
+
+  // An unsealed copy of a valid region is refused.
+  std::vector<std::uint8_t> region(mapLen);
+  ASSERT_EQ(pread(fds.mem, region.data(), region.size(), 0), mapLen);
+  ShmLink::Fds dup = fds;
+  dup.mem = memfd_create("unet-shm-link-test", MFD_CLOEXEC);
+  ASSERT_NE(dup.mem, -1);
+  ASSERT_EQ(write(dup.mem, region.data(), region.size()), mapLen);
+  dup.rxEvent = fcntl(fds.rxEvent, F_DUPFD_CLOEXEC, 0);
+  dup.txEvent = fcntl(fds.txEvent, F_DUPFD_CLOEXEC, 0);
+  ASSERT_THROW(ShmLink::attach(dup), Exception);
+}
+
+TEST(ShmLinkTest, InvalidGeometry) {
+  ASSERT_THROW(ShmLink::makePair(0), Exception);
+  ASSERT_THROW(ShmLink::makePair(64, 0), Exception);
+}
+
+}  // namespace unet
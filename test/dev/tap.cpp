@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unet/dev/tap.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+TEST(TapTest, MakeQueuesValidatesArgs) {
+  ASSERT_THROW(Tap::makeQueues("unet-mq0", 0), Exception);
+
+  // Names are checked before the interface is opened.
+  ASSERT_THROW(Tap::makeQueues(std::string(64, 'x'), 2), Exception);
+}
+
+TEST(TapTest, MakeQueues) {
+  // TAP interfaces need CAP_NET_ADMIN.
+  std::vector<std::unique_ptr<Tap>> queues;
+  try {
+    queues = Tap::makeQueues("unet-mq0", 2);
+  } catch (const Exception&) {
+    GTEST_SKIP() << "TAP interfaces are not available.";
+  }
+
+  ASSERT_EQ(queues.size(), 2);
+  ASSERT_NE(queues[0]->pollFd(), queues[1]->pollFd());
+  ASSERT_EQ(queues[0]->maxTransmissionUnit(),
+            queues[1]->maxTransmissionUnit());
+
+  // The interface only takes opens which ask for another queue.
+  ASSERT_THROW(Tap{"unet-mq0"}, Exception);
+}
+
+}  // namespace unet
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include <unet/dev/udp_link.hpp>
+#include <unet/exception.hpp>
+
+namespace unet {
+
+const SocketAddr kAddrA{kLoopback, 47'101};
+const SocketAddr kAddrB{kLoopback, 47'102};
+const SocketAddr kAddrC{kLoopback, 47'103};
+
+const EthernetAddr kHwAddrA{{0x02, 0, 0, 0, 0, 0x0a}};
+const EthernetAddr kHwAddrB{{0x02, 0, 0, 0, 0, 0x0b}};
+const EthernetAddr kHwAddrC{{0x02, 0, 0, 0, 0, 0x0c}};
+
+static std::vector<std::uint8_t> makeFrame(EthernetAddr dstAddr,
+                                           EthernetAddr srcAddr) {
+  std::vector<std::uint8_t> frame(64);
+  auto& header = *reinterpret_cast<EthernetHeader*>(frame.data());
+  header.dstAddr = dstAddr;
+  header.srcAddr = srcAddr;
+  header.ethType = eth_type::kIpv4;
+  return frame;
+}
+
+// Reads frames w/the device until there are no more.
+static std::size_t drain(Dev& dev) {
+  std::uint8_t buf[1'500];
+  std::size_t read = 0;
+  while (dev.read(buf, sizeof(buf)) > 0) {
+    read++;
+  }
+  return read;
+}
+
+TEST(UdpLinkTest, SendAndReadBatch) {
+  UdpLink a{kAddrA, {kAddrB}};
+  UdpLink b{kAddrB, {kAddrA}};
+
+  auto frame = makeFrame(kEthernetBcastAddr, kHwAddrA);
+  std::vector<DevBuf> bufs(8, DevBuf{frame.data(), frame.size()});
+  ASSERT_EQ(a.sendBatch(bufs.data(), bufs.size()), bufs.size());
+
+  std::vector<std::uint8_t> readBuf(8 * 1'500);
+  for (std::size_t i = 0; i < bufs.size(); i++) {
+    bufs[i] = DevBuf{readBuf.data() + i * 1'500, 1'500};
+  }
+  ASSERT_EQ(b.readBatch(bufs.data(), bufs.size()), 8);
+  for (auto& buf : bufs) {
+    ASSERT_EQ(buf.bufLen, frame.size());
+    ASSERT_EQ(std::memcmp(buf.buf, frame.data(), frame.size()), 0);
+  }
+  ASSERT_EQ(drain(b), 0);
+}
+
+TEST(UdpLinkTest, LearnsWhereAddressesLive) {
+  UdpLink a{kAddrA, {kAddrB, kAddrC}};
+  UdpLink b{kAddrB, {kAddrA}};
+  UdpLink c{kAddrC, {kAddrA}};
+
+  // Unknown addresses are flooded...
+  auto frame = makeFrame(kHwAddrB, kHwAddrA);
+  ASSERT_EQ(a.send(frame.data(), frame.size()), frame.size());
+  ASSERT_EQ(drain(b), 1);
+  ASSERT_EQ(drain(c), 1);
+
+  // ...until a frame from the address is seen.
+  auto reply = makeFrame(kHwAddrA, kHwAddrB);
+  ASSERT_EQ(b.send(reply.data(), reply.size()), reply.size());
+  ASSERT_EQ(drain(a), 1);
+
+  ASSERT_EQ(a.send(frame.data(), frame.size()), frame.size());
+  ASSERT_EQ(drain(b), 1);
+  ASSERT_EQ(drain(c), 0);
+}
+
+TEST(UdpLinkTest, ForgetsLeastRecentlyUsedAddresses) {
+  UdpLink a{kAddrA, {kAddrB, kAddrC}, 1'500, 1};
+  UdpLink b{kAddrB, {kAddrA}};
+  UdpLink c{kAddrC, {kAddrA}};
+
+  // Learning where C lives makes room by forgetting B...
+  auto fromB = makeFrame(kHwAddrA, kHwAddrB);
+  ASSERT_EQ(b.send(fromB.data(), fromB.size()), fromB.size());
+  ASSERT_EQ(drain(a), 1);
+  auto fromC = makeFrame(kHwAddrA, kHwAddrC);
+  ASSERT_EQ(c.send(fromC.data(), fromC.size()), fromC.size());
+  ASSERT_EQ(drain(a), 1);
+
+  // ...so frames to B are flooded again.
+  auto frame = makeFrame(kHwAddrB, kHwAddrA);
+  ASSERT_EQ(a.send(frame.data(), frame.size()), frame.size());
+  ASSERT_EQ(drain(b), 1);
+  ASSERT_EQ(drain(c), 1);
+}
+
+TEST(UdpLinkTest, DropsDatagramsFromStrangers) {
+  UdpLink a{kAddrA, {kAddrB}};
+  UdpLink b{kAddrB, {kAddrA}};
+  UdpLink c{kAddrC, {kAddrA}};
+
+  auto frame = makeFrame(kEthernetBcastAddr, kHwAddrB);
+  ASSERT_EQ(c.send(frame.data(), frame.size()), frame.size());
+  ASSERT_EQ(drain(a), 0);
+
+  // Frames kept around a dropped one are read into the buffers in place.
+  auto first = makeFrame(kEthernetBcastAddr, kHwAddrB);
+  auto last = makeFrame(kEthernetBcastAddr, kHwAddrB);
+  last.back() = 1;
+  ASSERT_EQ(b.send(first.data(), first.size()), first.size());
+  ASSERT_EQ(c.send(frame.data(), frame.size()), frame.size());
+  ASSERT_EQ(b.send(last.data(), last.size()), last.size());
+
+  std::vector<std::uint8_t> readBuf(3 * 1'500);
+  std::vector<DevBuf> bufs(3);
+  for (std::size_t i = 0; i < bufs.size(); i++) {
+    bufs[i] = DevBuf{readBuf.data() + i * 1'500, 1'500};
+  }
+  ASSERT_EQ(a.readBatch(bufs.data(), bufs.size()), 2);
+  for (std::size_t i = 0; i < bufs.size(); i++) {
+    ASSERT_EQ(bufs[i].buf, readBuf.data() + i * 1'500);
+  }
+  ASSERT_EQ(bufs[0].bufLen, first.size());
+  ASSERT_EQ(std::memcmp(bufs[0].buf, first.data(), first.size()), 0);
+  ASSERT_EQ(bufs[1].bufLen, last.size());
+  ASSERT_EQ(std::memcmp(bufs[1].buf, last.data(), last.size()), 0);
+}
+
+TEST(UdpLinkTest, FrameTooLarge) {
+  UdpLink a{kAddrA, {kAddrB}, 64};
+  std::uint8_t data[65]{};
+  ASSERT_THROW(a.send(data, sizeof(data)), Exception);
+}
+
+TEST(UdpLinkTest, InvalidArguments) {
+  ASSERT_THROW((UdpLink{kAddrA, {kAddrB}, 0}), Exception);
+  ASSERT_THROW((UdpLink{kAddrA, {kAddrB}, 1'500, 0}), Exception);
+  ASSERT_THROW((UdpLink{kAddrA, {}}), Exception);
+}
+
+}  // namespace unet
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include <unet/dev/uring_tap.hpp>
+#include <unet/exception.hpp>
+#include <unet/wire/ethernet.hpp>
+
+namespace unet {
+
+#ifdef __linux__
+
+constexpr char kName[] = "unet-uring0";
+
+// An EtherType reserved for local experiments so the kernel leaves our frames
+// alone and we can tell them apart from other traffic on the link.
+constexpr std::uint16_t kEthType = 0x88b5;
+
+static std::vector<std::uint8_t> makeFrame(std::size_t len,
+                                           std::uint8_t fill) {
+  std::vector<std::uint8_t> frame(len, fill);
+  auto& header = *reinterpret_cast<EthernetHeader*>(frame.data());
+  header.dstAddr = kEthernetBcastAddr;
+  header.srcAddr = EthernetAddr{{0x02, 0, 0, 0, 0, 0x01}};
+  header.ethType = htons(kEthType);
+  return frame;
+}
+
+static bool isOurs(const std::uint8_t* buf, std::size_t bufLen) {
+  return bufLen >= sizeof(EthernetHeader) &&
+         reinterpret_cast<const EthernetHeader*>(buf)->ethType ==
+             htons(kEthType);
+}
+
+// Drives a UringTap against the kernel side of its interface, which we inject
+// frames into w/a packet socket.
+class UringTapTest : public testing::Test {
+ public:
+  void SetUp() override {
+    // TAP interfaces need CAP_NET_ADMIN.
+    try {
+      tap = std::make_unique<UringTap>(kName);
+    } catch (const Exception&) {
+      GTEST_SKIP() << "TAP interfaces are not available.";
+    }
+
+    // Keep IPv6 from chattering on the link once it is up.
+    std::ofstream{std::string{"/proc/sys/net/ipv6/conf/"} + kName +
+                  "/disable_ipv6"}
+        << 1;
+
+    auto fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(fd, -1);
+    ifreq ifr{};
+    std::strncpy(ifr.ifr_name, kName, IFNAMSIZ - 1);
+    ASSERT_EQ(ioctl(fd, SIOCGIFFLAGS, &ifr), 0);
+    ifr.ifr_flags |= IFF_UP;
+    ASSERT_EQ(ioctl(fd, SIOCSIFFLAGS, &ifr), 0);
+    close(fd);
+
+    sock = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    ASSERT_NE(sock, -1);
+    sockaddr_ll addr{};
+    addr.sll_family = AF_PACKET;
+    addr.sll_protocol = htons(ETH_P_ALL);
+    addr.sll_ifindex = if_nametoindex(kName);
+    ASSERT_EQ(bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)),
+              0);
+  }
+
+  void TearDown() override {
+    if (sock != -1) {
+      close(sock);
+    }
+  }
+
+  // Hands a frame to the TAP from the kernel side.
+  void inject(const std::vector<std::uint8_t>& frame) {
+    ASSERT_EQ(send(sock, frame.data(), frame.size(), 0),
+              static_cast<ssize_t>(frame.size()));
+  }
+
+  // Return the next frame of ours read w/the TAP into a buffer of bufLen bytes
+  // or an empty frame if none arrives within a second.
+  std::vector<std::uint8_t> readFrame(std::size_t bufLen) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+    std::vector<std::uint8_t> frame(bufLen);
+    while (std::chrono::steady_clock::now() < deadline) {
+      auto r = tap->read(frame.data(), frame.size());
+      if (isOurs(frame.data(), r)) {
+        frame.resize(r);
+        return frame;
+      }
+    }
+    return {};
+  }
+
+  // Return the next frame of ours the kernel got from the TAP or an empty
+  // frame if none arrives within a second.
+  std::vector<std::uint8_t> capture() {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{1};
+    std::vector<std::uint8_t> frame(2'048);
+    while (std::chrono::steady_clock::now() < deadline) {
+      pollfd pfd{sock, POLLIN, 0};
+      if (poll(&pfd, 1, 10) <= 0) {
+        continue;
+      }
+
+      sockaddr_ll addr{};
+      socklen_t addrLen = sizeof(addr);
+      auto r = recvfrom(sock, frame.data(), frame.size(), 0,
+                        reinterpret_cast<sockaddr*>(&addr), &addrLen);
+      if (r > 0 && addr.sll_pkttype != PACKET_OUTGOING &&
+          isOurs(frame.data(), r)) {
+        frame.resize(r);
+        return frame;
+      }
+    }
+    return {};
+  }
+
+
+  std::unique_ptr<UringTap> tap;
+  int sock = -1;
+};
+
+TEST_F(UringTapTest, DropOversizedReads) {
+  auto large = makeFrame(200, 1);
+  auto small = makeFrame(64, 2);
+  ASSERT_NO_FATAL_FAILURE(inject(large));
+  ASSERT_NO_FATAL_FAILURE(inject(small));
+
+  // The large frame does not fit and is dropped instead of truncated.
+  ASSERT_EQ(readFrame(100), small);
+}
+
+TEST_F(UringTapTest, GatherChainedFrames) {
+  auto frame = makeFrame(300, 3);
+  for (std::size_t i = sizeof(EthernetHeader); i < frame.size(); i++) {
+    frame[i] = static_cast<std::uint8_t>(i);
+  }
+
+  DevSeg segs[2]{{frame.data() + 100, 50}, {frame.data() + 150, 150}};
+  DevBuf b{frame.data(), 100};
+  b.segs = segs;
+  b.segsLen = 2;
+  ASSERT_EQ(tap->sendBatch(&b, 1), 1);
+  ASSERT_EQ(capture(), frame);
+
+  // The whole chain must fit a registered buffer.
+  std::vector<std::uint8_t> payload(tap->maxTransmissionUnit());
+  DevSeg large{payload.data(), payload.size()};
+  b.segs = &large;
+  b.segsLen = 1;
+  ASSERT_THROW(tap->sendBatch(&b, 1), Exception);
+}
+
+#endif
+
+}  // namespace unet
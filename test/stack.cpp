@@ -1,14 +1,31 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unet/detail/check.hpp>
+#include <unet/dev/netem.hpp>
+#include <unet/dev/shm_link.hpp>
 #include <unet/exception.hpp>
+#include <unet/raw_socket.hpp>
 #include <unet/stack.hpp>
+#include <unet/wire/arp.hpp>
+#include <unet/wire/icmpv4.hpp>
 
 namespace unet {
 
+using testing::_;
+using testing::InSequence;
 using testing::Invoke;
 using testing::MockFunction;
 using testing::NiceMock;
+using testing::Return;
+using testing::ReturnArg;
 using testing::Test;
 
 class MockDev : public Dev {
@@ -18,6 +35,22 @@ class MockDev : public Dev {
   MOCK_CONST_METHOD0(maxTransmissionUnit, std::size_t());
 };
 
+class MockPollDev : public MockDev {
+ public:
+  MOCK_CONST_METHOD0(pollFd, int());
+};
+
+class MockOffloadDev : public Dev {
+ public:
+  MOCK_METHOD2(send, std::size_t(const std::uint8_t*, std::size_t));
+  MOCK_METHOD2(read, std::size_t(std::uint8_t*, std::size_t));
+  MOCK_METHOD2(sendBatch, std::size_t(const DevBuf*, std::size_t));
+  MOCK_METHOD2(readBatch, std::size_t(DevBuf*, std::size_t));
+  MOCK_CONST_METHOD0(maxTransmissionUnit, std::size_t());
+  MOCK_CONST_METHOD0(maxFrameLen, std::size_t());
+  MOCK_CONST_METHOD0(offloads, std::uint32_t());
+};
+
 class StackTest : public Test {
  public:
   StackTest()
@@ -62,4 +95,690 @@ TEST_F(StackTest, LoopRunStopThrowAndRunAgain) {
   stack.runLoop();
 }
 
+TEST(StackSendTest, RetryFramesAfterDevExhausted) {
+  auto dev = std::make_unique<NiceMock<MockDev>>();
+  auto devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::uint8_t buf[64]{};
+  buf[0] = 1;
+  for (auto len = 20; len <= 22; len++) {
+    ASSERT_EQ(socket.send(buf, len), len);
+  }
+
+  {
+    InSequence seq;
+    EXPECT_CALL(*devPtr, send(_, 20)).WillOnce(Return(20));
+    EXPECT_CALL(*devPtr, send(_, 21)).WillOnce(Return(0));
+    EXPECT_CALL(*devPtr, send(_, 21)).WillOnce(Return(21));
+    EXPECT_CALL(*devPtr, send(_, 22)).WillOnce(Return(22));
+  }
+
+  // Stop on the second loop once the staged frames had a chance to be retried.
+  auto loops = 0;
+  std::unique_ptr<Timer> timer;
+  timer = stack.createTimer([&]() {
+    if (++loops == 2) {
+      stack.stopLoop();
+    } else {
+      timer->runAfter(std::chrono::seconds{0});
+    }
+  });
+  timer->runAfter(std::chrono::seconds{0});
+
+  stack.runLoop();
+}
+
+TEST(StackSendTest, WithholdSendWhileMemLow) {
+  auto dev = std::make_unique<NiceMock<MockDev>>();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, send(_, _)).WillByDefault(ReturnArg<1>());
+
+  // Any frame queued runs the budget low.
+  Options opts;
+  opts.memBudgetLen = 100'000;
+  opts.memBudgetLowLen = 100'000;
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+
+  auto sendEvents = 0;
+  RawSocket socket{stack, RawSocket::kEthernet,
+                   [&](auto&, auto) { sendEvents++; }};
+  socket.subscribe(Event::Send);
+
+  std::uint8_t buf[64]{};
+  buf[0] = 1;
+  ASSERT_EQ(socket.send(buf, sizeof(buf)), sizeof(buf));
+  ASSERT_GT(stack.memUsed(), 0);
+  ASSERT_EQ(socket.memUsed(), stack.memUsed());
+
+  // Send comes back once the frame is gone.
+  stack.runLoopOnce();
+  ASSERT_EQ(stack.memUsed(), 0);
+  ASSERT_EQ(sendEvents, 0);
+  stack.runLoopOnce();
+  ASSERT_EQ(sendEvents, 1);
+}
+
+TEST(StackSendTest, MemBudgetLowLen) {
+  // The low mark defaults to a share of any budget...
+  Options opts;
+  opts.memBudgetLen = 64 * 1'024;
+  Stack stack{std::make_unique<NiceMock<MockDev>>(), EthernetAddr{},
+              Ipv4AddrCidr{Ipv4Addr{}, 32}, Ipv4Addr{}, opts};
+
+  // ...but one set explicitly must fit in the budget.
+  opts.memBudgetLowLen = opts.memBudgetLen + 1;
+  ASSERT_THROW((Stack{std::make_unique<NiceMock<MockDev>>(), EthernetAddr{},
+                      Ipv4AddrCidr{Ipv4Addr{}, 32}, Ipv4Addr{}, opts}),
+               Exception);
+}
+
+TEST(StackWaitTest, BlockUntilTimerWhileIdle) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  auto dev = std::make_unique<NiceMock<MockPollDev>>();
+  auto reads = 0;
+  ON_CALL(*dev, pollFd()).WillByDefault(Return(fds[0]));
+  ON_CALL(*dev, read(_, _)).WillByDefault(Invoke([&](auto, auto) {
+    reads++;
+    return 0;
+  }));
+
+  Options opts;
+  opts.loopBusyPollTime = std::chrono::microseconds{0};
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+  auto timer = stack.createTimer([&]() { stack.stopLoop(); });
+  timer->runAfter(std::chrono::milliseconds{50});
+
+  // Each poll of the device which comes up empty is followed by a sleep
+  // except for the last one which ran the timer.
+  stack.runLoop();
+  ASSERT_GE(stack.loopStats().sleeps, 1);
+  ASSERT_EQ(reads, stack.loopStats().sleeps + 1);
+  ASSERT_EQ(stack.loopStats().spinTime.count(), 0);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(StackWaitTest, BusyPollBeforeBlocking) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  auto dev = std::make_unique<NiceMock<MockPollDev>>();
+  ON_CALL(*dev, pollFd()).WillByDefault(Return(fds[0]));
+
+  // The timer is far enough out for the loop to block even on a loaded host.
+  Options opts;
+  opts.loopBusyPollTime = std::chrono::milliseconds{10};
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+  auto timer = stack.createTimer([&]() { stack.stopLoop(); });
+  timer->runAfter(std::chrono::milliseconds{200});
+
+  // Spin time is measured w/the same clock the loop decides to block by.
+  stack.runLoop();
+  auto& stats = stack.loopStats();
+  ASSERT_GE(stats.sleeps, 1);
+  ASSERT_GE(stats.spinTime, std::chrono::milliseconds{10});
+  ASSERT_GT(stats.sleepTime.count(), 0);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(StackWaitTest, NeverBlock) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  auto dev = std::make_unique<NiceMock<MockPollDev>>();
+  ON_CALL(*dev, pollFd()).WillByDefault(Return(fds[0]));
+
+  Options opts;
+  opts.loopBusyPollTime = std::chrono::microseconds::max();
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+  auto timer = stack.createTimer([&]() { stack.stopLoop(); });
+  timer->runAfter(std::chrono::milliseconds{10});
+
+  stack.runLoop();
+  ASSERT_EQ(stack.loopStats().sleeps, 0);
+  ASSERT_GT(stack.loopStats().spinTime.count(), 0);
+  ASSERT_EQ(stack.loopStats().sleepTime.count(), 0);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(StackWaitTest, WakeForDelayedFrames) {
+  NetemParams rx;
+  rx.delay = std::chrono::milliseconds{20};
+  auto link = ShmLink::makePair(1'500);
+  auto peer = std::move(link.second);
+
+  Options opts;
+  opts.loopBusyPollTime = std::chrono::microseconds{0};
+  Stack stack{std::make_unique<Netem>(std::move(link.first), NetemParams{}, rx),
+              EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32}, Ipv4Addr{}, opts};
+  auto reads = 0;
+  RawSocket socket{stack, RawSocket::kEthernet, [&](auto&, auto) {
+                     reads++;
+                     stack.stopLoop();
+                   }};
+  socket.subscribe(Event::Read);
+
+  // The loop must not block w/the frame due once the RX timer has fired.
+  auto timedOut = false;
+  auto timer = stack.createTimer([&]() {
+    timedOut = true;
+    stack.stopLoop();
+  });
+  timer->runAfter(std::chrono::seconds{1});
+
+  std::uint8_t frame[64]{};
+  reinterpret_cast<EthernetHeader*>(frame)->dstAddr = kEthernetBcastAddr;
+  ASSERT_EQ(peer->send(frame, sizeof(frame)), sizeof(frame));
+  stack.runLoop();
+  ASSERT_FALSE(timedOut);
+  ASSERT_EQ(reads, 1);
+}
+
+constexpr EthernetAddr kHwAddr{{0x02, 0, 0, 0, 0, 0x01}};
+constexpr EthernetAddr kPeerHwAddr{{0x02, 0, 0, 0, 0, 0x02}};
+constexpr Ipv4Addr kIpv4Addr{{10, 0, 0, 1}};
+constexpr Ipv4Addr kPeerIpv4Addr{{10, 0, 0, 2}};
+
+class StackOffloadTest : public Test {
+ public:
+  StackOffloadTest() {
+    auto dev = std::make_unique<NiceMock<MockOffloadDev>>();
+    devPtr = dev.get();
+    ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+    ON_CALL(*dev, maxFrameLen()).WillByDefault(Return(65'549));
+    ON_CALL(*dev, offloads()).WillByDefault(Return(dev_offload::kTxTso4));
+
+    stack = std::make_unique<Stack>(std::move(dev), kHwAddr,
+                                    Ipv4AddrCidr{kIpv4Addr, 24}, kPeerIpv4Addr);
+  }
+
+  // Makes the stack read the provided frames on the next loop and stop.
+  void readOnce(std::vector<std::string> frames, DevOffload offload) {
+    EXPECT_CALL(*devPtr, readBatch(_, _))
+        .WillOnce(Invoke([frames, offload](DevBuf* bufs, std::size_t) {
+          for (std::size_t i = 0; i < frames.size(); i++) {
+            std::copy(frames[i].begin(), frames[i].end(), bufs[i].buf);
+            bufs[i].bufLen = frames[i].size();
+            bufs[i].offload = offload;
+          }
+          return frames.size();
+        }))
+        .WillRepeatedly(Return(0));
+
+    auto timer = stack->createTimer([this]() { stack->stopLoop(); });
+    timer->runAfter(std::chrono::seconds{0});
+    stack->runLoop();
+  }
+
+  // Return an ARP reply from the peer so the stack can send to it.
+  std::string makeArpReply() {
+    std::string frame(sizeof(EthernetHeader) + sizeof(ArpHeader), 0);
+    auto eth = reinterpret_cast<EthernetHeader*>(&frame[0]);
+    eth->dstAddr = kHwAddr;
+    eth->srcAddr = kPeerHwAddr;
+    eth->ethType = eth_type::kArp;
+
+    auto arp = reinterpret_cast<ArpHeader*>(&frame[sizeof(EthernetHeader)]);
+    arp->hwType = arp_hw_addr::kEth;
+    arp->protoType = arp_proto_addr::kIpv4;
+    arp->hwLen = 6;
+    arp->protoLen = 4;
+    arp->op = arp_op::kReply;
+    arp->srcHwAddr = kPeerHwAddr;
+    arp->srcProtoAddr = kPeerIpv4Addr;
+    arp->dstHwAddr = kHwAddr;
+    arp->dstProtoAddr = kIpv4Addr;
+    return frame;
+  }
+
+  MockOffloadDev* devPtr;
+  std::unique_ptr<Stack> stack;
+};
+
+TEST_F(StackOffloadTest, SkipValidatedChecksums) {
+  // An ICMPv4 echo request w/bogus checksums the device has vouched for.
+  std::string echo(sizeof(EthernetHeader) + sizeof(Ipv4Header) +
+                       sizeof(Icmpv4Header),
+                   0);
+  auto eth = reinterpret_cast<EthernetHeader*>(&echo[0]);
+  eth->dstAddr = kHwAddr;
+  eth->srcAddr = kPeerHwAddr;
+  eth->ethType = eth_type::kIpv4;
+
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(&echo[sizeof(EthernetHeader)]);
+  ipv4->version = 4;
+  ipv4->ihl = 5;
+  ipv4->len = hostToNet<std::uint16_t>(echo.size() - sizeof(EthernetHeader));
+  ipv4->ttl = 64;
+  ipv4->proto = ipv4_proto::kIcmp;
+  ipv4->srcAddr = kPeerIpv4Addr;
+  ipv4->dstAddr = kIpv4Addr;
+
+  auto icmp = reinterpret_cast<Icmpv4Header*>(
+      &echo[sizeof(EthernetHeader) + sizeof(Ipv4Header)]);
+  icmp->type = 8;
+
+  EXPECT_CALL(*devPtr, sendBatch(_, 1))
+      .WillOnce(Invoke([](const DevBuf* bufs, std::size_t) {
+        auto icmp = reinterpret_cast<const Icmpv4Header*>(
+            bufs[0].buf + sizeof(EthernetHeader) + sizeof(Ipv4Header));
+        EXPECT_EQ(icmp->type, 0);
+        return 1;
+      }));
+
+  DevOffload offload;
+  offload.csumValid = true;
+  readOnce({makeArpReply(), echo}, offload);
+}
+
+TEST_F(StackOffloadTest, CompletePartialChecksums) {
+  RawSocket socket{*stack, RawSocket::kIpv4, [](auto&, auto) {}};
+  socket.subscribe(Event::Read);
+
+  // A TCP/IPv4 frame whose checksum only covers the pseudo header.
+  std::string tcp(sizeof(EthernetHeader) + sizeof(Ipv4Header) + 24, 0);
+  auto eth = reinterpret_cast<EthernetHeader*>(&tcp[0]);
+  eth->dstAddr = kHwAddr;
+  eth->ethType = eth_type::kIpv4;
+
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(&tcp[sizeof(EthernetHeader)]);
+  ipv4->version = 4;
+  ipv4->ihl = 5;
+  ipv4->len = hostToNet<std::uint16_t>(tcp.size() - sizeof(EthernetHeader));
+  ipv4->ttl = 64;
+  ipv4->proto = ipv4_proto::kTcp;
+  ipv4->srcAddr = kPeerIpv4Addr;
+  ipv4->dstAddr = kIpv4Addr;
+  ipv4->checksum = checksumIpv4(ipv4);
+
+  std::size_t csumStart = sizeof(EthernetHeader) + sizeof(Ipv4Header);
+  tcp[csumStart + 12] = 5 << 4;
+  tcp[csumStart + 20] = 0x42;
+  auto pseudo = pseudoChecksumIpv4(ipv4, 24);
+  std::memcpy(&tcp[csumStart + 16], &pseudo, sizeof(pseudo));
+
+  DevOffload offload;
+  offload.csumPartial = true;
+  offload.csumStart = csumStart;
+  offload.csumOffset = 16;
+  readOnce({tcp}, offload);
+
+  std::uint8_t buf[64];
+  ASSERT_EQ(socket.read(buf, sizeof(buf)), sizeof(Ipv4Header) + 24);
+
+  // Sum the pseudo header back in to validate.
+  std::uint8_t check[sizeof(pseudo) + 24];
+  std::memcpy(check, &pseudo, sizeof(pseudo));
+  std::memcpy(check + sizeof(pseudo), buf + sizeof(Ipv4Header), 24);
+  ASSERT_EQ(detail::checksum(check, sizeof(check)), 0);
+}
+
+TEST_F(StackOffloadTest, EchoPayloadWoCopies) {
+  // A device which gathers payload segments and reads frames in place.
+  auto dev = std::make_unique<NiceMock<MockOffloadDev>>();
+  devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, maxFrameLen()).WillByDefault(Return(1500));
+  ON_CALL(*dev, offloads()).WillByDefault(Return(dev_offload::kTxSg));
+  stack = std::make_unique<Stack>(std::move(dev), kHwAddr,
+                                  Ipv4AddrCidr{kIpv4Addr, 24}, kPeerIpv4Addr);
+
+  std::size_t payloadLen = 100;
+  std::string echo(sizeof(EthernetHeader) + sizeof(Ipv4Header) +
+                       sizeof(Icmpv4Header) + payloadLen,
+                   'p');
+  auto eth = reinterpret_cast<EthernetHeader*>(&echo[0]);
+  eth->dstAddr = kHwAddr;
+  eth->srcAddr = kPeerHwAddr;
+  eth->ethType = eth_type::kIpv4;
+
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(&echo[sizeof(EthernetHeader)]);
+  ipv4->version = 4;
+  ipv4->ihl = 5;
+  ipv4->len = hostToNet<std::uint16_t>(echo.size() - sizeof(EthernetHeader));
+  ipv4->ttl = 64;
+  ipv4->proto = ipv4_proto::kIcmp;
+  ipv4->srcAddr = kPeerIpv4Addr;
+  ipv4->dstAddr = kIpv4Addr;
+  ipv4->checksum = 0;
+  ipv4->checksum = checksumIpv4(ipv4);
+
+  auto icmp = reinterpret_cast<Icmpv4Header*>(&echo[sizeof(EthernetHeader) +
+                                                    sizeof(Ipv4Header)]);
+  icmp->type = 8;
+  icmp->code = 0;
+  icmp->checksum = 0;
+  icmp->checksum = checksumIcmpv4(icmp, payloadLen);
+
+  auto arp = makeArpReply();
+  const std::uint8_t* readBuf = nullptr;
+  EXPECT_CALL(*devPtr, readBatch(_, _))
+      .WillOnce(Invoke([&](DevBuf* bufs, std::size_t) {
+        std::copy(arp.begin(), arp.end(), bufs[0].buf);
+        bufs[0].bufLen = arp.size();
+        std::copy(echo.begin(), echo.end(), bufs[1].buf);
+        bufs[1].bufLen = echo.size();
+        readBuf = bufs[1].buf;
+        return 2;
+      }))
+      .WillRepeatedly(Return(0));
+
+  std::vector<std::uint8_t> reply;
+  EXPECT_CALL(*devPtr, sendBatch(_, 1))
+      .WillOnce(Invoke([&](const DevBuf* bufs, std::size_t) {
+        // The payload is sent straight from the bytes the device read.
+        EXPECT_EQ(bufs[0].segsLen, 1);
+        EXPECT_EQ(bufs[0].segs[0].buf, readBuf + echo.size() - payloadLen);
+        reply.resize(frameLen(bufs[0]));
+        gatherFrame(bufs[0], reply.data());
+        return 1;
+      }));
+  stack->runLoopOnce();
+
+  ASSERT_EQ(reply.size(), echo.size());
+  auto icmp_ = reinterpret_cast<Icmpv4Header*>(
+      &reply[sizeof(EthernetHeader) + sizeof(Ipv4Header)]);
+  ASSERT_EQ(icmp_->type, 0);
+  ASSERT_EQ(checksumIcmpv4(icmp_, payloadLen), 0);
+  ASSERT_TRUE(std::equal(reply.end() - payloadLen, reply.end(),
+                         echo.end() - payloadLen));
+}
+
+TEST_F(StackOffloadTest, SegmentLargeTcpFrames) {
+  RawSocket socket{*stack, RawSocket::kIpv4, [](auto&, auto) {}};
+
+  std::vector<std::uint8_t> tcp(sizeof(Ipv4Header) + 20 + 4'000, 0);
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(tcp.data());
+  ipv4->version = 4;
+  ipv4->ihl = 5;
+  ipv4->len = hostToNet<std::uint16_t>(tcp.size());
+  ipv4->ttl = 64;
+  ipv4->proto = ipv4_proto::kTcp;
+  ipv4->srcAddr = kIpv4Addr;
+  ipv4->dstAddr = kPeerIpv4Addr;
+  tcp[sizeof(Ipv4Header) + 12] = 5 << 4;
+  ASSERT_EQ(socket.send(tcp.data(), tcp.size()), tcp.size());
+
+  std::size_t hdrLen = sizeof(EthernetHeader) + sizeof(Ipv4Header) + 20;
+  EXPECT_CALL(*devPtr, sendBatch(_, 1))
+      .WillOnce(Invoke([hdrLen](const DevBuf* bufs, std::size_t) {
+        auto& offload = bufs[0].offload;
+        EXPECT_EQ(bufs[0].bufLen, sizeof(EthernetHeader) + 4'040);
+        EXPECT_EQ(offload.gsoType, gso_type::kTcpv4);
+        EXPECT_EQ(offload.hdrLen, hdrLen);
+        EXPECT_EQ(offload.gsoSize, 1'500 - hdrLen);
+        EXPECT_TRUE(offload.csumPartial);
+        EXPECT_EQ(offload.csumStart,
+                  sizeof(EthernetHeader) + sizeof(Ipv4Header));
+        EXPECT_EQ(offload.csumOffset, 16);
+        return 1;
+      }));
+
+  readOnce({makeArpReply()}, DevOffload{});
+}
+
+TEST_F(StackOffloadTest, TruncateLargeNonTcpFrames) {
+  RawSocket socket{*stack, RawSocket::kIpv4, [](auto&, auto) {}};
+
+  std::vector<std::uint8_t> udp(sizeof(Ipv4Header) + 4'000, 0);
+  auto ipv4 = reinterpret_cast<Ipv4Header*>(udp.data());
+  ipv4->version = 4;
+  ipv4->ihl = 5;
+  ipv4->len = hostToNet<std::uint16_t>(udp.size());
+  ipv4->proto = 17;
+  ipv4->dstAddr = kPeerIpv4Addr;
+
+  // The device can not segment UDP so the frame is capped at the MTU.
+  ASSERT_EQ(socket.send(udp.data(), udp.size()),
+            1'500 - sizeof(EthernetHeader));
+
+  // Frames reserved in place can not be committed past the MTU either.
+  auto view = socket.reserve(udp.size());
+  ASSERT_EQ(view.bufLen, udp.size());
+  std::copy(udp.begin(), udp.end(), view.buf);
+  ASSERT_EQ(socket.commit(udp.size()), 0);
+
+  EXPECT_CALL(*devPtr, sendBatch(_, 1))
+      .WillOnce(Invoke([](const DevBuf* bufs, std::size_t) {
+        EXPECT_EQ(bufs[0].bufLen, 1'500);
+        EXPECT_EQ(bufs[0].offload.gsoType, gso_type::kNone);
+        return 1;
+      }));
+
+  readOnce({makeArpReply()}, DevOffload{});
+}
+
+TEST(StackReadTest, BorrowWithoutCopies) {
+  auto dev = std::make_unique<NiceMock<MockOffloadDev>>();
+  auto devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, maxFrameLen()).WillByDefault(Return(1514));
+
+  Stack stack{std::move(dev), kHwAddr, Ipv4AddrCidr{kIpv4Addr, 24},
+              kPeerIpv4Addr};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::string frame(64, 'x');
+  const std::uint8_t* readBuf = nullptr;
+  EXPECT_CALL(*devPtr, readBatch(_, _))
+      .WillOnce(Invoke([&](DevBuf* bufs, std::size_t) {
+        std::copy(frame.begin(), frame.end(), bufs[0].buf);
+        bufs[0].bufLen = frame.size();
+        readBuf = bufs[0].buf;
+        return 1;
+      }))
+      .WillRepeatedly(Return(0));
+  stack.runLoopOnce();
+
+  // The socket sees the very bytes the device read.
+  auto view = socket.borrow();
+  ASSERT_EQ(view.buf, readBuf);
+  ASSERT_EQ(view.bufLen, frame.size());
+  socket.release();
+  ASSERT_FALSE(socket.borrow());
+}
+
+TEST(StackReadTest, CopyShortFramesReadForSegmentation) {
+  auto dev = std::make_unique<NiceMock<MockOffloadDev>>();
+  auto devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, maxFrameLen()).WillByDefault(Return(65'549));
+
+  Stack stack{std::move(dev), kHwAddr, Ipv4AddrCidr{kIpv4Addr, 24},
+              kPeerIpv4Addr};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::string small(64, 'x');
+  std::string large(4'000, 'y');
+  std::vector<const std::uint8_t*> readBufs;
+  EXPECT_CALL(*devPtr, readBatch(_, _))
+      .WillOnce(Invoke([&](DevBuf* bufs, std::size_t) {
+        std::copy(small.begin(), small.end(), bufs[0].buf);
+        bufs[0].bufLen = small.size();
+        std::copy(large.begin(), large.end(), bufs[1].buf);
+        bufs[1].bufLen = large.size();
+        readBufs = {bufs[0].buf, bufs[1].buf};
+        return 2;
+      }))
+      .WillRepeatedly(Return(0));
+  stack.runLoopOnce();
+
+  // The short frame is copied instead of pinning a buffer sized for segmented
+  // frames while the large one is held in place.
+  auto view = socket.borrow();
+  ASSERT_NE(view.buf, readBufs[0]);
+  ASSERT_EQ(view.bufLen, small.size());
+  auto memUsed = socket.memUsed();
+  socket.release();
+  ASSERT_LT(memUsed - socket.memUsed(), 1'024);
+
+  view = socket.borrow();
+  ASSERT_EQ(view.buf, readBufs[1]);
+  ASSERT_EQ(view.bufLen, large.size());
+}
+
+TEST(StackSendTest, ReserveWithoutCopies) {
+  auto dev = std::make_unique<NiceMock<MockDev>>();
+  auto devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  auto view = socket.reserve(64);
+  ASSERT_TRUE(view);
+  ASSERT_EQ(view.bufLen, 64);
+  std::fill(view.buf, view.buf + view.bufLen, 1);
+  ASSERT_EQ(socket.commit(view.bufLen), view.bufLen);
+
+  // The device sees the very bytes written by the user.
+  EXPECT_CALL(*devPtr, send(view.buf, view.bufLen)).WillOnce(ReturnArg<1>());
+  stack.runLoopOnce();
+}
+
+TEST(StackSendTest, Codel) {
+  auto dev = std::make_unique<NiceMock<MockDev>>();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, send(_, _)).WillByDefault(ReturnArg<1>());
+
+  Options opts;
+  opts.sendQueueAqm = SendQueueAqm::Codel;
+  opts.codelTarget = std::chrono::microseconds{0};
+  ASSERT_THROW((Stack{std::make_unique<NiceMock<MockDev>>(), EthernetAddr{},
+                      Ipv4AddrCidr{Ipv4Addr{}, 32}, Ipv4Addr{}, opts}),
+               Exception);
+
+  opts.codelTarget = std::chrono::microseconds{5'000};
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  // Frames sent right away never stand in the queue.
+  std::uint8_t buf[64]{};
+  buf[0] = 1;
+  for (auto i = 0; i < 3; i++) {
+    ASSERT_EQ(socket.send(buf, sizeof(buf)), sizeof(buf));
+  }
+  stack.runLoopOnce();
+  ASSERT_EQ(stack.memUsed(), 0);
+  ASSERT_EQ(stack.sendQueueStats().codelDrops, 0);
+}
+
+TEST(StackSendTest, CodelDropsStandingQueue) {
+  // The link takes frames only when the test lets it.
+  auto dev = std::make_unique<NiceMock<MockDev>>();
+  std::size_t sendable = 0;
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, send(_, _))
+      .WillByDefault(Invoke([&](auto, std::size_t len) -> std::size_t {
+        if (sendable == 0) {
+          return 0;
+        }
+        sendable--;
+        return len;
+      }));
+
+  // Time only moves when the test moves it.
+  auto now = std::chrono::steady_clock::now();
+  Options opts;
+  opts.devBatchLen = 1;
+  opts.sendQueueAqm = SendQueueAqm::Codel;
+  opts.codelTarget = std::chrono::microseconds{1'000};
+  opts.codelInterval = std::chrono::microseconds{2'000};
+  opts.codelClock = [&now]() { return now; };
+  Stack stack{std::move(dev), EthernetAddr{}, Ipv4AddrCidr{Ipv4Addr{}, 32},
+              Ipv4Addr{}, opts};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::uint8_t buf[64]{};
+  buf[0] = 1;
+  for (auto i = 0; i < 8; i++) {
+    ASSERT_EQ(socket.send(buf, sizeof(buf)), sizeof(buf));
+  }
+  stack.runLoopOnce();
+
+  // The queue first stands above target w/o drops...
+  now += std::chrono::milliseconds{2};
+  sendable = 1;
+  stack.runLoopOnce();
+  ASSERT_EQ(stack.sendQueueStats().codelDrops, 0);
+  ASSERT_EQ(stack.sendQueueStats().sojournTime, std::chrono::milliseconds{2});
+
+  // ...and once it stood for an interval CoDel drops from its head.
+  now += std::chrono::milliseconds{3};
+  sendable = 1;
+  stack.runLoopOnce();
+  ASSERT_GE(stack.sendQueueStats().codelDrops, 1);
+  ASSERT_EQ(stack.sendQueueStats().codelDropStarts, 1);
+  ASSERT_EQ(stack.sendQueueStats().tailDrops, 0);
+}
+
+TEST(StackSendTest, CountTailDrops) {
+  // The link takes no frames so one frame stays staged and another fills the
+  // send queue.
+  auto dev = std::make_unique<NiceMock<MockOffloadDev>>();
+  auto devPtr = dev.get();
+  ON_CALL(*dev, maxTransmissionUnit()).WillByDefault(Return(1500));
+  ON_CALL(*dev, maxFrameLen()).WillByDefault(Return(1514));
+
+  Options opts;
+  opts.stackSendQueueLen = 1;
+  opts.devBatchLen = 1;
+  Stack stack{std::move(dev), kHwAddr, Ipv4AddrCidr{kIpv4Addr, 24},
+              kPeerIpv4Addr, opts};
+  RawSocket socket{stack, RawSocket::kEthernet, [](auto&, auto) {}};
+
+  std::uint8_t buf[64]{};
+  buf[0] = 1;
+  for (auto i = 0; i < 2; i++) {
+    ASSERT_EQ(socket.send(buf, sizeof(buf)), sizeof(buf));
+    stack.runLoopOnce();
+  }
+  ASSERT_EQ(stack.sendQueueStats().tailDrops, 0);
+
+  // An ARP request from the peer has no room for its reply.
+  std::string frame(sizeof(EthernetHeader) + sizeof(ArpHeader), 0);
+  auto eth = reinterpret_cast<EthernetHeader*>(&frame[0]);
+  eth->dstAddr = kEthernetBcastAddr;
+  eth->srcAddr = kPeerHwAddr;
+  eth->ethType = eth_type::kArp;
+
+  auto arp = reinterpret_cast<ArpHeader*>(&frame[sizeof(EthernetHeader)]);
+  arp->hwType = arp_hw_addr::kEth;
+  arp->protoType = arp_proto_addr::kIpv4;
+  arp->hwLen = 6;
+  arp->protoLen = 4;
+  arp->op = arp_op::kRequest;
+  arp->srcHwAddr = kPeerHwAddr;
+  arp->srcProtoAddr = kPeerIpv4Addr;
+  arp->dstProtoAddr = kIpv4Addr;
+
+  EXPECT_CALL(*devPtr, readBatch(_, _))
+      .WillOnce(Invoke([&](DevBuf* bufs, std::size_t) {
+        std::copy(frame.begin(), frame.end(), bufs[0].buf);
+        bufs[0].bufLen = frame.size();
+        return 1;
+      }))
+      .WillRepeatedly(Return(0));
+  stack.runLoopOnce();
+  ASSERT_EQ(stack.sendQueueStats().tailDrops, 1);
+}
+
 }  // namespace unet
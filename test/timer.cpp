@@ -77,6 +77,30 @@ TEST(TimerTest, RunAfterMultipleWithSameDelay) {
   manager.run(kTpNowBase + std::chrono::seconds{1});
 }
 
+TEST(TimerTest, RunAfterMultipleOutOfOrder) {
+  TimerManager manager{kTpNowBase};
+
+  MockFunction<void()> f;
+  MockFunction<void()> g;
+  MockFunction<void()> h;
+
+  {
+    InSequence s;
+    EXPECT_CALL(g, Call());
+    EXPECT_CALL(h, Call());
+    EXPECT_CALL(f, Call());
+  }
+
+  Timer timerf{manager, f.AsStdFunction()};
+  Timer timerg{manager, g.AsStdFunction()};
+  Timer timerh{manager, h.AsStdFunction()};
+  timerf.runAfter(std::chrono::seconds{3});
+  timerg.runAfter(std::chrono::seconds{1});
+  timerh.runAfter(std::chrono::seconds{2});
+
+  manager.run(kTpNowBase + std::chrono::seconds{4});
+}
+
 TEST(TimerTest, DropTimer) {
   TimerManager manager{kTpNowBase};
 
@@ -109,4 +133,21 @@ TEST(TimerTest, Now) {
   ASSERT_EQ(manager.now(), kTpNowBase + std::chrono::seconds{1});
 }
 
+TEST(TimerTest, NextExpiry) {
+  TimerManager manager{kTpNowBase};
+  ASSERT_FALSE(manager.nextExpiry());
+
+  Timer a{manager, []() {}};
+  Timer b{manager, []() {}};
+  a.runAfter(std::chrono::seconds{2});
+  b.runAfter(std::chrono::seconds{1});
+  ASSERT_EQ(*manager.nextExpiry(), kTpNowBase + std::chrono::seconds{1});
+
+  b.cancel();
+  ASSERT_EQ(*manager.nextExpiry(), kTpNowBase + std::chrono::seconds{2});
+
+  manager.run(kTpNowBase + std::chrono::seconds{3});
+  ASSERT_FALSE(manager.nextExpiry());
+}
+
 }  // namespace unet
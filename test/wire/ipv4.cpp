@@ -3,6 +3,7 @@
 
 #include <boost/format.hpp>
 
+#include <unet/detail/check.hpp>
 #include <unet/exception.hpp>
 #include <unet/wire/ipv4.hpp>
 
@@ -65,4 +66,24 @@ TEST(Ipv4Test, PackedHeader) {
                                 0x0A, 0xFF, 0xFF, 0x65));
 }
 
+TEST(Ipv4Test, PseudoChecksum) {
+  Ipv4Header ipv4{};
+  ipv4.proto = ipv4_proto::kTcp;
+  ipv4.srcAddr = Ipv4Addr{10, 255, 255, 102};
+  ipv4.dstAddr = Ipv4Addr{10, 255, 255, 101};
+
+  // A checksum summed from the pseudo header sum over the transport payload
+  // should match one summed over the pseudo header and payload.
+  std::array<std::uint8_t, 12 + 5> full{
+      10, 255, 255, 102, 10, 255, 255, 101, 0, 6, 0, 5,  // Pseudo header
+      0x12, 0x34, 0, 0, 0x56};
+  auto expected = detail::checksum(full.data(), full.size());
+
+  std::array<std::uint8_t, 5> transport{0x12, 0x34, 0, 0, 0x56};
+  auto pseudo = pseudoChecksumIpv4(&ipv4, transport.size());
+  std::memcpy(&transport[2], &pseudo, sizeof(pseudo));
+
+  ASSERT_EQ(detail::checksum(transport.data(), transport.size()), expected);
+}
+
 }  // namespace unet